@@ -0,0 +1,75 @@
+#ifndef BENCHMARK_CHECKS_H
+#define BENCHMARK_CHECKS_H
+
+#include <iostream>
+#include <string>
+#include <Eigen/Core>
+#include <directional/TriMesh.h>
+#include <directional/ProfileReport.h>
+#include <directional/angle_bound_frame_fields.h>
+#include <directional/harmonic_basis.h>
+
+/***
+ Correctness checks of the accelerated paths, run by benchmark_bin --check on every mesh (and registered with CTest).
+ Every check prints its result and returns whether it passed.
+***/
+
+void report_check(const std::string& name, const bool passed, const std::string& details)
+{
+  std::cout<<(passed ? "[PASS] " : "[FAIL] ")<<name<<": "<<details<<std::endl;
+}
+
+//Repeated angle-bound solves with the same constraints and a reused state analyze the pattern of each global system once,
+//and give the same fields as independent solves.
+bool check_angle_bound_state_reuse(const directional::TriMesh& mesh)
+{
+  const int numSolves=3;
+  igl::AngleBoundFFSolverData<Eigen::MatrixXd, Eigen::MatrixXi> data(mesh.V, mesh.F);
+  igl::AngleBoundFFSolverState<Eigen::MatrixXd, Eigen::MatrixXi> state;
+  directional::ProfileReport report;
+  Eigen::VectorXi isConstrained=Eigen::VectorXi::Zero(mesh.F.rows());
+  isConstrained(0)=isConstrained(mesh.F.rows()/2)=1;
+
+  double maxDiff=0.0;
+  for (int i=0;i<numSolves;i++){
+    //a different (fixed) frame in every solve, with the same constrained faces
+    double angle=0.3+0.2*i;
+    Eigen::MatrixXd initialSolution(mesh.F.rows(),6), stateOutput, freshOutput;
+    initialSolution<<mesh.FBx, std::cos(angle)*mesh.FBx+std::sin(angle)*mesh.FBy;
+    igl::angle_bound_frame_fields(data, state, 20.0, isConstrained, initialSolution, stateOutput, 20, 100.0, 1.5, true, NULL, 1e-6, false, &report);
+    igl::angle_bound_frame_fields(data, 20.0, isConstrained, initialSolution, freshOutput, 20, 100.0, 1.5, true);
+    maxDiff=std::max(maxDiff, (stateOutput-freshOutput).cwiseAbs().maxCoeff());
+  }
+
+  long long analyses=report.counters["diagonal_shift_solver.pattern_analyses"];
+  bool passed=(analyses==2)&&(maxDiff<1e-8);
+  report_check("angle-bound state reuse", passed, std::to_string(analyses)+" pattern analyses in "+std::to_string(numSolves)+" solves (2 expected), max difference "+std::to_string(maxDiff));
+  return passed;
+}
+
+//Every harmonic basis field (handle and boundary generators alike) is curl-free on the inner edges and divergence-free on all vertices.
+bool check_harmonic_basis(const directional::TriMesh& mesh)
+{
+  std::vector<Eigen::MatrixXd> harmFields;
+  directional::harmonic_basis(mesh.V, mesh.F, mesh.EV, mesh.FE, mesh.EF, harmFields);
+  Eigen::SparseMatrix<double> Gv, Ge, J, C, D;
+  directional::FEM_suite(mesh, Gv, Ge, J, C, D);
+
+  double maxCurl=0.0, maxDiv=0.0;
+  for (int i=0;i<harmFields.size();i++){
+    Eigen::VectorXd harmFieldVec(3*mesh.F.rows());
+    for (int f=0;f<mesh.F.rows();f++)
+      harmFieldVec.segment(3*f,3)=harmFields[i].row(f).transpose();
+    Eigen::VectorXd curl=C*harmFieldVec;
+    for (int e=0;e<mesh.EV.rows();e++)
+      if ((mesh.EF(e,0)!=-1)&&(mesh.EF(e,1)!=-1))
+        maxCurl=std::max(maxCurl, std::abs(curl(e)));
+    maxDiv=std::max(maxDiv, (D*harmFieldVec).lpNorm<Eigen::Infinity>());
+  }
+
+  bool passed=(maxCurl<1e-8)&&(maxDiv<1e-8);
+  report_check("harmonic basis", passed, std::to_string(harmFields.size())+" fields, max inner-edge curl "+std::to_string(maxCurl)+", max divergence "+std::to_string(maxDiv));
+  return passed;
+}
+
+#endif
@@ -0,0 +1,412 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <igl/readOFF.h>
+#include <igl/readOBJ.h>
+#include <igl/upsample.h>
+#include <igl/default_num_threads.h>
+#include <directional/TriMesh.h>
+#include <directional/IntrinsicFaceTangentBundle.h>
+#include <directional/CartesianField.h>
+#include <directional/power_field.h>
+#include <directional/power_to_raw.h>
+#include <directional/polyvector_field.h>
+#include <directional/polyvector_to_raw.h>
+#include <directional/principal_matching.h>
+#include <directional/combing.h>
+#include <directional/curl_matching.h>
+#include <directional/polycurl_reduction.h>
+#include <directional/setup_integration.h>
+#include <directional/integrate.h>
+#include <directional/ProfileReport.h>
+#include "checks.h"
+#ifdef BENCHMARK_MESHING
+#include <directional/setup_mesh_function_isolines.h>
+#include <directional/mesh_function_isolines.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#include <mach/mach.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+/***
+ Headless benchmark of the core field algorithms: power fields, PolyVectors, principal matching, combing, curl reduction,
+ seamless integration and meshing. Every mesh is optionally subdivided to produce large synthetic inputs, and every run is
+ repeated for each requested thread count. Reports the time and the change in resident memory of each stage, and the process
+ memory high-water mark of each run (the high-water mark never decreases, so it is only meaningful for the whole process).
+
+ igl::default_num_threads() only takes its argument on its first call in a process, so a list
+ of thread counts is run by re-executing the benchmark once per count with a single --threads value, and merging the results.
+
+ --check runs the correctness checks of checks.h on the meshes instead, and fails if any of them fails.
+
+ Usage: benchmark_bin [--mesh file]... [--subdivide k] [--threads 1,2,4] [--no-integration] [--no-meshing] [--json file] [--trace prefix] [--check]
+***/
+
+struct StageResult{
+  std::string name;
+  double milliseconds;
+  double residentDeltaMB;  //the change in resident memory over the stage (negative if it freed more than it kept)
+};
+
+struct RunResult{
+  std::string meshName;
+  int numFaces;
+  int numThreads;
+  std::vector<StageResult> stages;
+  double peakMB;  //the process memory high-water mark at the end of the run, which includes all earlier runs
+  directional::ProfileReport report;
+};
+
+//Current resident memory of the process in megabytes
+double resident_memory_mb()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS pmc;
+  GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+  return (double)pmc.WorkingSetSize/(1024.0*1024.0);
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count)!=KERN_SUCCESS)
+    return 0.0;
+  return (double)info.resident_size/(1024.0*1024.0);
+#else
+  long pages=0, residentPages=0;
+  std::ifstream statm("/proc/self/statm");
+  statm>>pages>>residentPages;
+  return (double)residentPages*(double)sysconf(_SC_PAGESIZE)/(1024.0*1024.0);
+#endif
+}
+
+//Process memory high-water mark in megabytes
+double peak_memory_mb()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS pmc;
+  GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+  return (double)pmc.PeakWorkingSetSize/(1024.0*1024.0);
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return (double)usage.ru_maxrss/(1024.0*1024.0);  //bytes
+#else
+  return (double)usage.ru_maxrss/1024.0;  //kilobytes
+#endif
+#endif
+}
+
+//Times a single stage into both the run result and its report
+class Stage{
+public:
+  Stage(RunResult& _run, const char* _name):run(_run), name(_name), start(_run.report.now()), startResidentMB(resident_memory_mb()), timer(&_run.report, _name){}
+  ~Stage(){
+    StageResult result;
+    result.name=name;
+    result.milliseconds=(run.report.now()-start)/1000.0;
+    result.residentDeltaMB=resident_memory_mb()-startResidentMB;
+    run.stages.push_back(result);
+    std::cout<<std::left<<std::setw(24)<<name<<std::right<<std::setw(14)<<std::fixed<<std::setprecision(2)<<result.milliseconds<<" ms"<<std::setw(14)<<std::showpos<<result.residentDeltaMB<<std::noshowpos<<" MB resident"<<std::endl;
+  }
+private:
+  RunResult& run;
+  const char* name;
+  double start;
+  double startResidentMB;
+  directional::ScopedTimer timer;
+};
+
+bool load_mesh(const std::string& fileName, const int subdivisionLevels, Eigen::MatrixXd& V, Eigen::MatrixXi& F)
+{
+  std::string extension = fileName.substr(fileName.find_last_of('.')+1);
+  bool success = (extension=="obj" ? igl::readOBJ(fileName, V, F) : igl::readOFF(fileName, V, F));
+  if (!success)
+    return false;
+  for (int i=0;i<subdivisionLevels;i++){
+    Eigen::MatrixXd VFine;
+    Eigen::MatrixXi FFine;
+    igl::upsample(V, F, VFine, FFine);
+    V=VFine;
+    F=FFine;
+  }
+  return true;
+}
+
+void run_benchmark(const Eigen::MatrixXd& V,
+                   const Eigen::MatrixXi& F,
+                   const bool doIntegration,
+                   const bool doMeshing,
+                   RunResult& run)
+{
+  const int N=4;
+  directional::TriMesh mesh;
+  directional::IntrinsicFaceTangentBundle ftb;
+  {
+    Stage stage(run, "mesh setup");
+    mesh.set_mesh(V, F);
+    ftb.init(mesh);
+  }
+
+  //a single constraint on the first face, aligned with its first edge
+  Eigen::VectorXi constFaces(1); constFaces<<0;
+  Eigen::MatrixXd constVectors(1,3); constVectors<<(mesh.V.row(mesh.F(0,1))-mesh.V.row(mesh.F(0,0))).normalized();
+
+  directional::CartesianField powerField, powerRawField;
+  {
+    Stage stage(run, "power field");
+    directional::power_field(ftb, constFaces, constVectors, Eigen::VectorXd::Constant(1,-1.0), N, powerField);
+    directional::power_to_raw(powerField, N, powerRawField, true);
+  }
+
+  directional::CartesianField pvField, rawField, combedField;
+  {
+    Stage stage(run, "polyvector field");
+    directional::polyvector_field(ftb, constFaces, constVectors, N, pvField, &run.report);
+    directional::polyvector_to_raw(pvField, rawField, true);
+  }
+
+  {
+    Stage stage(run, "principal matching");
+    directional::principal_matching(rawField, &run.report);
+  }
+
+  {
+    Stage stage(run, "combing");
+    directional::combing(rawField, combedField, Eigen::MatrixXi(), &run.report);
+  }
+
+  directional::CartesianField curlFreeField = rawField;
+  {
+    Stage stage(run, "curl reduction");
+    Eigen::VectorXi b(1); b<<0;
+    Eigen::MatrixXd bc(1,6); bc<<rawField.extField.row(0).head(6);
+    Eigen::VectorXi blevel(1); blevel<<1;
+    directional::PolyCurlReductionSolverData pcrData;
+    directional::polycurl_reduction_parameters params;
+    directional::polycurl_reduction_precompute(mesh, b, bc, blevel, rawField, pcrData);
+    directional::polycurl_reduction_solve(pcrData, params, curlFreeField, true);
+    Eigen::VectorXd curlNorm;
+    directional::curl_matching(curlFreeField, curlNorm);
+  }
+
+  if (!doIntegration)
+    return;
+
+  directional::IntegrationData intData(N);
+  directional::TriMesh meshCut;
+  directional::CartesianField combedCurlFreeField;
+  Eigen::MatrixXd NFunction, NCornerFunctions;
+  {
+    Stage stage(run, "seamless integration");
+    directional::setup_integration(curlFreeField, intData, meshCut, combedCurlFreeField, &run.report);
+    intData.integralSeamless=doMeshing;
+    intData.roundSeams=false;
+    directional::integrate(combedCurlFreeField, intData, meshCut, NFunction, NCornerFunctions, &run.report);
+  }
+
+#ifdef BENCHMARK_MESHING
+  if (!doMeshing)
+    return;
+
+  {
+    Stage stage(run, "meshing");
+    directional::MeshFunctionIsolinesData mfiData;
+    directional::setup_mesh_function_isolines(meshCut, intData, mfiData);
+    Eigen::MatrixXd VPoly;
+    Eigen::VectorXi DPoly;
+    Eigen::MatrixXi FPoly;
+    directional::mesh_function_isolines(mesh, mfiData, false, VPoly, DPoly, FPoly, &run.report);
+  }
+#endif
+}
+
+std::string to_json(const std::vector<RunResult>& runs)
+{
+  std::ostringstream out;
+  out<<"[";
+  for (int i=0;i<runs.size();i++){
+    out<<(i==0 ? "" : ",")<<"{\"mesh\":\""<<runs[i].meshName<<"\",\"faces\":"<<runs[i].numFaces<<",\"threads\":"<<runs[i].numThreads<<",\"peakMB\":"<<runs[i].peakMB<<",\"stages\":[";
+    for (int j=0;j<runs[i].stages.size();j++)
+      out<<(j==0 ? "" : ",")<<"{\"name\":\""<<runs[i].stages[j].name<<"\",\"ms\":"<<runs[i].stages[j].milliseconds<<",\"residentDeltaMB\":"<<runs[i].stages[j].residentDeltaMB<<"}";
+    out<<"],\"report\":"<<runs[i].report.to_json()<<"}";
+  }
+  out<<"]";
+  return out.str();
+}
+
+//Quoting an argument for the shell when re-executing the benchmark
+std::string quote_argument(const std::string& arg)
+{
+#if defined(_WIN32)
+  return "\""+arg+"\"";
+#else
+  std::string quoted="'";
+  for (int i=0;i<arg.size();i++)
+    quoted+=(arg[i]=='\'' ? std::string("'\\''") : std::string(1,arg[i]));
+  return quoted+"'";
+#endif
+}
+
+//Runs every thread count in its own process, and merges their JSON results (the runs of one process are a JSON array).
+int run_thread_counts(const std::string& executable,
+                      const std::vector<std::string>& passedArgs,
+                      const std::vector<int>& threadCounts,
+                      const std::string& jsonFile)
+{
+  std::string mergedRuns;
+  for (int j=0;j<threadCounts.size();j++){
+    std::string partFile=(jsonFile.empty() ? std::string("benchmark") : jsonFile)+".threads-"+std::to_string(threadCounts[j])+".json";
+    std::string command=quote_argument(executable);
+    for (int i=0;i<passedArgs.size();i++)
+      command+=" "+quote_argument(passedArgs[i]);
+    command+=" --threads "+std::to_string(threadCounts[j])+" --json "+quote_argument(partFile);
+#if defined(_WIN32)
+    command="\""+command+"\"";  //cmd.exe strips the outer quotes
+#endif
+    if (std::system(command.c_str())!=0){
+      std::cout<<"Run with "<<threadCounts[j]<<" threads failed"<<std::endl;
+      return 1;
+    }
+
+    std::ifstream part(partFile);
+    std::stringstream partRuns;
+    partRuns<<part.rdbuf();
+    part.close();
+    std::remove(partFile.c_str());
+    std::string runs=partRuns.str();
+    if (runs.size()>2)  //stripping the array brackets
+      mergedRuns+=(mergedRuns.empty() ? "" : ",")+runs.substr(1, runs.size()-2);
+  }
+
+  if (!jsonFile.empty()){
+    std::ofstream f(jsonFile);
+    f<<"["<<mergedRuns<<"]";
+  }
+  return 0;
+}
+
+//Runs the correctness checks on every mesh, and returns nonzero if any of them failed
+int run_checks(const std::vector<std::string>& meshFiles, const int subdivisionLevels)
+{
+  bool passed=true;
+  for (int i=0;i<meshFiles.size();i++){
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    if (!load_mesh(meshFiles[i], subdivisionLevels, V, F)){
+      std::cout<<"Could not load "<<meshFiles[i]<<std::endl;
+      passed=false;
+      continue;
+    }
+    std::cout<<"=== "<<meshFiles[i].substr(meshFiles[i].find_last_of("/\\")+1)<<" (#F="<<F.rows()<<") ==="<<std::endl;
+    directional::TriMesh mesh;
+    mesh.set_mesh(V, F);
+    passed=check_angle_bound_state_reuse(mesh) && passed;
+    passed=check_harmonic_basis(mesh) && passed;
+  }
+  return (passed ? 0 : 1);
+}
+
+int main(int argc, char *argv[])
+{
+  std::vector<std::string> meshFiles;
+  std::vector<std::string> passedArgs;  //all arguments but --threads and --json, for re-executing
+  std::vector<int> threadCounts;
+  int subdivisionLevels=0;
+  bool doIntegration=true;
+  bool doMeshing=true;
+  bool doChecks=false;
+  std::string jsonFile, tracePrefix;
+
+  for (int i=1;i<argc;i++){
+    std::string arg=argv[i];
+    if ((arg=="--mesh")&&(i+1<argc)){
+      meshFiles.push_back(argv[++i]);
+      passedArgs.push_back(arg);
+      passedArgs.push_back(argv[i]);
+    } else if ((arg=="--subdivide")&&(i+1<argc)){
+      subdivisionLevels=std::stoi(argv[++i]);
+      passedArgs.push_back(arg);
+      passedArgs.push_back(argv[i]);
+    } else if ((arg=="--threads")&&(i+1<argc)){
+      std::stringstream list(argv[++i]);
+      std::string count;
+      while (std::getline(list, count, ','))
+        threadCounts.push_back(std::stoi(count));
+    } else if (arg=="--no-integration"){
+      doIntegration=false;
+      passedArgs.push_back(arg);
+    } else if (arg=="--no-meshing"){
+      doMeshing=false;
+      passedArgs.push_back(arg);
+    } else if ((arg=="--json")&&(i+1<argc))
+      jsonFile=argv[++i];
+    else if ((arg=="--trace")&&(i+1<argc)){
+      tracePrefix=argv[++i];
+      passedArgs.push_back(arg);
+      passedArgs.push_back(argv[i]);
+    } else if (arg=="--check")
+      doChecks=true;
+    else {
+      std::cout<<"Usage: "<<argv[0]<<" [--mesh file]... [--subdivide k] [--threads 1,2,4] [--no-integration] [--no-meshing] [--json file] [--trace prefix] [--check]"<<std::endl;
+      return 1;
+    }
+  }
+
+  if (meshFiles.empty()){
+    meshFiles.push_back(TUTORIAL_SHARED_PATH "/bumpy.off");
+    meshFiles.push_back(TUTORIAL_SHARED_PATH "/horsers.off");
+    meshFiles.push_back(TUTORIAL_SHARED_PATH "/cheburashka.off");
+    meshFiles.push_back(TUTORIAL_SHARED_PATH "/fertility.off");
+  }
+  if (doChecks)
+    return run_checks(meshFiles, subdivisionLevels);
+  if (threadCounts.size()>1)
+    return run_thread_counts(argv[0], passedArgs, threadCounts, jsonFile);
+
+  //this must be the first call to igl::default_num_threads() in the process, for the count to take effect
+  int numThreads=(threadCounts.empty() ? igl::default_num_threads() : igl::default_num_threads(threadCounts[0]));
+  Eigen::setNbThreads(numThreads);
+
+  std::vector<RunResult> runs;
+  for (int i=0;i<meshFiles.size();i++){
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    if (!load_mesh(meshFiles[i], subdivisionLevels, V, F)){
+      std::cout<<"Could not load "<<meshFiles[i]<<std::endl;
+      continue;
+    }
+    RunResult run;
+    run.meshName=meshFiles[i].substr(meshFiles[i].find_last_of("/\\")+1);
+    run.numFaces=F.rows();
+    run.numThreads=numThreads;
+    std::cout<<"=== "<<run.meshName<<" (#F="<<run.numFaces<<", "<<run.numThreads<<" threads) ==="<<std::endl;
+    run_benchmark(V, F, doIntegration, doMeshing, run);
+    run.peakMB=peak_memory_mb();
+    std::cout<<std::left<<std::setw(24)<<"process peak"<<std::right<<std::setw(31)<<std::fixed<<std::setprecision(2)<<run.peakMB<<" MB (high-water mark of the process so far)"<<std::endl;
+
+    if (!tracePrefix.empty())
+      run.report.write_chrome_trace(tracePrefix+"-"+run.meshName+"-"+std::to_string(run.numThreads)+".json");
+    runs.push_back(run);
+  }
+
+  if (!jsonFile.empty()){
+    std::ofstream f(jsonFile);
+    f<<to_json(runs);
+  }
+
+  return 0;
+}
@@ -90,6 +90,100 @@ namespace directional{
         }
     };
 
+
+    /***
+     A float-storage cartesian field, for visualization and post-processing of very large fields, where the solve is done in double
+     but the vectors do not need the precision. It holds the same data as CartesianField with the vectors in half the memory, and is
+     converted to and from it by set_field() and get_field(). The efforts are kept in double, as they determine the integer indices.
+     ***/
+    class FloatCartesianField{
+    public:
+
+        const TangentBundle* tb;            //Referencing the tangent bundle on which the field is defined
+
+        int N;                              //Degree of field (how many vectors are in each point);
+        fieldTypeEnum fieldType;            //The representation of the field (for instance, either a raw field or a power/polyvector field)
+
+        Eigen::MatrixXf intField;           //Intrinsic representation (depending on the local basis of the face). Size #T x 2N
+        Eigen::MatrixXf extField;           //Ambient coordinates. Size Size #T x 3N
+
+        Eigen::VectorXi matching;           //As in CartesianField
+        Eigen::VectorXd effort;
+        Eigen::VectorXi singLocalCycles;
+        Eigen::VectorXi singIndices;
+
+        FloatCartesianField(){}
+        FloatCartesianField(const TangentBundle& _tb):tb(&_tb){}
+        ~FloatCartesianField(){}
+
+        void IGL_INLINE init(const TangentBundle& _tb, const fieldTypeEnum _fieldType, const int _N){
+            tb = &_tb;
+            fieldType = _fieldType;
+            N=_N;
+            intField.resize(tb->sources.rows(),2*N);
+            extField.resize(tb->sources.rows(),3*N);
+        };
+
+        //Projecting the intrinsic field to the extrinsic one in blocks of tangent spaces, so that only a block is ever held in double.
+        void IGL_INLINE update_extrinsic_field(){
+            const int blockSize=65536;
+            extField.resize(intField.rows(), 3*intField.cols()/2);
+            for (int start=0;start<intField.rows();start+=blockSize){
+                int currSize=std::min(blockSize, (int)intField.rows()-start);
+                Eigen::VectorXi blockSpaces=Eigen::VectorXi::LinSpaced(currSize, start, start+currSize-1);
+                Eigen::MatrixXd blockIntField=intField.middleRows(start, currSize).cast<double>();
+                extField.middleRows(start, currSize)=tb->project_to_extrinsic(blockSpaces, blockIntField).cast<float>();
+            }
+        }
+
+        void IGL_INLINE set_intrinsic_field(const Eigen::MatrixXf& _intField){
+            intField = _intField;
+            update_extrinsic_field();
+        }
+
+        //The same, just with complex coordinates
+        void IGL_INLINE set_intrinsic_field(const Eigen::MatrixXcd& _intField){
+            intField.resize(_intField.rows(),_intField.cols()*2);
+            for (int i=0;i<_intField.cols();i++){
+                intField.col(2*i)=_intField.col(i).real().cast<float>();
+                intField.col(2*i+1)=_intField.col(i).imag().cast<float>();
+            }
+            update_extrinsic_field();
+        }
+
+        void IGL_INLINE set_singularities(const Eigen::VectorXi& _singLocalCycles,
+                                          const Eigen::VectorXi& _singIndices){
+            singLocalCycles = _singLocalCycles;
+            singIndices = _singIndices;
+        }
+
+        //Storing a (double) cartesian field
+        void IGL_INLINE set_field(const CartesianField& field){
+            tb = field.tb;
+            N = field.N;
+            fieldType = field.fieldType;
+            intField = field.intField.cast<float>();
+            extField = field.extField.cast<float>();
+            matching = field.matching;
+            effort = field.effort;
+            singLocalCycles = field.singLocalCycles;
+            singIndices = field.singIndices;
+        }
+
+        //Restoring a (double) cartesian field, for further processing
+        void IGL_INLINE get_field(CartesianField& field) const{
+            field.tb = tb;
+            field.N = N;
+            field.fieldType = fieldType;
+            field.intField = intField.cast<double>();
+            field.extField = extField.cast<double>();
+            field.matching = matching;
+            field.effort = effort;
+            field.singLocalCycles = singLocalCycles;
+            field.singIndices = singIndices;
+        }
+    };
+
 }
 
 
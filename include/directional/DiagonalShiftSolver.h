@@ -0,0 +1,179 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_DIAGONAL_SHIFT_SOLVER_H
+#define DIRECTIONAL_DIAGONAL_SHIFT_SOLVER_H
+
+#include <complex>
+#include <vector>
+#include <iostream>
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <directional/ProfileReport.h>
+
+namespace directional{
+
+    // Solves the family of complex quadratic problems of the global steps in the frame-field solvers:
+    //      min x^H (Q0+lambda*diag(w)) x + Re(f^H x), subject to x(known)=xknown,
+    // where only lambda and f change between solves. The reduced system -Quu is assembled with its full diagonal once,
+    // its sparsity pattern is analyzed once, and a change of lambda only rewrites the diagonal values and refactors numerically.
+    // Solving again with the same lambda reuses the factorization as is.
+    template <typename Scalar>
+    class DiagonalShiftSolver{
+    public:
+        typedef std::complex<Scalar> Complex;
+        typedef Eigen::Matrix<Complex, Eigen::Dynamic, 1> ComplexVector;
+
+        Eigen::VectorXi known, unknown;             //indices of the known and unknown variables
+        Eigen::VectorXi full2Unknown;               //index of each variable among the unknowns (-1 for known ones)
+
+        Eigen::SparseMatrix<Complex> negQuu;        //-(Q0+lambda*diag(w)) restricted to the unknowns, at the last factored lambda
+        std::vector<Complex> negQuuValues0;         //the values of -Q0 restricted to the unknowns (with explicit diagonal)
+        Eigen::VectorXi diagIndices;                //the position of each diagonal entry of negQuu in its value array
+        Eigen::Matrix<Scalar, Eigen::Dynamic, 1> wu;  //the diagonal weights of the unknowns
+        Eigen::SparseMatrix<Complex> Quk;           //Q0 restricted to the unknown rows and known columns
+        ComplexVector Qukxk;                        //Quk*xknown, constant for a given set of constraints
+        ComplexVector xknown;
+
+        Eigen::SparseLU<Eigen::SparseMatrix<Complex> > solver;
+        Scalar factoredLambda;
+        bool isFactored;
+
+        DiagonalShiftSolver():isFactored(false){}
+        ~DiagonalShiftSolver(){}
+
+        // Inputs:
+        //  Q0:             #x by #x the fixed part of the quadratic form
+        //  w:              #x the diagonal weights multiplied by lambda
+        //  isConstrained:  #x 1 for variables fixed to xknown, 0 otherwise.
+        //  _xknown:        the values of the constrained variables, in the order of their indices.
+        IGL_INLINE void setup(const Eigen::SparseMatrix<Complex>& Q0,
+                              const Eigen::Matrix<Scalar, Eigen::Dynamic, 1>& w,
+                              const Eigen::VectorXi& isConstrained,
+                              const ComplexVector& _xknown,
+                              directional::ProfileReport* report=NULL)
+        {
+            directional::ScopedTimer timer(report, "diagonal_shift_solver.setup");
+            int n=Q0.rows();
+            xknown=_xknown;
+            int numKnown=isConstrained.sum();
+            known.resize(numKnown);
+            unknown.resize(n-numKnown);
+            full2Unknown=Eigen::VectorXi::Constant(n,-1);
+            Eigen::VectorXi full2Known=Eigen::VectorXi::Constant(n,-1);
+            int indk=0, indu=0;
+            for (int i=0;i<n;i++){
+                if (isConstrained(i)){
+                    full2Known(i)=indk;
+                    known(indk++)=i;
+                } else {
+                    full2Unknown(i)=indu;
+                    unknown(indu++)=i;
+                }
+            }
+
+            //slicing, with an explicit (possibly zero) diagonal so that the pattern does not depend on lambda
+            std::vector<Eigen::Triplet<Complex> > QuuTris, QukTris;
+            for (int i=0;i<unknown.size();i++)
+                QuuTris.push_back(Eigen::Triplet<Complex>(i,i,Complex(0.0)));
+            for (int k=0;k<Q0.outerSize();k++){
+                for (typename Eigen::SparseMatrix<Complex>::InnerIterator it(Q0,k);it;++it){
+                    if (full2Unknown(it.row())<0)
+                        continue;
+                    if (full2Unknown(it.col())>=0)
+                        QuuTris.push_back(Eigen::Triplet<Complex>(full2Unknown(it.row()), full2Unknown(it.col()), -it.value()));
+                    else
+                        QukTris.push_back(Eigen::Triplet<Complex>(full2Unknown(it.row()), full2Known(it.col()), it.value()));
+                }
+            }
+
+            negQuu.resize(unknown.size(), unknown.size());
+            negQuu.setFromTriplets(QuuTris.begin(), QuuTris.end());
+            negQuu.makeCompressed();
+            negQuuValues0.assign(negQuu.valuePtr(), negQuu.valuePtr()+negQuu.nonZeros());
+
+            diagIndices.resize(unknown.size());
+            for (int k=0;k<negQuu.outerSize();k++)
+                for (int i=negQuu.outerIndexPtr()[k];i<negQuu.outerIndexPtr()[k+1];i++)
+                    if (negQuu.innerIndexPtr()[i]==k)
+                        diagIndices(k)=i;
+
+            wu.resize(unknown.size());
+            for (int i=0;i<unknown.size();i++)
+                wu(i)=w(unknown(i));
+
+            Quk.resize(unknown.size(), known.size());
+            Quk.setFromTriplets(QukTris.begin(), QukTris.end());
+            Qukxk=Quk*xknown;
+
+            isFactored=false;
+            if (unknown.size()==0)
+                return;
+            solver.analyzePattern(negQuu);
+            if (report)
+                report->add_counter("diagonal_shift_solver.pattern_analyses");
+        }
+
+        // Replaces the values of the constrained variables, keeping the same constrained set, pattern, and factorization.
+        IGL_INLINE void set_known_values(const ComplexVector& _xknown)
+        {
+            xknown=_xknown;
+            Qukxk=Quk*xknown;
+        }
+
+        // Solves for a given lambda and linear term f (of size #x), and returns the full solution x (with the known values in place).
+        // Returns false if the factorization or the solve failed, in which case the unknown values of x are not set.
+        IGL_INLINE bool solve(const Scalar lambda,
+                              const ComplexVector& f,
+                              ComplexVector& x,
+                              directional::ProfileReport* report=NULL)
+        {
+            x.resize(full2Unknown.size());
+            for (int i=0;i<known.size();i++)
+                x(known(i))=xknown(i);
+            if (unknown.size()==0)
+                return true;
+
+            if ((!isFactored)||(lambda!=factoredLambda)){
+                directional::ScopedTimer timer(report, "diagonal_shift_solver.factorize");
+                Complex* values=negQuu.valuePtr();
+                for (int i=0;i<negQuuValues0.size();i++)
+                    values[i]=negQuuValues0[i];
+                for (int i=0;i<diagIndices.size();i++)
+                    values[diagIndices(i)]-=lambda*wu(i);
+
+                solver.factorize(negQuu);
+                if (report)
+                    report->add_counter("diagonal_shift_solver.factorizations");
+                if(solver.info()!=Eigen::Success){
+                    std::cerr<<"Decomposition failed!"<<std::endl;
+                    isFactored=false;
+                    return false;
+                }
+                isFactored=true;
+                factoredLambda=lambda;
+            }
+
+            ComplexVector rhs(unknown.size());
+            for (int i=0;i<unknown.size();i++)
+                rhs(i)=Qukxk(i)+0.5*f(unknown(i));
+
+            ComplexVector xu = solver.solve(rhs);
+            if(solver.info()!=Eigen::Success){
+                std::cerr<<"Solving failed!"<<std::endl;
+                return false;
+            }
+
+            for (int i=0;i<unknown.size();i++)
+                x(unknown(i))=xu(i);
+            return true;
+        }
+    };
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include <igl/edge_topology.h>
 #include <igl/doublearea.h>
 #include <igl/massmatrix.h>
+#include <directional/TriMesh.h>
 
 
 namespace directional
@@ -30,6 +31,7 @@ namespace directional
   //  EV:         #E x 2 edges to vertices indices
   //  EF:         #E x 2 edges to faces indices
   //  FE:         #F x 3 faces to edges indices
+  //  faceDoubleAreas:  #F twice the face areas (see face_geometry())
   // Output:
   //  MvVec:    #V the Voronoi areas of each vertex
   //  MeVec:    #E the diamond areas of each edge
@@ -41,6 +43,7 @@ namespace directional
                              const Eigen::MatrixXi& EV,
                              const Eigen::MatrixXi& FE,
                              const Eigen::MatrixXi& EF,
+                             const Eigen::VectorXd& faceDoubleAreas,
                              Eigen::VectorXd& MvVec,
                              Eigen::VectorXd& MeVec,
                              Eigen::VectorXd& MfVec,
@@ -50,10 +53,7 @@ namespace directional
     using namespace Eigen;
     using namespace std;
     
-    VectorXd dblA;
-    igl::doublearea(V,F,dblA);
-    
-    MfVec = dblA*0.5;
+    MfVec = faceDoubleAreas*0.5;
     MchiVec.conservativeResize(F.rows()*3);
     MvVec=VectorXd::Zero(V.rows());
     MeVec=VectorXd::Zero(EV.rows());
@@ -65,6 +65,32 @@ namespace directional
       }
     }
   }
+  
+  // The same, computing the face areas.
+  IGL_INLINE void FEM_masses(const Eigen::MatrixXd& V,
+                             const Eigen::MatrixXi& F,
+                             const Eigen::MatrixXi& EV,
+                             const Eigen::MatrixXi& FE,
+                             const Eigen::MatrixXi& EF,
+                             Eigen::VectorXd& MvVec,
+                             Eigen::VectorXd& MeVec,
+                             Eigen::VectorXd& MfVec,
+                             Eigen::VectorXd& MchiVec)
+  {
+    Eigen::VectorXd dblA;
+    igl::doublearea(V,F,dblA);
+    FEM_masses(V, F, EV, FE, EF, dblA, MvVec, MeVec, MfVec, MchiVec);
+  }
+  
+  // The same, with the topology and face areas already stored in the mesh.
+  IGL_INLINE void FEM_masses(const directional::TriMesh& mesh,
+                             Eigen::VectorXd& MvVec,
+                             Eigen::VectorXd& MeVec,
+                             Eigen::VectorXd& MfVec,
+                             Eigen::VectorXd& MchiVec)
+  {
+    FEM_masses(mesh.V, mesh.F, mesh.EV, mesh.FE, mesh.EF, mesh.faceDoubleAreas, MvVec, MeVec, MfVec, MchiVec);
+  }
 }
 
 #endif
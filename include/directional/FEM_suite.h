@@ -16,7 +16,9 @@
 #include <igl/local_basis.h>
 #include <igl/edge_topology.h>
 #include <directional/FEM_masses.h>
-#include <igl/per_face_normals.h>
+#include <igl/parallel_for.h>
+#include <directional/face_geometry.h>
+#include <directional/TriMesh.h>
 
 
 namespace directional
@@ -30,6 +32,7 @@ namespace directional
   //  EV:         #E x 2 edges to vertices indices
   //  EF:         #E x 2 edges to faces indices
   //  FE:         #F x 3 faces to edges indices
+  //  faceEdgeVectors, faceDoubleAreas:  the per-face edge vectors and double areas (see face_geometry())
   // Output:
   //  Gv:    #3f x V Conforming gradient matrix, returning vector of xyzxyz per face gradient vectors
   //  Ge:    #3f x V Non-conforming gradient of the same style, but for mid-edge functions
@@ -42,6 +45,8 @@ namespace directional
                             const Eigen::MatrixXi& EV,
                             const Eigen::MatrixXi& FE,
                             const Eigen::MatrixXi& EF,
+                            const Eigen::MatrixXd& faceEdgeVectors,
+                            const Eigen::VectorXd& faceDoubleAreas,
                             Eigen::SparseMatrix<double>& Gv,
                             Eigen::SparseMatrix<double>& Ge,
                             Eigen::SparseMatrix<double>& J,
@@ -52,20 +57,19 @@ namespace directional
     using namespace Eigen;
     using namespace std;
     
-    VectorXd dblA;
-    igl::doublearea(V,F,dblA);
+    const VectorXd& dblA = faceDoubleAreas;
     SparseMatrix<double> Mchi;
     VectorXd MvVec, MeVec, MfVec, MchiVec;
-    directional::FEM_masses(V, F, EV, FE, EF, MvVec, MeVec, MfVec, MchiVec);
+    directional::FEM_masses(V, F, EV, FE, EF, dblA, MvVec, MeVec, MfVec, MchiVec);
     Mchi = MchiVec.asDiagonal();
-    Eigen::MatrixXd N;
-    igl::per_face_normals(V, F, N);
     
-    vector<Triplet<double> > GvTriplets, GeTriplets, JTriplets;
-    for (int i=0;i<F.rows();i++){
-      RowVector3d currNormal=N.row(i);
+    //every face writes its own fixed range of triplets, so the faces are independent
+    vector<Triplet<double> > GvTriplets(9*F.rows()), GeTriplets(9*F.rows()), JTriplets(6*F.rows());
+    igl::parallel_for(F.rows(), [&](const int i){
+      //the normal is from the first and (reversed) last edges
+      RowVector3d currNormal=faceEdgeVectors.block<1,3>(i,6).cross(faceEdgeVectors.block<1,3>(i,0))/dblA(i);
       for (int j=0;j<3;j++){
-        RowVector3d eVec = V.row(F(i,(j+1)%3))-V.row(F(i,j));
+        RowVector3d eVec = faceEdgeVectors.block(i,3*j,1,3);
         RowVector3d eVecRot = currNormal.cross(eVec);
         
         //TODO: I cannot count on FE(i,j) to be the correct edge, need to search for it
@@ -77,18 +81,18 @@ namespace directional
         }
         assert (currEdge!=-1 && "Something wrong with edge topology!");
         for (int k=0;k<3;k++){
-          GvTriplets.push_back(Triplet<double>(3*i+k,F(i,(j+2)%3),eVecRot(k)/dblA(i)));
-          GeTriplets.push_back(Triplet<double>(3*i+k,currEdge,-2*eVecRot(k)/dblA(i)));
+          GvTriplets[9*i+3*j+k]=Triplet<double>(3*i+k,F(i,(j+2)%3),eVecRot(k)/dblA(i));
+          GeTriplets[9*i+3*j+k]=Triplet<double>(3*i+k,currEdge,-2*eVecRot(k)/dblA(i));
         }
       }
       
-      JTriplets.push_back(Triplet<double>(3*i, 3*i+1, -N(i,2)));
-      JTriplets.push_back(Triplet<double>(3*i+1, 3*i, N(i,2)));
-      JTriplets.push_back(Triplet<double>(3*i, 3*i+2, N(i,1)));
-      JTriplets.push_back(Triplet<double>(3*i+2, 3*i, -N(i,1)));
-      JTriplets.push_back(Triplet<double>(3*i+1, 3*i+2, -N(i,0)));
-      JTriplets.push_back(Triplet<double>(3*i+2, 3*i+1, N(i,0)));
-    }
+      JTriplets[6*i]=Triplet<double>(3*i, 3*i+1, -currNormal(2));
+      JTriplets[6*i+1]=Triplet<double>(3*i+1, 3*i, currNormal(2));
+      JTriplets[6*i+2]=Triplet<double>(3*i, 3*i+2, currNormal(1));
+      JTriplets[6*i+3]=Triplet<double>(3*i+2, 3*i, -currNormal(1));
+      JTriplets[6*i+4]=Triplet<double>(3*i+1, 3*i+2, -currNormal(0));
+      JTriplets[6*i+5]=Triplet<double>(3*i+2, 3*i+1, currNormal(0));
+    }, 1000);
     
     Gv.resize(3*F.rows(), V.rows());
     Gv.setFromTriplets(GvTriplets.begin(), GvTriplets.end());
@@ -100,6 +104,35 @@ namespace directional
     C = (J*Ge).transpose()*Mchi;
     D = Gv.transpose()*Mchi;
   }
+  
+  // The same, computing the face geometry.
+  IGL_INLINE void FEM_suite(const Eigen::MatrixXd& V,
+                            const Eigen::MatrixXi& F,
+                            const Eigen::MatrixXi& EV,
+                            const Eigen::MatrixXi& FE,
+                            const Eigen::MatrixXi& EF,
+                            Eigen::SparseMatrix<double>& Gv,
+                            Eigen::SparseMatrix<double>& Ge,
+                            Eigen::SparseMatrix<double>& J,
+                            Eigen::SparseMatrix<double>& C,
+                            Eigen::SparseMatrix<double>& D)
+  {
+    Eigen::MatrixXd faceEdgeVectors, cornerAngles, cornerCotangents;
+    Eigen::VectorXd faceDoubleAreas;
+    directional::face_geometry(V, F, faceEdgeVectors, faceDoubleAreas, cornerAngles, cornerCotangents);
+    FEM_suite(V, F, EV, FE, EF, faceEdgeVectors, faceDoubleAreas, Gv, Ge, J, C, D);
+  }
+  
+  // The same, with the topology and face geometry already stored in the mesh.
+  IGL_INLINE void FEM_suite(const directional::TriMesh& mesh,
+                            Eigen::SparseMatrix<double>& Gv,
+                            Eigen::SparseMatrix<double>& Ge,
+                            Eigen::SparseMatrix<double>& J,
+                            Eigen::SparseMatrix<double>& C,
+                            Eigen::SparseMatrix<double>& D)
+  {
+    FEM_suite(mesh.V, mesh.F, mesh.EV, mesh.FE, mesh.EF, mesh.faceEdgeVectors, mesh.faceDoubleAreas, Gv, Ge, J, C, D);
+  }
 }
 
 
@@ -12,7 +12,6 @@
 #include <Eigen/Geometry>
 #include <Eigen/Sparse>
 #include <igl/boundary_loop.h>
-#include <igl/doublearea.h>
 #include <directional/dual_cycles.h>
 #include <directional/TriMesh.h>
 #include <directional/TangentBundle.h>
@@ -72,8 +71,7 @@ namespace directional{
             /************masses****************/
 
             //mass are face areas
-            igl::doublearea(mesh->V,mesh->F,tangentSpaceMass);
-            tangentSpaceMass.array()/=2.0;
+            tangentSpaceMass = mesh->faceDoubleAreas/2.0;
 
             //The "harmonic" weights from [Brandt et al. 2020].
             connectionMass.resize(mesh->EF.rows());
@@ -12,8 +12,8 @@
 #include <Eigen/Geometry>
 #include <Eigen/Sparse>
 #include <igl/boundary_loop.h>
-#include <igl/doublearea.h>
-#include <directional/dual_cycles.h>
+#include <igl/parallel_for.h>
+#include <directional/primal_cycles.h>
 #include <directional/TriMesh.h>
 #include <directional/raw_to_polyvector.h>
 #include <directional/polyvector_to_raw.h>
@@ -31,7 +31,9 @@ namespace directional{
     public:
 
         const TriMesh* mesh;
-        Eigen::MatrixXd tangentStartAngles;  //where each edge begins on the intrinsic space
+        Eigen::VectorXi ringStart;           //the edges around vertex i occupy the slots ringStart(i)...ringStart(i+1)-1, in the order of mesh->VE
+        Eigen::VectorXd tangentStartAngles;  //where the edge of each slot begins on the intrinsic space
+        Eigen::MatrixXi edgeSlots;           //#E by 2 the slot of each edge around EV(i,0) and around EV(i,1)
 
         virtual discTangTypeEnum discTangType() const {return discTangTypeEnum::VERTEX_SPACES;}
         virtual bool hasCochainSequence() const { return false; }
@@ -43,7 +45,6 @@ namespace directional{
         void IGL_INLINE init(const TriMesh& _mesh){
 
             intDimension = 2;
-            typedef std::complex<double> Complex;
             mesh = &_mesh;
 
             //adjacency relation is by dual edges.
@@ -55,68 +56,58 @@ namespace directional{
             cycleSources = mesh->barycenters;
             cycleNormals = mesh->faceNormals;
 
-            //creating vertex tangent lookup table
-            tangentStartAngles.resize(mesh->V.rows(), mesh->vertexValence.maxCoeff());
-            for (int i=0;i<mesh->V.rows();i++){
+            //creating the vertex tangent lookup table in compressed rows, and the slot of every edge in the rings of its two vertices
+            ringStart.resize(mesh->V.rows()+1);
+            ringStart(0)=0;
+            for (int i=0;i<mesh->V.rows();i++)
+                ringStart(i+1)=ringStart(i)+mesh->vertexValence(i);
+            tangentStartAngles.resize(ringStart(mesh->V.rows()));
+            edgeSlots.resize(mesh->EV.rows(),2);
+
+            igl::parallel_for(mesh->V.rows(), [&](const int i){
                 double totalTangentSum = (mesh->isBoundaryVertex(i) ? igl::PI : 2.0*igl::PI);
                 double angleSum =  totalTangentSum - mesh->GaussianCurvature(i);
-                tangentStartAngles.col(0).setZero();  //the first angle
-                Eigen::RowVector3d prevEdgeVector = mesh->V.row(mesh->HV(mesh->nextH(mesh->VH(i))))-mesh->V.row(i);
-                int hebegin = mesh->VH(i);  //this should be the first boundary edge in case of boundary
-                int heiterate = mesh->twinH(mesh->prevH(hebegin));
-                int j=1;
-                do{
-                    Eigen::RowVector3d currEdgeVector = mesh->V.row(mesh->HV(mesh->nextH(heiterate)))-mesh->V.row(i);
-                    double angleDiff = std::acos(currEdgeVector.dot(prevEdgeVector)/(prevEdgeVector.norm()*currEdgeVector.norm()));
-                    tangentStartAngles(i,j)=tangentStartAngles(i,j-1)+totalTangentSum*angleDiff/angleSum;
-                    heiterate = mesh->twinH(mesh->prevH(heiterate));
-                    j++;
-                    prevEdgeVector=currEdgeVector;
-                }while ((heiterate!=hebegin)&&(heiterate!=-1));
-            }
+                for (int j=0;j<mesh->vertexValence(i);j++){
+                    int edge = mesh->VE(i,j);
+                    int side = (mesh->EV(edge,0)==i ? 0 : 1);
+                    edgeSlots(edge,side) = ringStart(i)+j;
+                    if (j==0)
+                        tangentStartAngles(ringStart(i))=0.0;  //the first angle
+                    else {
+                        //the face VF(i,j-1) is between the edges VE(i,j-1) and VE(i,j)
+                        int face = mesh->VF(i,j-1);
+                        int corner = (mesh->F(face,0)==i ? 0 : (mesh->F(face,1)==i ? 1 : 2));
+                        double angleDiff = mesh->cornerAngles(face,corner);
+                        tangentStartAngles(ringStart(i)+j)=tangentStartAngles(ringStart(i)+j-1)+totalTangentSum*angleDiff/angleSum;
+                    }
+                }
+            }, 1000);
 
             //connection is the ratio of the complex representation of mutual edges
             connection.resize(mesh->EV.rows(),1);  //the difference in the angle representation of edge i from EV(i,0) to EV(i,1)
-            Eigen::MatrixXd edgeVectors(mesh->EV.rows(), 3);
-            for (int i = 0; i < mesh->EV.rows(); i++) {
-                //edgeVectors.row(i) = (mesh->V.row(mesh->EV(i, 1)) - mesh->V.row(mesh->EV(i, 0))).normalized();
-                //looking up edge in each tangent space
-                Complex ef,eg;
-                for (int j=0;j<mesh->vertexValence(mesh->EV(i,0));j++){
-                    if (mesh->VE(mesh->EV(i,0),j)==i)
-                        ef = exp(Complex(0,tangentStartAngles(mesh->EV(i, 0),j)));
-                }
+            igl::parallel_for(mesh->EV.rows(), [&](const int i){
+                connection(i) = -std::polar(1.0, tangentStartAngles(edgeSlots(i,1))-tangentStartAngles(edgeSlots(i,0)));
+            }, 1000);
 
-                for (int j=0;j<mesh->vertexValence(mesh->EV(i,1));j++) {
-                  if (mesh->VE(mesh->EV(i, 1), j) == i)
-                      eg = exp(Complex(0, tangentStartAngles(mesh->EV(i, 1), j)));
-              }
+            //cycles are the faces, then the boundary loops, and then the generators.
+            directional::primal_cycles(*mesh, cycles, local2Cycle);
 
-              connection(i) = -eg / ef;
-            }
-
-            local2Cycle.resize(mesh->F.rows());
-            cycleCurvatures=Eigen::VectorXd::Zero(mesh->F.rows());
-            cycles.resize(mesh->F.rows(), mesh->EV.rows());  //TODO: higher genus and boundaries
-            innerAdjacencies.resize(mesh->EV.rows());
-            std::vector<Eigen::Triplet<double>> cyclesTriplets;
-            for (int i=0;i<mesh->F.rows();i++){
-                local2Cycle(i)=i;
+            //the curvature of each cycle is the holonomy of the connection along it
+            Eigen::SparseMatrix<double, Eigen::RowMajor> cycleRows = cycles;
+            cycleCurvatures.resize(cycles.rows());
+            igl::parallel_for(cycleRows.outerSize(), [&](const int i){
                 std::complex<double> complexHolonomy(1.0,0.0);
-                for (int j=0;j<3;j++){
-                    cyclesTriplets.push_back(Eigen::Triplet<double>(i,mesh->FE(i,j),mesh->FEs(i,j)));
-                    if (mesh->FEs(i,j)>0)
-                        complexHolonomy*=connection(mesh->FE(i,j));
+                for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(cycleRows,i); it; ++it){
+                    if (it.value()>0)
+                        complexHolonomy*=connection(it.col());
                     else
-                        complexHolonomy/=connection(mesh->FE(i,j));
+                        complexHolonomy/=connection(it.col());
                 }
                 cycleCurvatures(i)=arg(complexHolonomy);
-            }
-            cycles.setFromTriplets(cyclesTriplets.begin(), cyclesTriplets.end());
+            }, 1000);
 
-            for (int i=0;i<mesh->EV.rows();i++) //TODO: boundaries
-                innerAdjacencies(i)=i;
-            //directional::dual_cycles(mesh->V, mesh->F, mesh->EV, mesh->EF, dualCycles, cycleCurvatures, element2Cycle, innerAdjacencies);
+            //every edge (boundary edges included) connects two vertex tangent spaces
+            innerAdjacencies=Eigen::VectorXi::LinSpaced(mesh->EV.rows(), 0, mesh->EV.rows()-1);
 
             //drawing from mesh geometry
 
@@ -124,28 +115,20 @@ namespace directional{
             connectionMass.resize(mesh->EV.rows());
             tangentSpaceMass.resize(mesh->V.rows());
 
-            //cotangent weights
-            Eigen::MatrixXd faceCotWeights=Eigen::MatrixXd::Zero(mesh->F.rows(),3);
-            for (int i=0;i<mesh->F.rows();i++){
-                for (int j=0;j<3;j++){
-                    Eigen::RowVector3d vec12 = mesh->V.row(mesh->F(i,(j+1)%3))-mesh->V.row(mesh->F(i,j));
-                    Eigen::RowVector3d vec13 = mesh->V.row(mesh->F(i,(j+2)%3))-mesh->V.row(mesh->F(i,j));
-                    double cosAngle = vec12.dot(vec13);
-                    double sinAngle = (vec12.cross(vec13)).norm();
-                    if (std::abs(sinAngle)>10e-7) //otherwise defaulting to zero
-                        faceCotWeights(i,j) = cosAngle/sinAngle;
-
-                    connectionMass(mesh->FE(i,j))+=0.5*faceCotWeights(i,j);
-                }
-            }
-
-            //masses are vertex voronoi areas
-            Eigen::MatrixXd dAreas;
-            igl::doublearea(mesh->V,mesh->F,dAreas);
-            tangentSpaceMass = Eigen::VectorXd::Zero(mesh->V.rows());
-            for (int i=0;i<mesh->F.rows();i++)
-                for (int j=0;j<3;j++)
-                    tangentSpaceMass(mesh->F(i,j)) += dAreas(i)/6.0;
+            //cotangent weights, gathered per edge from the corners opposite to it in its (at most two) faces, so that the edges are independent
+            igl::parallel_for(mesh->EV.rows(), [&](const int i){
+                connectionMass(i)=0.0;
+                for (int k=0;k<2;k++)
+                    if (mesh->EF(i,k)!=-1)
+                        connectionMass(i)+=0.5*mesh->cornerCotangents(mesh->EF(i,k),(mesh->EFi(i,k)+2)%3);
+            }, 1000);
+
+            //masses are vertex voronoi areas, gathered from the faces around each vertex
+            igl::parallel_for(mesh->V.rows(), [&](const int i){
+                tangentSpaceMass(i)=0.0;
+                for (int j=0;j<mesh->vertexValence(i)-mesh->isBoundaryVertex(i);j++)
+                    tangentSpaceMass(i) += mesh->faceDoubleAreas(mesh->VF(i,j))/6.0;
+            }, 1000);
 
         }
 
@@ -0,0 +1,161 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_PROFILE_REPORT_H
+#define DIRECTIONAL_PROFILE_REPORT_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <igl/igl_inline.h>
+
+/***
+ Opt-in profiling of the field pipeline. The functions that support it take an optional ProfileReport pointer (NULL by default),
+ into which they write the timings of their scopes and counters (factorizations, solver iterations, rounding steps, etc.).
+ When the pointer is NULL nothing is measured. A report is meant for a single thread of calls; use one report per concurrent call.
+ The report can be exported as plain JSON, or as a Chrome trace (to be loaded in chrome://tracing or Perfetto).
+***/
+
+namespace directional{
+
+    class ProfileReport{
+    public:
+
+        struct Event{
+            std::string name;
+            double start;                           //Microseconds since the creation (or clearing) of the report
+            double duration;                        //Microseconds
+            int depth;                              //Nesting depth of the scope
+        };
+
+        std::vector<Event> events;                  //Timed scopes, in the order of their completion
+        std::map<std::string, long long> counters;  //Accumulated counters
+        int currDepth;                              //Depth of the currently open scopes
+        std::chrono::steady_clock::time_point origin;
+
+        ProfileReport():currDepth(0), origin(std::chrono::steady_clock::now()){}
+        ~ProfileReport(){}
+
+        IGL_INLINE void clear(){
+            events.clear();
+            counters.clear();
+            currDepth=0;
+            origin=std::chrono::steady_clock::now();
+        }
+
+        IGL_INLINE double now() const{
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-origin).count();
+        }
+
+        IGL_INLINE void add_counter(const std::string& name, const long long value=1){
+            counters[name]+=value;
+        }
+
+        //Total time (in microseconds) of all scopes with this name
+        IGL_INLINE double total_time(const std::string& name) const{
+            double total=0.0;
+            for (int i=0;i<events.size();i++)
+                if (events[i].name==name)
+                    total+=events[i].duration;
+            return total;
+        }
+
+        IGL_INLINE std::string to_json() const{
+            std::ostringstream out;
+            out<<"{\"events\":[";
+            for (int i=0;i<events.size();i++)
+                out<<(i==0 ? "" : ",")<<"{\"name\":\""<<escape(events[i].name)<<"\",\"start\":"<<events[i].start<<",\"duration\":"<<events[i].duration<<",\"depth\":"<<events[i].depth<<"}";
+            out<<"],\"counters\":{";
+            for (std::map<std::string, long long>::const_iterator ci=counters.begin();ci!=counters.end();ci++)
+                out<<(ci==counters.begin() ? "" : ",")<<"\""<<escape(ci->first)<<"\":"<<ci->second;
+            out<<"}}";
+            return out.str();
+        }
+
+        //Chrome trace event format: complete ("X") events for scopes, and a single counter ("C") event with the final counter values
+        IGL_INLINE std::string to_chrome_trace() const{
+            std::ostringstream out;
+            out<<"{\"traceEvents\":[";
+            for (int i=0;i<events.size();i++)
+                out<<(i==0 ? "" : ",")<<"{\"name\":\""<<escape(events[i].name)<<"\",\"cat\":\"directional\",\"ph\":\"X\",\"ts\":"<<events[i].start<<",\"dur\":"<<events[i].duration<<",\"pid\":0,\"tid\":0}";
+            if (!counters.empty()){
+                out<<(events.empty() ? "" : ",")<<"{\"name\":\"counters\",\"ph\":\"C\",\"ts\":"<<now()<<",\"pid\":0,\"tid\":0,\"args\":{";
+                for (std::map<std::string, long long>::const_iterator ci=counters.begin();ci!=counters.end();ci++)
+                    out<<(ci==counters.begin() ? "" : ",")<<"\""<<escape(ci->first)<<"\":"<<ci->second;
+                out<<"}}";
+            }
+            out<<"],\"displayTimeUnit\":\"ms\"}";
+            return out.str();
+        }
+
+        IGL_INLINE bool write_json(const std::string& fileName) const{
+            std::ofstream f(fileName);
+            if (!f.is_open())
+                return false;
+            f<<to_json();
+            return true;
+        }
+
+        IGL_INLINE bool write_chrome_trace(const std::string& fileName) const{
+            std::ofstream f(fileName);
+            if (!f.is_open())
+                return false;
+            f<<to_chrome_trace();
+            return true;
+        }
+
+    private:
+        static IGL_INLINE std::string escape(const std::string& s){
+            std::string escaped;
+            for (int i=0;i<s.size();i++){
+                if ((s[i]=='"')||(s[i]=='\\'))
+                    escaped+='\\';
+                escaped+=s[i];
+            }
+            return escaped;
+        }
+    };
+
+
+    //Times its own lifetime into a report under the given name. Does nothing (not even reading the clock) if the report is NULL.
+    class ScopedTimer{
+    public:
+        ScopedTimer(ProfileReport* _report, const char* _name):report(_report), name(_name), start(0.0), depth(0){
+            if (!report)
+                return;
+            depth=report->currDepth++;
+            start=report->now();
+        }
+
+        ~ScopedTimer(){
+            if (!report)
+                return;
+            ProfileReport::Event event;
+            event.name=name;
+            event.start=start;
+            event.duration=report->now()-start;
+            event.depth=depth;
+            report->events.push_back(event);
+            report->currDepth--;
+        }
+
+    private:
+        ProfileReport* report;
+        const char* name;
+        double start;
+        int depth;
+
+        ScopedTimer(const ScopedTimer&);
+        ScopedTimer& operator=(const ScopedTimer&);
+    };
+
+}
+
+#endif
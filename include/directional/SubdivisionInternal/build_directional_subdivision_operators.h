@@ -4,6 +4,8 @@
 #include "quadrisect.h"
 #include "iterate_rings.h"
 #include "iterate_branched_rings.h"
+#include "build_subdivision_topology.h"
+#include "build_subdivision_operators.h"
 #include <Eigen/Sparse>
 
 namespace directional {
@@ -83,154 +85,176 @@ namespace directional {
         };
     }
 
+    /**
+     * \brief Builds the directional operators that subdivide a single level to the next one, for the matching of the level. The rings
+     * of the level are handled in parallel, with the triplets of every block of rings merged in a fixed order.
+     * \param lvl The level, with its rings and edge map to the next level (see build_next_subdivision_level())
+     * \param nextEdgeCount The number of edges of the next level
+     * \param matching The matching of the level
+     * \param sizes For every triplet provider, the size of its data on the level, which is replaced by its size on the next level
+     * \param nextMatching The matching of the next level
+     * \param levelOutput For every triplet provider, the operator from the level to the next one.
+     */
     template<typename...TripletProviders>
-    void build_directional_subdivision_operators (
-        const Eigen::MatrixXd& V0,
-        const Eigen::MatrixXi& F0,
-        const Eigen::MatrixXi& E0,
-        const Eigen::MatrixXi& EF0,
-        const Eigen::MatrixXi& EI0,
-        const Eigen::MatrixXi& SFE0,
-        const Eigen::VectorXi& Matching0,
-        const std::vector<int>& initialSizes,
-        int level,
+    void build_directional_subdivision_level_operator(
+        const SubdivisionLevel& lvl,
+        int nextEdgeCount,
+        const Eigen::VectorXi& matching,
+        std::vector<int>& sizes,
         int N,
-        Eigen::MatrixXi& FK,
-        Eigen::MatrixXi& EK,
-        Eigen::MatrixXi& EFK,
-        Eigen::MatrixXi& EIK,
-        Eigen::MatrixXi& SFEK,
-        Eigen::VectorXi& MatchingK,
-        std::vector<Eigen::SparseMatrix<double>>& output,
+        Eigen::VectorXi& nextMatching,
+        std::vector<Eigen::SparseMatrix<double>>& levelOutput,
         TripletProviders...tripletProviders
     )
     {
         constexpr int ProviderNum = sizeof...(TripletProviders);
 
-
-        // Matrices representing geometry connectivity.
-        Eigen::MatrixXi Fs[2] = { F0,{} };
-        Eigen::MatrixXi Es[2] = { E0, {} };
-        Eigen::MatrixXi SFEs[2] = { SFE0,{} };
-        Eigen::MatrixXi EFs[2] = { EF0,{} };
-        Eigen::MatrixXi EIs[2] = { EI0,{} };
-        Eigen::VectorXi Matchings[2] = { Matching0, {} };
-        Eigen::MatrixXi E0ToEK; // Map edges from level to next level
-
-        // The current vertex count
-        int currentVCount = V0.rows();
-
-        // The index of the matrices to fill next
-        int toFill = 1;
-
         // Tuple of subdivision constructors
         std::tuple<TripletProviders...> constructors = std::make_tuple(tripletProviders...);
 
-        // The triplets
-        std::vector<std::vector<Eigen::Triplet<double>>> triplets(ProviderNum, std::vector<Eigen::Triplet<double>>{});
-
-        // The row sizes for the jump level subdivision operator
-        std::vector<int> rowSizes(ProviderNum, 0);
+        // Every block of rings fills its own triplets
+        const int blockCount = ring_block_count(lvl.ringEdges.size());
+        std::vector<std::vector<std::vector<Eigen::Triplet<double>>>> blockTriplets(blockCount, std::vector<std::vector<Eigen::Triplet<double>>>(ProviderNum));
+        std::vector<std::vector<int>> blockRowSizes(blockCount, std::vector<int>(ProviderNum, 0));
 
         // Function to handle a new ring
-        auto ringHandler = [&Fs, &SFEs, &Es, &EFs, &EIs, &E0ToEK, &triplets, &constructors, &currentVCount, &toFill, &rowSizes](
+        auto ringHandler = [&lvl, &blockTriplets, &blockRowSizes, &constructors](const int block,
             const std::vector<int>& edges, const std::vector<int>& edgeSides, const Eigen::MatrixXi& edgeLevels, const Eigen::MatrixXi& faceLevels, int wraps, int N)
         {
-            const int filled = 1 - toFill;
-            /*
-                const int& vertexCount,
-                const Eigen::MatrixXi& F0,
-                const Eigen::MatrixXi& SFE0,
-                const Eigen::MatrixXi& E0,
-                const Eigen::MatrixXi& EI0,
-                const Eigen::MatrixXi& EF0,
-                const Eigen::MatrixXi& E0ToEk,
-                const std::vector<int>& edges,
-                const std::vector<int>& edgeSides,
-                std::vector<std::vector<Eigen::Triplet<double>>>& output,
-                std::vector<int>& rowSizes,
-                std::tuple<TripletProviders...> tripletProviders,
-                std::index_sequence<Is...>
-            */
-            handleRing_directionals(currentVCount,
-                Fs[filled],
-                SFEs[filled],
-                Es[filled],
-                EIs[filled],
-                EFs[filled],
-                E0ToEK,
+            handleRing_directionals(lvl.vertexCount,
+                lvl.F,
+                lvl.SFE,
+                lvl.E,
+                lvl.EI,
+                lvl.EF,
+                lvl.EToNextE,
                 edges,
                 edgeSides,
                 edgeLevels,
                 faceLevels,
                 wraps,
                 N,
-                triplets,
-                rowSizes,
+                blockTriplets[block],
+                blockRowSizes[block],
                 constructors, std::index_sequence_for<TripletProviders...>{});
         };
 
+        // Iterate over all rings in the mesh, apply the subdivision constructors to acquire
+        // the triplets for every matrix.
+        parallel_iterate_branched_rings(lvl.ringEdges, lvl.ringSides, N, matching, blockCount, ringHandler);
 
-        // Initialize the output to identity matrices initially. We are 
-        // going to progressively build the subdivision operator by 
-        // multiplying the operator for the different levels.
-        for (int i = 0; i < ProviderNum; i++)
+        std::vector<std::vector<Eigen::Triplet<double>>> triplets(ProviderNum);
+        std::vector<int> rowSizes(ProviderNum, 0);
+        merge_block_triplets(blockTriplets, blockRowSizes, triplets, rowSizes);
+
+        // Construct the operators to move one subdivision level up
+        levelOutput.assign(ProviderNum, Eigen::SparseMatrix<double>());
+        for (int j = 0; j < ProviderNum; j++)
         {
-            output.emplace_back(initialSizes[i], initialSizes[i]);
-            output.back().setIdentity();
+            levelOutput[j].resize(rowSizes[j], sizes[j]);
+            levelOutput[j].setFromTriplets(triplets[j].begin(), triplets[j].end());
+            sizes[j] = rowSizes[j];
         }
 
-        // Construct subdivision per level
-        for (int i = 0; i < level; i++)
+        // Update matching for finer level
+        nextMatching = Eigen::VectorXi::Zero(nextEdgeCount, 1);
+        for (int e = 0; e < matching.rows(); ++e)
         {
-            // Quadrisect connectivity data first
-            const int filled = 1 - toFill;
-            quadrisect(Fs[filled], currentVCount, Es[filled], SFEs[filled], EFs[filled], EIs[filled], E0ToEK,
-                Fs[toFill], Es[toFill], SFEs[toFill], EFs[toFill], EIs[toFill]);
-
-            // Iterate over all rings in the mesh, apply the subdivision constructors to acquire
-            // the triplets for every matrix.
-            iterate_branched_rings(currentVCount, Es[filled], EFs[filled], EIs[filled], SFEs[filled], N,
-                Matchings[filled],
-                ringHandler);
-
-            // Construct subdivision operators
+            // Copy the matching for even edges. For all odd edges, set it to zero.
+            nextMatching(lvl.EToNextE(e, 0)) = matching(e);
+            nextMatching(lvl.EToNextE(e, 1)) = matching(e);
+        }
+    }
+
+    /**
+     * \brief Builds the directional operators that subdivide from every level of a precomputed topology (see build_subdivision_topology())
+     * to the next one, for the given coarse matching, without composing them (see build_directional_subdivision_level_operator()).
+     * \param initialSizes For every triplet provider, the size of its data on the coarse level
+     * \param levelMatchings The matchings of all levels, from Matching0 to the target level
+     * \param levelOutput For every triplet provider, the operators of all levels: levelOutput[j][i] takes level i to level i+1.
+     */
+    template<typename...TripletProviders>
+    void build_directional_subdivision_level_operators(
+        const SubdivisionTopology& topology,
+        const Eigen::VectorXi& Matching0,
+        const std::vector<int>& initialSizes,
+        int N,
+        std::vector<Eigen::VectorXi>& levelMatchings,
+        std::vector<std::vector<Eigen::SparseMatrix<double>>>& levelOutput,
+        TripletProviders...tripletProviders
+    )
+    {
+        constexpr int ProviderNum = sizeof...(TripletProviders);
+        levelOutput.assign(ProviderNum, std::vector<Eigen::SparseMatrix<double>>(topology.targetLevel()));
+        levelMatchings.assign(topology.targetLevel() + 1, Eigen::VectorXi());
+        levelMatchings[0] = Matching0;
+
+        // The column count of the operators of the current level, being the row count of the previous ones
+        std::vector<int> sizes = initialSizes;
+        for (int i = 0; i < topology.targetLevel(); i++)
+        {
+            std::vector<Eigen::SparseMatrix<double>> out;
+            build_directional_subdivision_level_operator(topology.levels[i], topology.levels[i + 1].E.rows(), levelMatchings[i], sizes, N, levelMatchings[i + 1], out, tripletProviders...);
             for (int j = 0; j < ProviderNum; j++)
-            {
-                // Construct the operator to move one subdivision level up
-                Eigen::SparseMatrix<double> levelJumpMat(rowSizes[j], output[j].rows());
-
-                levelJumpMat.setFromTriplets(triplets[j].begin(), triplets[j].end());
-
-                // Apply the operator to the previous subdivision operator
-                output[j] = levelJumpMat * output[j];
-                triplets[j].clear();
-            }
-
-            // Update target
-            currentVCount += Es[filled].rows();
-
-            // Update matching for finer level
-            Matchings[toFill] = Eigen::VectorXi::Zero(Es[toFill].rows(), 1);
-            for (int e = 0; e < Matchings[filled].rows(); ++e)
-            {
-                // Copy the matching for even edges. For all odd edges, set it to zero.
-                Matchings[toFill](E0ToEK(e, 0)) = Matchings[filled](e);
-                Matchings[toFill](E0ToEK(e, 1)) = Matchings[filled](e);
-            }
-
-            // Switch target matrices
-            toFill = filled;
+                levelOutput[j][i] = std::move(out[j]);
         }
+    }
+
+    /**
+     * \brief Builds the directional subdivision operators from the coarse level to the target level of a precomputed topology
+     * (see build_subdivision_topology()), for the given coarse matching, as the products of the operators of the levels
+     * (see build_directional_subdivision_level_operators()).
+     */
+    template<typename...TripletProviders>
+    void build_directional_subdivision_operators(
+        const SubdivisionTopology& topology,
+        const Eigen::VectorXi& Matching0,
+        const std::vector<int>& initialSizes,
+        int N,
+        Eigen::VectorXi& MatchingK,
+        std::vector<Eigen::SparseMatrix<double>>& output,
+        TripletProviders...tripletProviders
+    )
+    {
+        std::vector<Eigen::VectorXi> levelMatchings;
+        std::vector<std::vector<Eigen::SparseMatrix<double>>> levelOutput;
+        build_directional_subdivision_level_operators(topology, Matching0, initialSizes, N, levelMatchings, levelOutput, tripletProviders...);
+        compose_level_operators(initialSizes, levelOutput, output);
+        MatchingK = levelMatchings.back();
+    }
+
+    template<typename...TripletProviders>
+    void build_directional_subdivision_operators (
+        const Eigen::MatrixXd& V0,
+        const Eigen::MatrixXi& F0,
+        const Eigen::MatrixXi& E0,
+        const Eigen::MatrixXi& EF0,
+        const Eigen::MatrixXi& EI0,
+        const Eigen::MatrixXi& SFE0,
+        const Eigen::VectorXi& Matching0,
+        const std::vector<int>& initialSizes,
+        int level,
+        int N,
+        Eigen::MatrixXi& FK,
+        Eigen::MatrixXi& EK,
+        Eigen::MatrixXi& EFK,
+        Eigen::MatrixXi& EIK,
+        Eigen::MatrixXi& SFEK,
+        Eigen::VectorXi& MatchingK,
+        std::vector<Eigen::SparseMatrix<double>>& output,
+        TripletProviders...tripletProviders
+    )
+    {
+        SubdivisionTopology topology;
+        build_subdivision_topology(V0.rows(), F0, E0, EF0, EI0, SFE0, level, topology);
+        build_directional_subdivision_operators(topology, Matching0, initialSizes, N, MatchingK, output, tripletProviders...);
 
         // Setup output connectivity matrices
-        const int outputInd = 1 - toFill;
-        EFK = EFs[outputInd];
-        SFEK = SFEs[outputInd];
-        FK = Fs[outputInd];
-        EK = Es[outputInd];
-        EIK = EIs[outputInd];
-        MatchingK = Matchings[outputInd];
+        EFK = topology.fine().EF;
+        SFEK = topology.fine().SFE;
+        FK = topology.fine().F;
+        EK = topology.fine().E;
+        EIK = topology.fine().EI;
     }
 }
 
@@ -1,8 +1,10 @@
 #ifndef DIRECTIONAL_BUILD_SUBDIVISION_OPERATORS_H
 #define DIRECTIONAL_BUILD_SUBDIVISION_OPERATORS_H
 #include <Eigen/Eigen>
+#include <algorithm>
 #include "quadrisect.h"
 #include "iterate_rings.h"
+#include "build_subdivision_topology.h"
 
 namespace directional{
 
@@ -69,128 +71,188 @@ namespace directional{
 		};
 	}
 
-	template<typename...TripletProviders>
-    void build_subdivision_operators(
-        const Eigen::MatrixXd& V0,
-		const Eigen::MatrixXi& F0,
-		const Eigen::MatrixXi& E0,
-		const Eigen::MatrixXi& EF0,
-		const Eigen::MatrixXi& EI0,
-		const Eigen::MatrixXi& SFE0,
+	/**
+	 * \brief Concatenates the triplets that parallel_iterate_rings() produced per block, in block order, into the triplets
+	 * of every operator, and takes the maximal row count of every operator.
+	 */
+	inline void merge_block_triplets(
+		std::vector<std::vector<std::vector<Eigen::Triplet<double>>>>& blockTriplets,
+		const std::vector<std::vector<int>>& blockRowSizes,
+		std::vector<std::vector<Eigen::Triplet<double>>>& triplets,
+		std::vector<int>& rowSizes)
+	{
+		for (int j = 0; j < triplets.size(); j++)
+		{
+			size_t tripletCount = triplets[j].size();
+			for (int b = 0; b < blockTriplets.size(); b++)
+				tripletCount += blockTriplets[b][j].size();
+			triplets[j].reserve(tripletCount);
+			for (int b = 0; b < blockTriplets.size(); b++)
+			{
+				triplets[j].insert(triplets[j].end(), blockTriplets[b][j].begin(), blockTriplets[b][j].end());
+				std::vector<Eigen::Triplet<double>>().swap(blockTriplets[b][j]);
+				rowSizes[j] = std::max(rowSizes[j], blockRowSizes[b][j]);
+			}
+		}
+	}
+
+	/**
+	 * \brief Composes the operators of all levels into one operator per triplet provider, starting from the identity of the
+	 * given initial size.
+	 */
+	inline void compose_level_operators(
 		const std::vector<int>& initialSizes,
-		int level,
-		Eigen::MatrixXi& FK,
-		Eigen::MatrixXi& EK,
-		Eigen::MatrixXi& EFK,
-		Eigen::MatrixXi& EIK,
-		Eigen::MatrixXi& SFEK,
-		std::vector<Eigen::SparseMatrix<double>>& output,
+		const std::vector<std::vector<Eigen::SparseMatrix<double>>>& levelOutput,
+		std::vector<Eigen::SparseMatrix<double>>& output)
+	{
+		// Initialize the output to identity matrices initially. We are 
+		// going to progressively build the subdivision operator by 
+		// multiplying the operator for the different levels.
+		for(int j = 0; j < levelOutput.size(); j++)
+		{
+			output.emplace_back(initialSizes[j],initialSizes[j]);
+			output.back().setIdentity();
+			for (int i = 0; i < levelOutput[j].size(); i++)
+			{
+				output.back() = levelOutput[j][i] * output.back();
+			}
+		}
+	}
+
+	/**
+	 * \brief Builds the operators that subdivide a single level to the next one. The rings of the level are handled in parallel, with
+	 * the triplets of every block of rings merged in a fixed order, so that the operators do not depend on the number of threads.
+	 * \param lvl The level, with its rings and edge map to the next level (see build_next_subdivision_level())
+	 * \param sizes For every triplet provider, the size of its data on the level, which is replaced by its size on the next level
+	 * \param levelOutput For every triplet provider, the operator from the level to the next one.
+	 */
+	template<typename...TripletProviders>
+	void build_subdivision_level_operator(
+		const SubdivisionLevel& lvl,
+		std::vector<int>& sizes,
+		std::vector<Eigen::SparseMatrix<double>>& levelOutput,
 		TripletProviders...tripletProviders
 	)
 	{
 		constexpr int N = sizeof...(TripletProviders);
-        
-
-		// Matrices representing geometry connectivity.
-		Eigen::MatrixXi Fs[2] = { F0,{} };
-		Eigen::MatrixXi Es[2] = { E0, {} };
-		Eigen::MatrixXi SFEs[2] = { SFE0,{} };
-		Eigen::MatrixXi EFs[2] = { EF0,{} };
-		Eigen::MatrixXi EIs[2] = { EI0,{} };
-		Eigen::MatrixXi E0ToEK; // Map edges from level to next level
-		
-		// The current vertex count
-		int currentVCount = V0.rows();
-
-		// The index of the matrices to fill next
-		int toFill = 1;
 
 		// Tuple of subdivision constructors
 		std::tuple<TripletProviders...> constructors = std::make_tuple(tripletProviders...);
 
-		// The triplets
-		std::vector<std::vector<Eigen::Triplet<double>>> triplets(N, std::vector<Eigen::Triplet<double>>{});
-
-		// The row sizes for the jump level subdivision operator
-		std::vector<int> rowSizes(N, 0);
+		// Every block of rings fills its own triplets
+		const int blockCount = ring_block_count(lvl.ringEdges.size());
+		std::vector<std::vector<std::vector<Eigen::Triplet<double>>>> blockTriplets(blockCount, std::vector<std::vector<Eigen::Triplet<double>>>(N));
+		std::vector<std::vector<int>> blockRowSizes(blockCount, std::vector<int>(N, 0));
 
 		// Function to handle a new ring
-		auto ringHandler = [&Fs,&SFEs,&Es,&EFs, &EIs, &E0ToEK, &triplets,&constructors, &currentVCount, &toFill, &rowSizes](const std::vector<int>& edges, const std::vector<int>& edgeSides)
+		auto ringHandler = [&lvl, &blockTriplets, &blockRowSizes, &constructors](const int block, const std::vector<int>& edges, const std::vector<int>& edgeSides)
 		{
-			const int filled = 1- toFill;
-			/*const int& vertexCount,
-				const Eigen::MatrixXi& F0,
-				const Eigen::MatrixXi& SFE0,
-				const Eigen::MatrixXi& E0,
-				const Eigen::MatrixXi& EI0,
-				const Eigen::MatrixXi& EF0,
-				const Eigen::MatrixXi& E0ToEk,
-				const std::vector<int>& edges,
-				const std::vector<int>& edgeSides,
-				std::vector<std::vector<Eigen::Triplet<double>>>& output,
-				std::vector<int>& rowSizes,
-				std::tuple<TripletProviders...> tripletProviders,
-				std::index_sequence<Is...>*/
-			handleRing(currentVCount, 
-				Fs[filled],
-				SFEs[filled],
-				Es[filled],
-				EIs[filled],
-				EFs[filled],
-				E0ToEK, 
-				edges, 
-				edgeSides, 
-				triplets, 
-				rowSizes, 
+			handleRing(lvl.vertexCount,
+				lvl.F,
+				lvl.SFE,
+				lvl.E,
+				lvl.EI,
+				lvl.EF,
+				lvl.EToNextE,
+				edges,
+				edgeSides,
+				blockTriplets[block],
+				blockRowSizes[block],
 				constructors, std::index_sequence_for<TripletProviders...>{});
 		};
 
+		// Iterate over all rings in the mesh, apply the subdivision constructors to acquire
+		// the triplets for every matrix.
+		parallel_iterate_rings(lvl.ringEdges, lvl.ringSides, blockCount, ringHandler);
 
-		// Initialize the output to identity matrices initially. We are 
-		// going to progressively build the subdivision operator by 
-		// multiplying the operator for the different levels.
-		for(int i = 0; i < N; i++)
-		{
-			output.emplace_back(initialSizes[i],initialSizes[i]);
-			output.back().setIdentity();
-		}
+		std::vector<std::vector<Eigen::Triplet<double>>> triplets(N);
+		std::vector<int> rowSizes(N, 0);
+		merge_block_triplets(blockTriplets, blockRowSizes, triplets, rowSizes);
 
-		// Construct subdivision per level
-		for(int i = 0; i < level; i++)
+		// Construct the operators to move one subdivision level up
+		levelOutput.assign(N, Eigen::SparseMatrix<double>());
+		for(int j = 0; j < N; j++)
 		{
-			// Quadrisect connectivity data first
-			const int filled = 1 - toFill;
-			quadrisect(Fs[filled], currentVCount, Es[filled], SFEs[filled], EFs[filled], EIs[filled], E0ToEK,
-				Fs[toFill], Es[toFill], SFEs[toFill], EFs[toFill], EIs[toFill]);
+			levelOutput[j].resize(rowSizes[j], sizes[j]);
+			levelOutput[j].setFromTriplets(triplets[j].begin(), triplets[j].end());
+			sizes[j] = rowSizes[j];
+		}
+	}
 
-			// Iterate over all rings in the mesh, apply the subdivision constructors to acquire
-			// the triplets for every matrix.
-			iterate_rings(currentVCount, Es[filled], EFs[filled], EIs[filled], SFEs[filled], ringHandler);
+	/**
+	 * \brief Builds the operators that subdivide from every level of a precomputed topology (see build_subdivision_topology())
+	 * to the next one, without composing them (see build_subdivision_level_operator()).
+	 * \param initialSizes For every triplet provider, the size of its data on the coarse level
+	 * \param levelOutput For every triplet provider, the operators of all levels: levelOutput[j][i] takes level i to level i+1.
+	 */
+	template<typename...TripletProviders>
+	void build_subdivision_level_operators(
+		const SubdivisionTopology& topology,
+		const std::vector<int>& initialSizes,
+		std::vector<std::vector<Eigen::SparseMatrix<double>>>& levelOutput,
+		TripletProviders...tripletProviders
+	)
+	{
+		constexpr int N = sizeof...(TripletProviders);
+		levelOutput.assign(N, std::vector<Eigen::SparseMatrix<double>>(topology.targetLevel()));
 
-			// Construct subdivision operators
+		// The column count of the operators of the current level, being the row count of the previous ones
+		std::vector<int> sizes = initialSizes;
+		for(int i = 0; i < topology.targetLevel(); i++)
+		{
+			std::vector<Eigen::SparseMatrix<double>> out;
+			build_subdivision_level_operator(topology.levels[i], sizes, out, tripletProviders...);
 			for(int j = 0; j < N; j++)
-			{
-				// Construct the operator to move one subdivision level up
-				Eigen::SparseMatrix<double> levelJumpMat(rowSizes[j], output[j].rows() );
-				levelJumpMat.setFromTriplets(triplets[j].begin(), triplets[j].end());
-
-				// Apply the operator to the previous subdivision operator
-				output[j] = levelJumpMat * output[j];
-				triplets[j].clear();
-			}
-			
-			// Update target
-			currentVCount += Es[filled].rows();
-			toFill = filled;
+				levelOutput[j][i] = std::move(out[j]);
 		}
+	}
+
+	/**
+	 * \brief Builds the subdivision operators from the coarse level to the target level of a precomputed topology (see
+	 * build_subdivision_topology()), as the products of the operators of the levels (see build_subdivision_level_operators()).
+	 */
+	template<typename...TripletProviders>
+	void build_subdivision_operators(
+		const SubdivisionTopology& topology,
+		const std::vector<int>& initialSizes,
+		std::vector<Eigen::SparseMatrix<double>>& output,
+		TripletProviders...tripletProviders
+	)
+	{
+		std::vector<std::vector<Eigen::SparseMatrix<double>>> levelOutput;
+		build_subdivision_level_operators(topology, initialSizes, levelOutput, tripletProviders...);
+		compose_level_operators(initialSizes, levelOutput, output);
+	}
+
+	template<typename...TripletProviders>
+    void build_subdivision_operators(
+        const Eigen::MatrixXd& V0,
+		const Eigen::MatrixXi& F0,
+		const Eigen::MatrixXi& E0,
+		const Eigen::MatrixXi& EF0,
+		const Eigen::MatrixXi& EI0,
+		const Eigen::MatrixXi& SFE0,
+		const std::vector<int>& initialSizes,
+		int level,
+		Eigen::MatrixXi& FK,
+		Eigen::MatrixXi& EK,
+		Eigen::MatrixXi& EFK,
+		Eigen::MatrixXi& EIK,
+		Eigen::MatrixXi& SFEK,
+		std::vector<Eigen::SparseMatrix<double>>& output,
+		TripletProviders...tripletProviders
+	)
+	{
+		SubdivisionTopology topology;
+		build_subdivision_topology(V0.rows(), F0, E0, EF0, EI0, SFE0, level, topology);
+		build_subdivision_operators(topology, initialSizes, output, tripletProviders...);
 
 		// Setup output connectivity matrices
-		const int outputInd = 1 - toFill;
-		EFK = EFs[outputInd];
-		SFEK = SFEs[outputInd];
-		FK = Fs[outputInd];
-		EK = Es[outputInd];
-		EIK = EIs[outputInd];
+		EFK = topology.fine().EF;
+		SFEK = topology.fine().SFE;
+		FK = topology.fine().F;
+		EK = topology.fine().E;
+		EIK = topology.fine().EI;
     }
 }
 
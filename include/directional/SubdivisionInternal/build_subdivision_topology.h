@@ -0,0 +1,138 @@
+#ifndef DIRECTIONAL_BUILD_SUBDIVISION_TOPOLOGY_H
+#define DIRECTIONAL_BUILD_SUBDIVISION_TOPOLOGY_H
+#include <Eigen/Eigen>
+#include <vector>
+#include <utility>
+#include "quadrisect.h"
+#include "iterate_rings.h"
+
+namespace directional {
+
+    /**
+     * \brief The connectivity of a single level of a subdivision hierarchy, with its 1-rings and the map of its edges to the next level.
+     */
+    struct SubdivisionLevel
+    {
+        int vertexCount;
+        Eigen::MatrixXi F, E, SFE, EF, EI;
+        // |E| x 4 mapping of every edge to the edges of the next level (see quadrisect()). Empty at the finest level.
+        Eigen::MatrixXi EToNextE;
+        // The 1-rings of the level, as given by collect_rings(). Empty at the finest level.
+        std::vector<std::vector<int>> ringEdges, ringSides;
+    };
+
+    /**
+     * \brief The topology of all levels of a subdivision, from the coarse mesh (levels[0]) to the target level (levels.back()).
+     * It only depends on the coarse mesh, and can be shared by the subdivision operators of different fields on that mesh.
+     */
+    struct SubdivisionTopology
+    {
+        std::vector<SubdivisionLevel> levels;
+
+        int targetLevel() const { return (int)levels.size() - 1; }
+        const SubdivisionLevel& fine() const { return levels.back(); }
+    };
+
+    /**
+     * \brief Quadrisects a level into the next one, and collects the rings of the level and its map of edges to the next level.
+     */
+    inline void build_next_subdivision_level(SubdivisionLevel& curr, SubdivisionLevel& next)
+    {
+        quadrisect(curr.F, curr.vertexCount, curr.E, curr.SFE, curr.EF, curr.EI, curr.EToNextE,
+            next.F, next.E, next.SFE, next.EF, next.EI);
+        next.vertexCount = curr.vertexCount + curr.E.rows();
+        collect_rings(curr.vertexCount, curr.E, curr.EF, curr.EI, curr.SFE, curr.ringEdges, curr.ringSides);
+    }
+
+    /**
+     * \brief Quadrisects the coarse connectivity level times, and collects the rings of every level but the last.
+     * \param vCount0 The number of coarse vertices
+     * \param F0, E0, EF0, EI0, SFE0 The coarse connectivity (see shm_edge_topology())
+     * \param level The target subdivision level
+     * \param topology The resulting hierarchy
+     */
+    inline void build_subdivision_topology(
+        int vCount0,
+        const Eigen::MatrixXi& F0,
+        const Eigen::MatrixXi& E0,
+        const Eigen::MatrixXi& EF0,
+        const Eigen::MatrixXi& EI0,
+        const Eigen::MatrixXi& SFE0,
+        int level,
+        SubdivisionTopology& topology)
+    {
+        topology.levels.clear();
+        topology.levels.resize(level + 1);
+        SubdivisionLevel& coarse = topology.levels[0];
+        coarse.vertexCount = vCount0;
+        coarse.F = F0;
+        coarse.E = E0;
+        coarse.EF = EF0;
+        coarse.EI = EI0;
+        coarse.SFE = SFE0;
+
+        for (int i = 0; i < level; i++)
+            build_next_subdivision_level(topology.levels[i], topology.levels[i + 1]);
+    }
+
+    /**
+     * \brief Walks the levels of a subdivision from the coarse level to the target level. The levels either come from a precomputed
+     * topology, or are quadrisected one at a time from the coarse connectivity, in which case only the current and the next level
+     * are alive, and the connectivity and rings of every passed level are discarded.
+     */
+    class SubdivisionLevelWalker
+    {
+    public:
+        // Walks the levels of a precomputed topology
+        SubdivisionLevelWalker(const SubdivisionTopology& _topology)
+            : topology(&_topology), levelIndex(0), targetLevel(_topology.targetLevel()) {}
+
+        // Walks the levels of the coarse connectivity up to level (see build_subdivision_topology()), building them on the way
+        SubdivisionLevelWalker(int vCount0,
+            const Eigen::MatrixXi& F0,
+            const Eigen::MatrixXi& E0,
+            const Eigen::MatrixXi& EF0,
+            const Eigen::MatrixXi& EI0,
+            const Eigen::MatrixXi& SFE0,
+            int level)
+            : topology(nullptr), levelIndex(0), targetLevel(level)
+        {
+            window[0].vertexCount = vCount0;
+            window[0].F = F0;
+            window[0].E = E0;
+            window[0].EF = EF0;
+            window[0].EI = EI0;
+            window[0].SFE = SFE0;
+            if (targetLevel > 0)
+                build_next_subdivision_level(window[0], window[1]);
+        }
+
+        int index() const { return levelIndex; }
+        int target() const { return targetLevel; }
+        bool done() const { return levelIndex == targetLevel; }
+
+        // The current level, with its rings and edge map to the next level unless done()
+        const SubdivisionLevel& current() const { return (topology ? topology->levels[levelIndex] : window[0]); }
+        // The level after the current one. Only valid if not done()
+        const SubdivisionLevel& next() const { return (topology ? topology->levels[levelIndex + 1] : window[1]); }
+
+        // Moves to the next level, discarding the current one (if owned)
+        void advance()
+        {
+            levelIndex++;
+            if (topology)
+                return;
+            window[0] = std::move(window[1]);
+            window[1] = SubdivisionLevel();
+            if (levelIndex < targetLevel)
+                build_next_subdivision_level(window[0], window[1]);
+        }
+
+    private:
+        const SubdivisionTopology* topology;
+        SubdivisionLevel window[2];
+        int levelIndex, targetLevel;
+    };
+}
+
+#endif
@@ -116,6 +116,12 @@ namespace directional
         return a * b / gcd(a, b);
     }
 
+    // Defined below iterate_branched_rings(), which uses it.
+    inline void branched_ring_levels(const std::vector<int>& edges, const std::vector<int>& edgeSides, int N, const Eigen::VectorXi& matching,
+        Eigen::MatrixXi& edgeLevels,
+        Eigen::MatrixXi& faceLevels,
+        int& wraps);
+
     /**
 	 * \brief Iterates over all 1-rings in the mesh as specified by the input topology, calling the handler with each branched function around the 
 	 * vertex as determined by the specified matching
@@ -158,25 +164,60 @@ namespace directional
 	{
         auto handleRing = [&matching, &h, &N,&E](const std::vector<int>& edges, const std::vector<int>& edgeSides)
         {
-            int totalTransport = 0;
-
-            // Compute index for ring
-            for (int i = 0; i < edges.size(); i += 2)
-            {
-                totalTransport += edgeSides[i] == 0 ? N - matching(edges[i]) : matching(edges[i]);
-            }
             Eigen::MatrixXi faceLevels, edgeLevels;
-            totalTransport = modulo(totalTransport, N);
-            // Determine associated number of branched functions
-            const int branches = totalTransport == 0 ? N : gcd(totalTransport, N);
-            // Determine number of wrap arounds
-            const int wraps = N / branches; 
-            // Get levels for edges and faces
-            unwrapField(edges, edgeSides, matching, N, wraps, faceLevels, edgeLevels);
+            int wraps;
+            branched_ring_levels(edges, edgeSides, N, matching, edgeLevels, faceLevels, wraps);
             // Apply handler
             h(edges, edgeSides, edgeLevels, faceLevels, wraps, N);
         };
         iterate_rings(vCount, E, EF, EI, SFE, handleRing);
 	}
+
+    /**
+     * \brief Computes the branched functions around a single (non-boundary) 1-ring, as given to the handler of iterate_branched_rings().
+     */
+    inline void branched_ring_levels(const std::vector<int>& edges, const std::vector<int>& edgeSides, int N, const Eigen::VectorXi& matching,
+        Eigen::MatrixXi& edgeLevels,
+        Eigen::MatrixXi& faceLevels,
+        int& wraps)
+    {
+        int totalTransport = 0;
+
+        // Compute index for ring
+        for (int i = 0; i < edges.size(); i += 2)
+        {
+            totalTransport += edgeSides[i] == 0 ? N - matching(edges[i]) : matching(edges[i]);
+        }
+        totalTransport = modulo(totalTransport, N);
+        // Determine associated number of branched functions
+        const int branches = totalTransport == 0 ? N : gcd(totalTransport, N);
+        // Determine number of wrap arounds
+        wraps = N / branches;
+        // Get levels for edges and faces
+        unwrapField(edges, edgeSides, matching, N, wraps, faceLevels, edgeLevels);
+    }
+
+    /**
+     * \brief The parallel version of iterate_branched_rings() on precomputed rings (see collect_rings() and parallel_iterate_rings()).
+     * The handler gets the block index as an additional first argument.
+     */
+    template<typename Handler>
+    void parallel_iterate_branched_rings(
+        const std::vector<std::vector<int>>& ringEdges,
+        const std::vector<std::vector<int>>& ringSides,
+        int N,
+        const Eigen::VectorXi& matching,
+        int blockCount,
+        Handler& h)
+    {
+        auto handleRing = [&matching, &h, &N](const int block, const std::vector<int>& edges, const std::vector<int>& edgeSides)
+        {
+            Eigen::MatrixXi faceLevels, edgeLevels;
+            int wraps;
+            branched_ring_levels(edges, edgeSides, N, matching, edgeLevels, faceLevels, wraps);
+            h(block, edges, edgeSides, edgeLevels, faceLevels, wraps, N);
+        };
+        parallel_iterate_rings(ringEdges, ringSides, blockCount, handleRing);
+    }
 }
 #endif
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <Eigen/Eigen>
 #include <vector>
 #include <cassert>
+#include <algorithm>
+#include <igl/parallel_for.h>
+#include <igl/default_num_threads.h>
 
 
 namespace directional
@@ -42,15 +45,25 @@ namespace directional
 		}
 	}
 
-	template<typename Handler>
-	void iterate_rings(
+	/**
+	 * \brief Collects all 1-rings of the mesh, in the order in which iterate_rings() visits them: first the rings of the
+	 * boundary vertices, then the rest. Every ring is given as consecutive spoke and ring edges with their sides.
+	 * The rings only depend on the topology, and can be reused for any subdivision operator on the same level.
+	 * \param ringEdges The edges of every ring
+	 * \param ringSides The sides of the edges of every ring
+	 */
+	inline void collect_rings(
 		int vCount,
 		const Eigen::MatrixXi& E,
 		const Eigen::MatrixXi& EF,
 		const Eigen::MatrixXi& EI,
 		const Eigen::MatrixXi& SFE,
-		Handler& h)
+		std::vector<std::vector<int>>& ringEdges,
+		std::vector<std::vector<int>>& ringSides)
 	{
+		ringEdges.clear();
+		ringSides.clear();
+
 		// Retrieve the boundary edges along with their side
 		Eigen::MatrixXi boundary;
 		boundary_edges(EF, boundary);
@@ -122,8 +135,8 @@ namespace directional
 			edges.push_back(edge);
 			edgeSides.push_back(1 - side);
 
-            // Invoke visitor
-			h(edges, edgeSides);
+			ringEdges.push_back(edges);
+			ringSides.push_back(edgeSides);
 		}
 
 		// Handle regular vertex rings.
@@ -162,9 +175,54 @@ namespace directional
 				//prevFace = face();
 			} while (edge != eI); //Continue until we made a full loop
 
-            // Invoke visitor
-			h(edges, edgeSides);
+			ringEdges.push_back(edges);
+			ringSides.push_back(edgeSides);
 		}
 	}
+
+	template<typename Handler>
+	void iterate_rings(
+		int vCount,
+		const Eigen::MatrixXi& E,
+		const Eigen::MatrixXi& EF,
+		const Eigen::MatrixXi& EI,
+		const Eigen::MatrixXi& SFE,
+		Handler& h)
+	{
+		std::vector<std::vector<int>> ringEdges, ringSides;
+		collect_rings(vCount, E, EF, EI, SFE, ringEdges, ringSides);
+		for (int r = 0; r < ringEdges.size(); r++)
+			h(ringEdges[r], ringSides[r]);
+	}
+
+	/**
+	 * \brief The number of blocks to split the given number of rings into for parallel_iterate_rings().
+	 */
+	inline int ring_block_count(int ringCount)
+	{
+		return std::max(1, std::min(ringCount, 4 * (int)igl::default_num_threads()));
+	}
+
+	/**
+	 * \brief Visits precomputed rings (see collect_rings()) in parallel. The rings are split into blockCount contiguous blocks,
+	 * and h(block, edges, edgeSides) is called for all rings of a block by a single thread, in ring order. Concatenating
+	 * per-block outputs in block order therefore reproduces the serial order, independently of the number of threads.
+	 */
+	template<typename Handler>
+	void parallel_iterate_rings(
+		const std::vector<std::vector<int>>& ringEdges,
+		const std::vector<std::vector<int>>& ringSides,
+		int blockCount,
+		Handler& h)
+	{
+		const long long ringCount = ringEdges.size();
+		igl::parallel_for(blockCount, [&](const int block)
+		{
+			const int begin = (int)(ringCount * block / blockCount);
+			const int end = (int)(ringCount * (block + 1) / blockCount);
+			for (int r = begin; r < end; r++)
+				h(block, ringEdges[r], ringSides[r]);
+		}, 1);
+	}
 }
 #endif
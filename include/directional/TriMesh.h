@@ -14,14 +14,13 @@
 #include <igl/barycenter.h>
 #include <igl/readOBJ.h>
 #include <igl/readOFF.h>
-#include <igl/local_basis.h>
 #include <igl/per_face_normals.h>
 #include <igl/edge_topology.h>
 #include <igl/boundary_loop.h>
 #include <igl/triangle_triangle_adjacency.h>
-#include <igl/avg_edge_length.h>
+#include <igl/parallel_for.h>
+#include <directional/face_geometry.h>
 #include <directional/gaussian_curvature.h>
-#include <igl/doublearea.h>
 #include <directional/dcel.h>
 
 /***
@@ -57,6 +56,12 @@ namespace directional{
         Eigen::MatrixXd barycenters;
         Eigen::VectorXd GaussianCurvature;
 
+        //Per-face geometry, computed once and shared by the bundles and the FEM operators (see face_geometry())
+        Eigen::MatrixXd faceEdgeVectors;   //#F x 9, edge j is from F(i,j) to F(i,(j+1)%3)
+        Eigen::VectorXd faceDoubleAreas;
+        Eigen::MatrixXd cornerAngles;      //#F x 3, the angle at F(i,j)
+        Eigen::MatrixXd cornerCotangents;
+
         //Measures of the scale of a mesh
         double avgEdgeLength;
         Eigen::RowVector3d minBox, maxBox;   //bounding box
@@ -127,15 +132,34 @@ namespace directional{
             innerEdges = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(innerEdgesList.data(), innerEdgesList.size());
             boundEdges = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(boundEdgesList.data(), boundEdgesList.size());
             igl::barycenter(V, F, barycenters);
-            igl::local_basis(V, F, FBx, FBy, faceNormals);
             igl::triangle_triangle_adjacency(F, TT);
             igl::boundary_loop(F, boundaryLoops);
-            directional::gaussian_curvature(V,F,isBoundaryVertex, GaussianCurvature);
-            igl::doublearea(V,F,faceAreas);
-            faceAreas.array()/=2.0;
+            directional::face_geometry(V, F, faceEdgeVectors, faceDoubleAreas, cornerAngles, cornerCotangents);
+            directional::gaussian_curvature(V,F,isBoundaryVertex, cornerAngles, GaussianCurvature);
+            faceAreas = faceDoubleAreas/2.0;
             eulerChar = V.rows() - EV.rows() + F.rows();
             numGenerators = (2 - eulerChar)/2 - boundaryLoops.size();
-            avgEdgeLength=igl::avg_edge_length(V,F);
+
+            //the local basis (as igl::local_basis(): FBx along the first edge, and FBy=normal x FBx) and the average length of the face edges
+            //(as igl::avg_edge_length(), counting inner edges twice), from the face edge vectors. Degenerate faces get a zero normal and FBy.
+            faceNormals.resize(F.rows(),3);
+            FBx.resize(F.rows(),3);
+            FBy.resize(F.rows(),3);
+            Eigen::VectorXd faceEdgeLengthSums(F.rows());
+            igl::parallel_for(F.rows(), [&](const int i){
+                Eigen::RowVector3d edge0 = faceEdgeVectors.block<1,3>(i,0);
+                Eigen::RowVector3d edge1 = faceEdgeVectors.block<1,3>(i,3);
+                Eigen::RowVector3d edge2 = faceEdgeVectors.block<1,3>(i,6);
+                Eigen::RowVector3d normal = edge0.cross(edge1);
+                if (faceDoubleAreas(i)>0.0)
+                    normal/=faceDoubleAreas(i);
+                Eigen::RowVector3d bx = edge0.normalized();
+                faceNormals.row(i) = normal;
+                FBx.row(i) = bx;
+                FBy.row(i) = normal.cross(bx);
+                faceEdgeLengthSums(i) = edge0.norm()+edge1.norm()+edge2.norm();
+            }, 1000);
+            avgEdgeLength=faceEdgeLengthSums.sum()/(3.0*F.rows());
             minBox = V.colwise().minCoeff();
             maxBox = V.colwise().maxCoeff();
 
@@ -6,14 +6,12 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can
 // obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <igl/angle_bound_frame_fields.h>
+#include <directional/angle_bound_frame_fields.h>
 #include <igl/edge_topology.h>
 #include <igl/local_basis.h>
-#include <igl/sparse.h>
-#include <igl/speye.h>
-#include <igl/slice.h>
-#include <igl/polyroots.h>
-#include <igl/colon.h>
+#include <igl/parallel_for.h>
+#include <directional/polyroots.h>
+#include <directional/DiagonalShiftSolver.h>
 #include <Eigen/Sparse>
 
 #include <iostream>
@@ -54,6 +52,20 @@ public:
                                    const Eigen::PlainObjectBase<DerivedF> &_F);
   };
 
+  template <typename DerivedV, typename DerivedF>
+  class AngleBoundFFSolverState
+  {
+  public:
+    //The global step systems (DDA+lambda*I and DDB+lambda*I)
+    directional::DiagonalShiftSolver<typename DerivedV::Scalar> solverA, solverB;
+
+    //the data and the constrained faces the systems were set up for
+    const AngleBoundFFSolverData<DerivedV, DerivedF>* setupData;
+    Eigen::VectorXi setupConstraints;
+
+    AngleBoundFFSolverState():setupData(NULL){}
+  };
+
   template <typename DerivedV, typename DerivedF, typename DerivedO>
   class AngleBoundFFSolver
   {
@@ -63,7 +75,20 @@ public:
                                  int _maxIter = 50,
                                  const typename DerivedV::Scalar &_lambdaInit = 100,
                                  const typename DerivedV::Scalar &_lambdaMultFactor = 1.01,
-                                const bool _doHardConstraints = false);
+                                const bool _doHardConstraints = false,
+                                const typename DerivedV::Scalar &_convergenceTol = 1e-6,
+                                const bool _verbose = false);
+    //A solver that reuses the global step systems in _state from previous solves
+    IGL_INLINE AngleBoundFFSolver(const AngleBoundFFSolverData<DerivedV, DerivedF> &_data,
+                                  AngleBoundFFSolverState<DerivedV, DerivedF> &_state,
+                                  const typename DerivedV::Scalar &_thetaMin = 30,
+                                  int _maxIter = 50,
+                                  const typename DerivedV::Scalar &_lambdaInit = 100,
+                                  const typename DerivedV::Scalar &_lambdaMultFactor = 1.01,
+                                  const bool _doHardConstraints = false,
+                                  const typename DerivedV::Scalar &_convergenceTol = 1e-6,
+                                  const bool _verbose = false,
+                                  directional::ProfileReport* _report = NULL);
     IGL_INLINE bool solve(const Eigen::VectorXi &isConstrained,
                           const Eigen::PlainObjectBase<DerivedO> &initialSolution,
                           Eigen::PlainObjectBase<DerivedO> &output,
@@ -78,11 +103,19 @@ public:
     Eigen::Matrix<typename DerivedV::Scalar, Eigen::Dynamic, 2> pvU, pvV;
     typename DerivedV::Scalar lambda;
 
+    //The global step systems: in the state given by the caller, or else in ownState for this solver alone.
+    //They live outside the (const) data, so the data can be shared by concurrent solves.
+    AngleBoundFFSolverState<DerivedV, DerivedF> ownState;
+    AngleBoundFFSolverState<DerivedV, DerivedF> &state;
+    directional::ProfileReport* report;
+
     //parameters
     typename DerivedV::Scalar lambdaInit,lambdaMultFactor;
     int maxIter;
     typename DerivedV::Scalar thetaMin;
     bool doHardConstraints;
+    typename DerivedV::Scalar convergenceTol;
+    bool verbose;
 
     typename DerivedV::Scalar computeAngle(const std::complex<typename DerivedV::Scalar> &u,
                                            const std::complex<typename DerivedV::Scalar> &v);
@@ -102,11 +135,9 @@ public:
                                const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Ak,
                                const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Bk);
 
-    IGL_INLINE void minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > &Q,
-                         const Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > &f,
-                         const Eigen::VectorXi isConstrained,
-                         const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> &xknown,
-                                         Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> &x);
+    IGL_INLINE void setupGlobalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
+                                    const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Ak,
+                                    const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Bk);
     IGL_INLINE void setFieldFromCoefficients();
     IGL_INLINE void setCoefficientsFromField();
 
@@ -312,13 +343,48 @@ AngleBoundFFSolver(const AngleBoundFFSolverData<DerivedV, DerivedF> &_data,
                   int _maxIter,
                   const typename DerivedV::Scalar &_lambdaInit,
                   const typename DerivedV::Scalar &_lambdaMultFactor,
-                   const bool _doHardConstraints):
+                   const bool _doHardConstraints,
+                   const typename DerivedV::Scalar &_convergenceTol,
+                   const bool _verbose):
+data(_data),
+state(ownState),
+report(NULL),
+lambdaInit(_lambdaInit),
+maxIter(_maxIter),
+lambdaMultFactor(_lambdaMultFactor),
+doHardConstraints(_doHardConstraints),
+thetaMin(_thetaMin),
+convergenceTol(_convergenceTol),
+verbose(_verbose)
+{
+  Acoeff.resize(data.numF,1);
+  Bcoeff.resize(data.numF,1);
+  pvU.setZero(data.numF, 2);
+  pvV.setZero(data.numF, 2);
+};
+
+template <typename DerivedV, typename DerivedF, typename DerivedO>
+IGL_INLINE igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
+AngleBoundFFSolver(const AngleBoundFFSolverData<DerivedV, DerivedF> &_data,
+                   AngleBoundFFSolverState<DerivedV, DerivedF> &_state,
+                   const typename DerivedV::Scalar &_thetaMin,
+                   int _maxIter,
+                   const typename DerivedV::Scalar &_lambdaInit,
+                   const typename DerivedV::Scalar &_lambdaMultFactor,
+                   const bool _doHardConstraints,
+                   const typename DerivedV::Scalar &_convergenceTol,
+                   const bool _verbose,
+                   directional::ProfileReport* _report):
 data(_data),
+state(_state),
+report(_report),
 lambdaInit(_lambdaInit),
 maxIter(_maxIter),
 lambdaMultFactor(_lambdaMultFactor),
 doHardConstraints(_doHardConstraints),
-thetaMin(_thetaMin)
+thetaMin(_thetaMin),
+convergenceTol(_convergenceTol),
+verbose(_verbose)
 {
   Acoeff.resize(data.numF,1);
   Bcoeff.resize(data.numF,1);
@@ -359,7 +425,8 @@ template<typename DerivedV, typename DerivedF, typename DerivedO>
 IGL_INLINE void igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
 localStep()
 {
-  for (int j =0; j<data.numF; ++j)
+  //every face is projected independently
+  igl::parallel_for(data.numF, [&](const int j)
   {
 
     std::complex<typename DerivedV::Scalar> u(pvU(j,0),pvU(j,1));
@@ -396,7 +463,7 @@ localStep()
       pvU.row(j) << real(u1),imag(u1);
       pvV.row(j) << real(v1),imag(v1);
     }
-  }
+  }, 1000);
 
 }
 
@@ -472,32 +539,54 @@ template<typename DerivedV, typename DerivedF, typename DerivedO>
 IGL_INLINE int igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
 getNumOutOfBounds()
 {
-  Eigen::Matrix<typename DerivedV::Scalar, Eigen::Dynamic, 1> angles;
-//  computeAngles(angles);
-  int numOoB = 0;
-  for (int i =0; i<data.numF; ++i)
+  Eigen::VectorXi isOoB(data.numF);
+  igl::parallel_for(data.numF, [&](const int i)
   {
     std::complex<typename DerivedV::Scalar> u(pvU(i,0),pvU(i,1));
     std::complex<typename DerivedV::Scalar> v(pvV(i,0),pvV(i,1));
     typename DerivedV::Scalar angle = computeAngle(u,v);
-//    if (angles[i] <thetaMin*M_PI/180)
-    if (angle <thetaMin*M_PI/180)
-      numOoB ++;
-  }
-  return numOoB;
+    isOoB(i) = (angle <thetaMin*M_PI/180 ? 1 : 0);
+  }, 1000);
+  return isOoB.sum();
 }
 
 template<typename DerivedV, typename DerivedF, typename DerivedO>
 IGL_INLINE void igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
 setCoefficientsFromField()
 {
-  for (int i = 0; i <data.numF; ++i)
+  igl::parallel_for(data.numF, [&](const int i)
   {
     std::complex<typename DerivedV::Scalar> u(pvU(i,0),pvU(i,1));
     std::complex<typename DerivedV::Scalar> v(pvV(i,0),pvV(i,1));
     Acoeff(i) = u*u+v*v;
     Bcoeff(i) = u*u*v*v;
+  }, 1000);
+}
+
+
+template<typename DerivedV, typename DerivedF, typename DerivedO>
+IGL_INLINE void igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
+setupGlobalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
+                const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Ak,
+                const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>  &Bk)
+{
+  Eigen::VectorXi solveConstraints = (doHardConstraints ? isConstrained : Eigen::VectorXi::Zero(data.numF));
+  Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> Ak_ = (doHardConstraints ? Ak : Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>());
+  Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> Bk_ = (doHardConstraints ? Bk : Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1>());
+
+  //the same data and constrained faces as the previous solve with this state: only the known values change
+  if ((state.setupData==&data) && (state.setupConstraints.size()==solveConstraints.size()) && (state.setupConstraints==solveConstraints))
+  {
+    state.solverA.set_known_values(Ak_);
+    state.solverB.set_known_values(Bk_);
+    return;
   }
+
+  Eigen::Matrix<typename DerivedV::Scalar, Eigen::Dynamic, 1> w = Eigen::Matrix<typename DerivedV::Scalar, Eigen::Dynamic, 1>::Ones(data.numF);
+  state.solverA.setup(data.DDA, w, solveConstraints, Ak_, report);
+  state.solverB.setup(data.DDB, w, solveConstraints, Bk_, report);
+  state.setupData = &data;
+  state.setupConstraints = solveConstraints;
 }
 
 
@@ -509,26 +598,12 @@ globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
 {
   setCoefficientsFromField();
 
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > I;
-  igl::speye(data.numF, data.numF, I);
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > QA = data.DDA+lambda*I;
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > fA = (-2*lambda*Acoeff).sparseView();
+  Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> fA = -2*lambda*Acoeff;
+  Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> fB = -2*lambda*Bcoeff;
 
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > QB = data.DDB+lambda*I;
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > fB = (-2*lambda*I*Bcoeff).sparseView();
+  state.solverA.solve(lambda, fA, Acoeff, report);
+  state.solverB.solve(lambda, fB, Bcoeff, report);
 
-  if(doHardConstraints)
-  {
-    minQuadWithKnownMini(QA, fA, isConstrained, Ak, Acoeff);
-    minQuadWithKnownMini(QB, fB, isConstrained, Bk, Bcoeff);
-  }
-  else
-  {
-    Eigen::Matrix<int, Eigen::Dynamic, 1>isknown_; isknown_.setZero(data.numF,1);
-    Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> xknown_; xknown_.setZero(0,1);
-    minQuadWithKnownMini(QA, fA, isknown_, xknown_, Acoeff);
-    minQuadWithKnownMini(QB, fB, isknown_, xknown_, Bcoeff);
-  }
   setFieldFromCoefficients();
 
 }
@@ -538,7 +613,7 @@ template<typename DerivedV, typename DerivedF, typename DerivedO>
 IGL_INLINE void igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
 setFieldFromCoefficients()
 {
-  for (int i = 0; i <data.numF; ++i)
+  igl::parallel_for(data.numF, [&](const int i)
   {
     //    poly coefficients: 1, 0, -Acoeff, 0, Bcoeff
     //    matlab code from roots (given there are no trailing zeros in the polynomial coefficients)
@@ -563,76 +638,10 @@ setFieldFromCoefficients()
     std::complex<typename DerivedV::Scalar> v = roots[maxi];
     pvU(i,0) = real(u); pvU(i,1) = imag(u);
     pvV(i,0) = real(v); pvV(i,1) = imag(v);
-  }
+  }, 1000);
 
 }
 
-template<typename DerivedV, typename DerivedF, typename DerivedO>
-IGL_INLINE void igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
-minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > &Q,
-                     const Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > &f,
-                     const Eigen::VectorXi isConstrained,
-                     const Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> &xknown,
-                     Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> &x)
-{
-  int N = Q.rows();
-
-  int nc = xknown.rows();
-  Eigen::VectorXi known; known.setZero(nc,1);
-  Eigen::VectorXi unknown; unknown.setZero(N-nc,1);
-
-  int indk = 0, indu = 0;
-  for (int i = 0; i<N; ++i)
-    if (isConstrained[i])
-    {
-      known[indk] = i;
-      indk++;
-    }
-    else
-    {
-      unknown[indu] = i;
-      indu++;
-    }
-
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar>> Quu, Quk;
-
-  igl::slice(Q,unknown, unknown, Quu);
-  igl::slice(Q,unknown, known, Quk);
-
-
-  std::vector<typename Eigen::Triplet<std::complex<typename DerivedV::Scalar> > > tripletList;
-
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > fu(N-nc,1);
-
-  igl::slice(f,unknown, Eigen::VectorXi::Zero(1,1), fu);
-
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar> > rhs = (Quk*xknown).sparseView()+.5*fu;
-
-  Eigen::SparseLU< Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar>>> solver;
-  solver.compute(-Quu);
-  if(solver.info()!=Eigen::Success)
-  {
-    std::cerr<<"Decomposition failed!"<<std::endl;
-    return;
-  }
-  Eigen::SparseMatrix<std::complex<typename DerivedV::Scalar>>  b  = solver.solve(rhs);
-  if(solver.info()!=Eigen::Success)
-  {
-    std::cerr<<"Solving failed!"<<std::endl;
-    return;
-  }
-
-  indk = 0, indu = 0;
-  x.setZero(N,1);
-  for (int i = 0; i<N; ++i)
-    if (isConstrained[i])
-      x[i] = xknown[indk++];
-    else
-      x[i] = b.coeff(indu++,0);
-
-}
-
-
 template<typename DerivedV, typename DerivedF, typename DerivedO>
 IGL_INLINE bool igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO>::
 solve(const Eigen::VectorXi &isConstrained,
@@ -671,35 +680,40 @@ solve(const Eigen::VectorXi &isConstrained,
 
 
 
-  typename DerivedV::Scalar smoothnessValue;
-  int oob;
+  setupGlobalStep(isConstrained, Ak, Bk);
 
-  smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
-  printf("\n\nInitial smoothness: %.5g\n",smoothnessValue);
-  oob = getNumOutOfBounds();
-  printf("\n\nInitial out-of-bounds: %d\n",oob);
-  printf(" %d %.5g %d\n",-1, smoothnessValue, oob);
+  int oob = getNumOutOfBounds();
+  if (verbose)
+  {
+    typename DerivedV::Scalar smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
+    std::cout<<"Initial smoothness: "<<smoothnessValue<<", out-of-bounds: "<<oob<<std::endl;
+  }
 
   lambda = lambdaInit;
   for (int iter = 0; iter<maxIter; ++iter)
   {
-    printf("\n\n--- Iteration %d ---\n",iter);
+    Eigen::Matrix<std::complex<typename DerivedV::Scalar>, Eigen::Dynamic, 1> prevAcoeff = Acoeff, prevBcoeff = Bcoeff;
 
     localStep();
     globalStep(isConstrained, Ak, Bk);
 
+    oob = getNumOutOfBounds();
 
-    smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
-
-    printf("Smoothness: %.5g\n",smoothnessValue);
+    //the relative change of the coefficients in this iteration
+    typename DerivedV::Scalar change = std::sqrt(((Acoeff-prevAcoeff).squaredNorm()+(Bcoeff-prevBcoeff).squaredNorm())/
+                                                 std::max((typename DerivedV::Scalar)1e-12, prevAcoeff.squaredNorm()+prevBcoeff.squaredNorm()));
 
-    oob = getNumOutOfBounds();
+    if (verbose)
+    {
+      typename DerivedV::Scalar smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
+      std::cout<<"Iteration "<<iter<<": smoothness: "<<smoothnessValue<<", out-of-bounds: "<<oob<<", change: "<<change<<std::endl;
+    }
 
-    bool stoppingCriterion = (oob == 0) ;
+    //stopping when all angles are within bounds, or when the iterations stagnate
+    bool stoppingCriterion = (oob == 0) || (change < convergenceTol);
     if (stoppingCriterion)
       break;
     lambda = lambda*lambdaMultFactor;
-//    printf(" %d %.5g %d\n",iter, smoothnessValue, oob);
 
   }
 
@@ -731,10 +745,12 @@ IGL_INLINE bool igl::angle_bound_frame_fields(const Eigen::PlainObjectBase<Deriv
                                             int maxIter,
                                             const typename DerivedV::Scalar &lambdaInit,
                                             const typename DerivedV::Scalar &lambdaMultFactor,
-                                              const bool doHardConstraints)
+                                              const bool doHardConstraints,
+                                              const typename DerivedV::Scalar &convergenceTol,
+                                              const bool verbose)
 {
   igl::AngleBoundFFSolverData<DerivedV, DerivedF> csdata(V, F);
-  igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO> cs(csdata, thetaMin, maxIter, lambdaInit, lambdaMultFactor, doHardConstraints);
+  igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO> cs(csdata, thetaMin, maxIter, lambdaInit, lambdaMultFactor, doHardConstraints, convergenceTol, verbose);
   return (cs.solve(isConstrained, initialSolution, output));
 }
 
@@ -748,9 +764,31 @@ IGL_INLINE bool igl::angle_bound_frame_fields(const igl::AngleBoundFFSolverData<
                                             const typename DerivedV::Scalar &lambdaInit,
                                             const typename DerivedV::Scalar &lambdaMultFactor,
                                               const bool doHardConstraints,
-                                            typename DerivedV::Scalar *lambdaOut)
+                                            typename DerivedV::Scalar *lambdaOut,
+                                              const typename DerivedV::Scalar &convergenceTol,
+                                              const bool verbose)
+{
+  igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO> cs(csdata, thetaMin, maxIter, lambdaInit, lambdaMultFactor, doHardConstraints, convergenceTol, verbose);
+  return (cs.solve(isConstrained, initialSolution, output, lambdaOut));
+}
+
+template <typename DerivedV, typename DerivedF, typename DerivedO>
+IGL_INLINE bool igl::angle_bound_frame_fields(const igl::AngleBoundFFSolverData<DerivedV, DerivedF> &csdata,
+                                              igl::AngleBoundFFSolverState<DerivedV, DerivedF> &state,
+                                              const typename DerivedV::Scalar &thetaMin,
+                                              const Eigen::VectorXi &isConstrained,
+                                              const Eigen::PlainObjectBase<DerivedO> &initialSolution,
+                                              Eigen::PlainObjectBase<DerivedO> &output,
+                                              int maxIter,
+                                              const typename DerivedV::Scalar &lambdaInit,
+                                              const typename DerivedV::Scalar &lambdaMultFactor,
+                                              const bool doHardConstraints,
+                                              typename DerivedV::Scalar *lambdaOut,
+                                              const typename DerivedV::Scalar &convergenceTol,
+                                              const bool verbose,
+                                              directional::ProfileReport* report)
 {
-  igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO> cs(csdata, thetaMin, maxIter, lambdaInit, lambdaMultFactor, doHardConstraints);
+  igl::AngleBoundFFSolver<DerivedV, DerivedF, DerivedO> cs(csdata, state, thetaMin, maxIter, lambdaInit, lambdaMultFactor, doHardConstraints, convergenceTol, verbose, report);
   return (cs.solve(isConstrained, initialSolution, output, lambdaOut));
 }
 
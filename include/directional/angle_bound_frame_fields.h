@@ -8,10 +8,11 @@
 
 #ifndef IGL_ANGLE_BOUND_FRAME_FIELDS_H
 #define IGL_ANGLE_BOUND_FRAME_FIELDS_H
-#include "igl_inline.h"
+#include <igl/igl_inline.h>
 
 #include <Eigen/Core>
 #include <vector>
+#include <directional/ProfileReport.h>
 
 namespace igl {
   //todo
@@ -26,6 +27,16 @@ namespace igl {
   template <typename DerivedV, typename DerivedF>
   class AngleBoundFFSolverData;
 
+  // The factorized global step systems of the solver, kept by the caller to be reused across solves on the same data (for instance,
+  // in batch processing). Their pattern is only analyzed again when the data or the set of constrained faces changes; otherwise only
+  // the constrained values are replaced, and the factorization is kept as long as lambda does not change.
+  // A state is used by a single solve at a time: concurrent solves need a state each.
+  template <typename DerivedV, typename DerivedF>
+  class AngleBoundFFSolverState;
+
+  // The iterations stop when no angle is below thetaMin, or when the relative change of the field coefficients in an
+  // iteration falls below _convergenceTol. _verbose prints the smoothness and the number of out-of-bound faces per iteration.
+
   template <typename DerivedV, typename DerivedF, typename DerivedO>
   IGL_INLINE bool angle_bound_frame_fields(const Eigen::PlainObjectBase<DerivedV> &V,
                                          const Eigen::PlainObjectBase<DerivedF> &F,
@@ -36,7 +47,9 @@ namespace igl {
                                          int _maxIter = 50,
                                          const typename DerivedV::Scalar &_lambdaInit = 100,
                                          const typename DerivedV::Scalar &_lambdaMultFactor = 1.5,
-                                           const bool _doHardConstraints = false);
+                                           const bool _doHardConstraints = false,
+                                           const typename DerivedV::Scalar &_convergenceTol = 1e-6,
+                                           const bool _verbose = false);
 
   template <typename DerivedV, typename DerivedF, typename DerivedO>
   IGL_INLINE bool angle_bound_frame_fields(const AngleBoundFFSolverData<DerivedV, DerivedF> &csdata,
@@ -48,7 +61,27 @@ namespace igl {
                                          const typename DerivedV::Scalar &_lambdaInit = 100,
                                          const typename DerivedV::Scalar &_lambdaMultFactor = 1.5,
                                            const bool _doHardConstraints = false,
-                                         typename DerivedV::Scalar *lambdaOut = NULL);
+                                         typename DerivedV::Scalar *lambdaOut = NULL,
+                                           const typename DerivedV::Scalar &_convergenceTol = 1e-6,
+                                           const bool _verbose = false);
+
+  // The same, reusing the global step systems in state from previous solves with the same data and constrained faces.
+  // The pattern analyses and factorizations are counted in report, if given.
+  template <typename DerivedV, typename DerivedF, typename DerivedO>
+  IGL_INLINE bool angle_bound_frame_fields(const AngleBoundFFSolverData<DerivedV, DerivedF> &csdata,
+                                           AngleBoundFFSolverState<DerivedV, DerivedF> &state,
+                                           const typename DerivedV::Scalar &thetaMin,
+                                           const Eigen::VectorXi &isConstrained,
+                                           const Eigen::PlainObjectBase<DerivedO> &initialSolution,
+                                           Eigen::PlainObjectBase<DerivedO> &output,
+                                           int _maxIter = 50,
+                                           const typename DerivedV::Scalar &_lambdaInit = 100,
+                                           const typename DerivedV::Scalar &_lambdaMultFactor = 1.5,
+                                           const bool _doHardConstraints = false,
+                                           typename DerivedV::Scalar *lambdaOut = NULL,
+                                           const typename DerivedV::Scalar &_convergenceTol = 1e-6,
+                                           const bool _verbose = false,
+                                           directional::ProfileReport* report = NULL);
 
 };
 
@@ -17,6 +17,7 @@
 #include <directional/CartesianField.h>
 #include <directional/tree.h>
 #include <directional/principal_matching.h>
+#include <directional/ProfileReport.h>
 
 namespace directional
 {
@@ -25,14 +26,17 @@ namespace directional
   // Input:
   //  rawField:   a RAW_FIELD uncombed cartesian field object
   //  _spaceIsCut: #F x |maxOneRing| optionally prescribing the TB edges (corresponding to mesh faces) that must be a seam.
+  //  report:     optional profiling report.
   // Output:
   //  combedField: the combed field object, also RAW_FIELD
   
   IGL_INLINE void combing(const directional::CartesianField& rawField,
                           directional::CartesianField& combedField,
-                          const Eigen::MatrixXi& _spaceIsCut=Eigen::MatrixXi())
+                          const Eigen::MatrixXi& _spaceIsCut=Eigen::MatrixXi(),
+                          directional::ProfileReport* report=NULL)
   {
     using namespace Eigen;
+    directional::ScopedTimer timer(report, "combing");
     combedField.init(*(rawField.tb), fieldTypeEnum::RAW_FIELD, rawField.N);
     Eigen::MatrixXi spaceIsCut(rawField.intField.rows(),3);
     if (_spaceIsCut.rows()==0)
@@ -85,7 +89,7 @@ namespace directional
     }
 
     //TODO: only update effort.
-    principal_matching(combedField);
+    principal_matching(combedField, report);
   }
 }
 
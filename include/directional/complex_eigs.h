@@ -8,6 +8,11 @@
 #ifndef DIRECTIONAL_COMPLEX_EIGS_H
 #define DIRECTIONAL_COMPLEX_EIGS_H
 
+#include <complex>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <igl/igl_inline.h>
+#include <igl/eigs.h>
 
 namespace directional {
 
@@ -7,11 +7,12 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <directional/conjugate_frame_fields.h>
-#include <igl/speye.h>
-#include <igl/slice.h>
+#include <igl/parallel_for.h>
 #include <directional/polyroots.h>
 #include <directional/polyvector_to_raw.h>
 #include <directional/ccw_reorient_field.h>
+#include <directional/DiagonalShiftSolver.h>
+#include <directional/ProfileReport.h>
 #include <Eigen/Sparse>
 
 #include <iostream>
@@ -25,7 +26,9 @@ namespace directional {
                                      const double _lambdaOrtho = .05,
                                      const double _lambdaInit = 100,
                                      const double _lambdaMultFactor = 1.01,
-                                     bool _doHardConstraints = true);
+                                     bool _doHardConstraints = true,
+                                     const bool _verbose = false,
+                                     directional::ProfileReport* _report = NULL);
         IGL_INLINE double solve(const Eigen::VectorXi &isConstrained,
                                 const Eigen::MatrixXd &initialSolution,
                                 Eigen::MatrixXd &output);
@@ -44,6 +47,12 @@ namespace directional {
         double lambdaInit,lambdaMultFactor;
         int maxIter;
         bool doHardConstraints;
+        bool verbose;
+        directional::ProfileReport* report;
+
+        //the global step systems: Q=DDA+lambdaOrtho*I+lambda*W for A, and Q=DDB+lambda*W for B, with W the (diagonal) planarity weights
+        directional::DiagonalShiftSolver<double> solverA, solverB;
+        Eigen::VectorXd planarityDiagonal;
 
         IGL_INLINE void localStep();
         IGL_INLINE void getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
@@ -53,11 +62,9 @@ namespace directional {
         IGL_INLINE void globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
                                    const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
                                    const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk);
-        IGL_INLINE void minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<double> > &Q,
-                                             const Eigen::SparseMatrix<std::complex<double> > &f,
-                                             const Eigen::VectorXi isConstrained,
-                                             const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &xknown,
-                                             Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &x);
+        IGL_INLINE void setupGlobalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
+                                        const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
+                                        const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk);
         IGL_INLINE void setFieldFromCoefficients();
         IGL_INLINE void setCoefficientsFromField();
 
@@ -71,13 +78,17 @@ IGL_INLINE directional::ConjugateFFSolver::ConjugateFFSolver(const ConjugateFFSo
                                                              const double _lambdaOrtho,
                                                              const double _lambdaInit,
                                                              const double _lambdaMultFactor,
-                                                             bool _doHardConstraints):
+                                                             bool _doHardConstraints,
+                                                             const bool _verbose,
+                                                             directional::ProfileReport* _report):
         data(_data),
         lambdaOrtho(_lambdaOrtho),
         lambdaInit(_lambdaInit),
         maxIter(_maxIter),
         lambdaMultFactor(_lambdaMultFactor),
-        doHardConstraints(_doHardConstraints)
+        doHardConstraints(_doHardConstraints),
+        verbose(_verbose),
+        report(_report)
 {
     Acoeff.resize(data.numF,1);
     Bcoeff.resize(data.numF,1);
@@ -115,18 +126,18 @@ getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
 
 IGL_INLINE void directional::ConjugateFFSolver::localStep()
 {
-    for (int j =0; j<data.numF; ++j)
+    directional::ScopedTimer timer(report, "conjugate_frame_fields.local_step");
+    //every face is projected independently
+    igl::parallel_for(data.numF, [&](const int j)
     {
         Eigen::Matrix<double, 4, 1> xproj; xproj << pvU.row(j).transpose(),pvV.row(j).transpose();
         Eigen::Matrix<double, 4, 1> z = data.UH[j].transpose()*xproj;
-        Eigen::Matrix<double, 4, 1> x;
+        Eigen::Matrix<double, 4, 1> x = xproj;
 
         Eigen::Matrix<double, Eigen::Dynamic, 1> polyCoeff;
         getPolyCoeffsForLocalSolve(data.s[j], z, polyCoeff);
         Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> roots;
 
-        //directional::polyvector_to_raw(data.B1(j),data.B2(j), polyCoeff,4,roots);
-
         igl::polyRoots<double, double> (polyCoeff, roots);
 
         //  find closest real root to xproj
@@ -135,8 +146,7 @@ IGL_INLINE void directional::ConjugateFFSolver::localStep()
         {
             if (fabs(imag(roots[i]))>1e-10)
                 continue;
-            Eigen::Matrix<double, 4, 4> D = ((Eigen::Matrix<double, 4, 1>::Ones()+real(roots(i))*data.s[j]).array().inverse()).matrix().asDiagonal();
-            Eigen::Matrix<double, 4, 1> candidate = data.UH[j]*D*z;
+            Eigen::Matrix<double, 4, 1> candidate = data.UH[j]*(z.array()/(1.0+real(roots(i))*data.s[j].array())).matrix();
             double dist = (candidate-xproj).norm();
             if (dist<minDist)
             {
@@ -148,48 +158,60 @@ IGL_INLINE void directional::ConjugateFFSolver::localStep()
 
         pvU.row(j) << x(0),x(1);
         pvV.row(j) << x(2),x(3);
-    }
+    }, 1000);
 }
 
 
 IGL_INLINE void directional::ConjugateFFSolver::setCoefficientsFromField()
 {
-    for (int i = 0; i <data.numF; ++i)
+    igl::parallel_for(data.numF, [&](const int i)
     {
         std::complex<double> u(pvU(i,0),pvU(i,1));
         std::complex<double> v(pvV(i,0),pvV(i,1));
         Acoeff(i) = u*u+v*v;
         Bcoeff(i) = u*u*v*v;
-    }
+    }, 1000);
 }
 
 
-IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
-                                                           const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
-                                                           const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk)
+IGL_INLINE void directional::ConjugateFFSolver::setupGlobalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
+                                                                const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
+                                                                const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk)
 {
-    setCoefficientsFromField();
-
-    Eigen::SparseMatrix<std::complex<double> > I;
-    igl::speye(data.numF, data.numF, I);
-    Eigen::SparseMatrix<std::complex<double> > QA = data.DDA+lambda*data.planarityWeight+lambdaOrtho*I;
-    Eigen::SparseMatrix<std::complex<double> > fA = (-2*lambda*data.planarityWeight*Acoeff).sparseView();
-
-    Eigen::SparseMatrix<std::complex<double> > QB = data.DDB+lambda*data.planarityWeight;
-    Eigen::SparseMatrix<std::complex<double> > fB = (-2*lambda*data.planarityWeight*Bcoeff).sparseView();
+    //only the lambda*W term changes between iterations: the systems are sliced and analyzed once per solve
+    planarityDiagonal = data.planarityWeight.diagonal().real();
+    Eigen::SparseMatrix<std::complex<double> > I(data.numF, data.numF);
+    I.setIdentity();
+    Eigen::SparseMatrix<std::complex<double> > QA0 = data.DDA+lambdaOrtho*I;
 
     if(doHardConstraints)
     {
-        minQuadWithKnownMini(QA, fA, isConstrained, Ak, Acoeff);
-        minQuadWithKnownMini(QB, fB, isConstrained, Bk, Bcoeff);
+        solverA.setup(QA0, planarityDiagonal, isConstrained, Ak, report);
+        solverB.setup(data.DDB, planarityDiagonal, isConstrained, Bk, report);
     }
     else
     {
         Eigen::Matrix<int, Eigen::Dynamic, 1>isknown_; isknown_.setZero(data.numF,1);
         Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> xknown_; xknown_.setZero(0,1);
-        minQuadWithKnownMini(QA, fA, isknown_, xknown_, Acoeff);
-        minQuadWithKnownMini(QB, fB, isknown_, xknown_, Bcoeff);
+        solverA.setup(QA0, planarityDiagonal, isknown_, xknown_, report);
+        solverB.setup(data.DDB, planarityDiagonal, isknown_, xknown_, report);
     }
+}
+
+
+IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
+                                                           const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
+                                                           const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk)
+{
+    directional::ScopedTimer timer(report, "conjugate_frame_fields.global_step");
+    setCoefficientsFromField();
+
+    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> fA = -2*lambda*planarityDiagonal.cast<std::complex<double> >().cwiseProduct(Acoeff);
+    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> fB = -2*lambda*planarityDiagonal.cast<std::complex<double> >().cwiseProduct(Bcoeff);
+
+    solverA.solve(lambda, fA, Acoeff, report);
+    solverB.solve(lambda, fB, Bcoeff, report);
+
     setFieldFromCoefficients();
 
 }
@@ -197,7 +219,7 @@ IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<i
 
 IGL_INLINE void directional::ConjugateFFSolver::setFieldFromCoefficients()
 {
-    for (int i = 0; i <data.numF; ++i)
+    igl::parallel_for(data.numF, [&](const int i)
     {
         //    poly coefficients: 1, 0, -Acoeff, 0, Bcoeff
         //    matlab code from roots (given there are no trailing zeros in the polynomial coefficients)
@@ -222,78 +244,15 @@ IGL_INLINE void directional::ConjugateFFSolver::setFieldFromCoefficients()
         std::complex<double> v = roots[maxi];
         pvU(i,0) = real(u); pvU(i,1) = imag(u);
         pvV(i,0) = real(v); pvV(i,1) = imag(v);
-    }
-
-}
-
-IGL_INLINE void directional::ConjugateFFSolver::minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<double> > &Q,
-                                                                     const Eigen::SparseMatrix<std::complex<double> > &f,
-                                                                     const Eigen::VectorXi isConstrained,
-                                                                     const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &xknown,
-                                                                     Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &x)
-{
-    int N = Q.rows();
-
-    int nc = xknown.rows();
-    Eigen::VectorXi known; known.setZero(nc,1);
-    Eigen::VectorXi unknown; unknown.setZero(N-nc,1);
-
-    int indk = 0, indu = 0;
-    for (int i = 0; i<N; ++i)
-        if (isConstrained[i])
-        {
-            known[indk] = i;
-            indk++;
-        }
-        else
-        {
-            unknown[indu] = i;
-            indu++;
-        }
-
-    Eigen::SparseMatrix<std::complex<double>> Quu, Quk;
-
-    igl::slice(Q,unknown, unknown, Quu);
-    igl::slice(Q,unknown, known, Quk);
-
-
-    std::vector<typename Eigen::Triplet<std::complex<double> > > tripletList;
-
-    Eigen::SparseMatrix<std::complex<double> > fu(N-nc,1);
-
-    igl::slice(f,unknown, Eigen::VectorXi::Zero(1,1), fu);
-
-    Eigen::SparseMatrix<std::complex<double> > rhs = (Quk*xknown).sparseView()+.5*fu;
-
-    Eigen::SparseLU< Eigen::SparseMatrix<std::complex<double>>> solver;
-    solver.compute(-Quu);
-    if(solver.info()!=Eigen::Success)
-    {
-        std::cerr<<"Decomposition failed!"<<std::endl;
-        return;
-    }
-    Eigen::SparseMatrix<std::complex<double>>  b  = solver.solve(rhs);
-    if(solver.info()!=Eigen::Success)
-    {
-        std::cerr<<"Solving failed!"<<std::endl;
-        return;
-    }
-
-    indk = 0, indu = 0;
-    x.setZero(N,1);
-    for (int i = 0; i<N; ++i)
-        if (isConstrained[i])
-            x[i] = xknown[indk++];
-        else
-            x[i] = b.coeff(indu++,0);
+    }, 1000);
 
 }
 
-
 IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &isConstrained,
                                                         const Eigen::MatrixXd &initialSolution,
                                                         Eigen::MatrixXd &output)
 {
+    directional::ScopedTimer timer(report, "conjugate_frame_fields.solve");
     int numConstrained = isConstrained.sum();
     // coefficient values
     Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> Ak, Bk;
@@ -325,7 +284,8 @@ IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &i
 
 
 
-    double smoothnessValue;
+    setupGlobalStep(isConstrained, Ak, Bk);
+
     Eigen::Matrix<double, Eigen::Dynamic, 1> conjValues;
     double meanConj;
     double maxConj;
@@ -333,32 +293,30 @@ IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &i
     data.evaluateConjugacy(pvU, pvV, conjValues);
     meanConj = conjValues.cwiseAbs().mean();
     maxConj = conjValues.cwiseAbs().maxCoeff();
-    printf("Initial max non-conjugacy: %.5g\n",maxConj);
-
-    smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
-    printf("\n\nInitial smoothness: %.5g\n",smoothnessValue);
+    if (verbose){
+        double smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
+        std::cout<<"Initial max non-conjugacy: "<<maxConj<<", smoothness: "<<smoothnessValue<<std::endl;
+    }
 
     lambda = lambdaInit;
 
     bool doit = false;
+    int numIterations = 0;
     for (int iter = 0; iter<maxIter; ++iter)
     {
-        printf("\n\n--- Iteration %d ---\n",iter);
-
         double oldMeanConj = meanConj;
+        numIterations++;
 
         localStep();
         globalStep(isConstrained, Ak, Bk);
 
-
-        smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
-
-        printf("Smoothness: %.5g\n",smoothnessValue);
-
         data.evaluateConjugacy(pvU, pvV, conjValues);
         meanConj = conjValues.cwiseAbs().mean();
         maxConj = conjValues.cwiseAbs().maxCoeff();
-        printf("Mean/Max non-conjugacy: %.5g, %.5g\n",meanConj,maxConj);
+        if (verbose){
+            double smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
+            std::cout<<"Iteration "<<iter<<": smoothness: "<<smoothnessValue<<", mean/max non-conjugacy: "<<meanConj<<", "<<maxConj<<", lambda: "<<lambda<<std::endl;
+        }
         double diffMeanConj = fabs(oldMeanConj-meanConj);
 
         if (diffMeanConj<1e-4)
@@ -366,9 +324,10 @@ IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &i
 
         if (doit)
             lambda = lambda*lambdaMultFactor;
-        printf(" %d %.5g %.5g\n",iter, smoothnessValue,maxConj);
 
     }
+    if (report)
+        report->add_counter("conjugate_frame_fields.iterations", numIterations);
 
     output.setZero(data.numF,6);
     for (int fi=0; fi<data.numF; ++fi)
@@ -392,14 +351,16 @@ IGL_INLINE void directional::conjugate_frame_fields(const directional::TriMesh&
                                                     const double lambdaOrtho,
                                                     const double lambdaInit,
                                                     const double lambdaMultFactor,
-                                                    bool doHardConstraints)
+                                                    bool doHardConstraints,
+                                                    const bool verbose,
+                                                    directional::ProfileReport* report)
 {
     Eigen::VectorXi isConstrained = Eigen::VectorXi::Constant(initialSolution.extField.rows(),0);
     for (unsigned i=0; i<b.size(); ++i)
         isConstrained(b(i)) = 1;
     Eigen::MatrixXd twoFieldMat =initialSolution.extField.block(0,0,initialSolution.extField.rows(),6);
     directional::ConjugateFFSolverData csdata(mesh);
-    directional::ConjugateFFSolver cs(csdata, maxIter, lambdaOrtho, lambdaInit, lambdaMultFactor, doHardConstraints);
+    directional::ConjugateFFSolver cs(csdata, maxIter, lambdaOrtho, lambdaInit, lambdaMultFactor, doHardConstraints, verbose, report);
     Eigen::MatrixXd outputExtField;
     cs.solve(isConstrained, twoFieldMat, outputExtField);
     outputExtField.conservativeResize(outputExtField.rows(), 2*outputExtField.cols());
@@ -422,13 +383,15 @@ IGL_INLINE double directional::conjugate_frame_fields(const directional::Conjuga
                                                       const double lambdaOrtho,
                                                       const double lambdaInit,
                                                       const double lambdaMultFactor,
-                                                      bool doHardConstraints)
+                                                      bool doHardConstraints,
+                                                      const bool verbose,
+                                                      directional::ProfileReport* report)
 {
     Eigen::VectorXi isConstrained = Eigen::VectorXi::Constant(initialSolution.extField.rows(),0);
     for (unsigned i=0; i<b.size(); ++i)
         isConstrained(b(i)) = 1;
     Eigen::MatrixXd twoFieldMat =initialSolution.extField.block(0,0,initialSolution.extField.rows(),6);
-    directional::ConjugateFFSolver cs(csdata, maxIter, lambdaOrtho, lambdaInit, lambdaMultFactor, doHardConstraints);
+    directional::ConjugateFFSolver cs(csdata, maxIter, lambdaOrtho, lambdaInit, lambdaMultFactor, doHardConstraints, verbose, report);
     Eigen::MatrixXd outputExtField;
     double lambdaOut = cs.solve(isConstrained, twoFieldMat, outputExtField);
 
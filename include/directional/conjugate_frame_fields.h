@@ -12,6 +12,7 @@
 
 #include <igl/igl_inline.h>
 #include "ConjugateFFSolverData.h"
+#include <directional/ProfileReport.h>
 #include <Eigen/Core>
 #include <vector>
 
@@ -28,7 +29,9 @@ namespace directional {
                                            const double _lambdaOrtho = .1,
                                            const double _lambdaInit = 10,
                                            const double _lambdaMultFactor = 1.01,
-                                           bool _doHardConstraints = true);
+                                           bool _doHardConstraints = true,
+                                           const bool verbose = false,
+                                           directional::ProfileReport* report = NULL);
 
     IGL_INLINE double conjugate_frame_fields(const ConjugateFFSolverData &csdata,
                                              const Eigen::VectorXi &isConstrained,
@@ -38,7 +41,9 @@ namespace directional {
                                              const double _lambdaOrtho = .1,
                                              const double _lambdaInit = 10,
                                              const double _lambdaMultFactor = 1.01,
-                                             bool _doHardConstraints = true);
+                                             bool _doHardConstraints = true,
+                                             const bool verbose = false,
+                                             directional::ProfileReport* report = NULL);
 
 };
 
@@ -11,10 +11,14 @@
 
 #include <vector>
 #include <cmath>
+#include <complex>
+#include <algorithm>
 #include <Eigen/Core>
 #include <igl/igl_inline.h>
+#include <igl/parallel_for.h>
 #include <directional/TriMesh.h>
 #include <directional/CartesianField.h>
+#include <directional/IntrinsicFaceTangentBundle.h>
 #include <directional/effort_to_indices.h>
 
 namespace directional
@@ -38,34 +42,34 @@ namespace directional
         //this only works on face-based fields for now
         assert(rawField.tb->discTangType()==discTangTypeEnum::FACE_SPACES && "This function only supports face-based fields for now.");
         IntrinsicFaceTangentBundle* ftb = (IntrinsicFaceTangentBundle*)(rawField.tb);
-        rawField.matching.conservativeResize(ftb->mesh->EF.rows());
+        const TriMesh& mesh = *(ftb->mesh);
+        const int N = rawField.N;
+        rawField.matching.conservativeResize(mesh.EF.rows());
         rawField.matching.setConstant(-1);
-        curlNorm.conservativeResize(ftb->mesh->EF.rows());
-
-        MatrixXd edgeVectors(ftb->mesh->EF.rows(), 3);
-        for (int i = 0; i < ftb->mesh->EF.rows(); i++) {
-            if (ftb->mesh->EF(i, 0) == -1 || ftb->mesh->EF(i, 1) == -1)
-                continue;
-            edgeVectors.row(i) = (ftb->mesh->V.row(ftb->mesh->EV(i, 1)) - ftb->mesh->V.row(ftb->mesh->EV(i, 0))).normalized();
-
-        }
-
-        //effort = VectorXd::Zero(rawField.mesh->EF.rows());
-        for (int i = 0; i < ftb->mesh->EF.rows(); i++) {
-            if (ftb->mesh->EF(i, 0) == -1 || ftb->mesh->EF(i, 1) == -1)
-                continue;
-            //computing free coefficient effort (a.k.a. [Diamanti et al. 2014])
-            //Complex freeCoeffEffort(1.0, 0.0);
+        rawField.effort = VectorXd::Zero(mesh.EF.rows());
+        curlNorm = VectorXd::Zero(mesh.EF.rows());
+
+        //edges are independent
+        igl::parallel_for(mesh.EF.rows(), [&](const int i){
+            if (mesh.EF(i, 0) == -1 || mesh.EF(i, 1) == -1)
+                return;
+
+            //projecting the vectors of both faces on the edge once. The curl of matching 0->j is then sum_k (proj1(j+k)-proj0(k))^2,
+            //which expands into the squared norms and the cyclic correlation of the two projections.
+            RowVector3d edgeVector = (mesh.V.row(mesh.EV(i, 1)) - mesh.V.row(mesh.EV(i, 0))).normalized();
+            VectorXd proj0(N), proj1(N);
+            for (int k=0;k<N;k++){
+                proj0(k) = edgeVector.dot(rawField.extField.block<1,3>(mesh.EF(i, 0), 3*k));
+                proj1(k) = edgeVector.dot(rawField.extField.block<1,3>(mesh.EF(i, 1), 3*k));
+            }
+            double sumSquares = proj0.squaredNorm() + proj1.squaredNorm();
+
+            //finding where the 0 vector in EF(i,0) goes to with the smallest curl in EF(i,1)
             int indexMinFromZero=0;
-            //finding where the 0 vector in EF(i,0) goes to with smallest rotation angle in EF(i,1), computing the effort, and then adjusting the matching to have principal effort.
             double minCurl = 32767000.0;
-            for (int j = 0; j < rawField.N; j++) {
-                double currCurl = 0;
-                for (int k=0;k<rawField.N;k++){
-                    RowVector3d vecDiff =rawField.extField.block(ftb->mesh->EF(i, 1), 3 * ((j+k)%rawField.N), 1, 3)-rawField.extField.block(ftb->mesh->EF(i, 0), 3*k, 1, 3);
-                    currCurl +=pow(edgeVectors.row(i).dot(vecDiff),2.0);
-                }
-
+            for (int j = 0; j < N; j++) {
+                double correlation = proj0.head(N-j).dot(proj1.tail(N-j)) + proj0.tail(j).dot(proj1.head(j));
+                double currCurl = sumSquares - 2.0*correlation;
                 if (currCurl < minCurl){
                     indexMinFromZero=j;
                     minCurl=currCurl;
@@ -73,24 +77,21 @@ namespace directional
             }
 
             rawField.matching(i) =indexMinFromZero;
-            curlNorm(i)= sqrt(minCurl);
+            curlNorm(i)= sqrt(std::max(minCurl, 0.0));
 
-            //computing the full effort for 0->indexMinFromZero, and readjusting the matching to fit principal effort
+            //computing the full effort, which is the argument of the product of all ratios between matched vectors (and thus does not depend on the matching)
             Complex freeCoeff(1,0);
-            rawField.effort.resize(rawField.matching.size());
-            for (int j = 0; j < rawField.N; j++) {
-                //RowVector3d vecjf = rawField.extField.block(rawField.adjSpaces(i, 0), 3*j, 1, 3);
-                RowVector2d vecjf = rawField.intField.block(ftb->adjSpaces(i, 0), 2 * j, 1, 2);
-                Complex vecjfc = Complex(vecjf(0),vecjf(1));
-                RowVector2d vecjg = rawField.intField.block(ftb->adjSpaces(i, 1), 2 * (rawField.matching(i)+j+rawField.N)%rawField.N, 1, 2);
-                Complex vecjgc = Complex(vecjg(0),vecjg(1));
+            for (int j = 0; j < N; j++) {
+                Complex vecjfc = Complex(rawField.intField(ftb->adjSpaces(i, 0), 2*j), rawField.intField(ftb->adjSpaces(i, 0), 2*j+1));
+                Complex vecjgc = Complex(rawField.intField(ftb->adjSpaces(i, 1), 2*((indexMinFromZero+j)%N)), rawField.intField(ftb->adjSpaces(i, 1), 2*((indexMinFromZero+j)%N)+1));
                 Complex transvecjfc = vecjfc*ftb->connection(i);
-                freeCoeff *= (vecjgc / transvecjfc);
+                freeCoeff *= vecjgc*conj(transvecjfc);  //same argument as vecjgc/transvecjfc, without the division
+                if (abs(freeCoeff)>0.0)
+                    freeCoeff /= abs(freeCoeff);
             }
 
             rawField.effort(i) = arg(freeCoeff);
-
-        }
+        }, 1000);
 
         //Getting final singularities and their indices
         effort_to_indices(rawField);
@@ -102,3 +102,61 @@ IGL_INLINE void directional::cut_mesh_with_singularities(const Eigen::MatrixXd&
 }
 
 
+IGL_INLINE void directional::cut_mesh_with_singularities(const directional::TriMesh& mesh,
+                                                         const Eigen::VectorXi& singularities,
+                                                         Eigen::MatrixXi& cuts)
+{
+  
+  //first, get a spanning tree for the mesh (no missmatch needed)
+  igl::cut_mesh_from_singularities(mesh.V, mesh.F, Eigen::MatrixXd::Zero(mesh.F.rows(), 3).eval(), cuts);
+  
+  Eigen::VectorXi inCut = Eigen::VectorXi::Zero(mesh.V.rows());
+  for (int i = 0; i < cuts.rows(); ++i)
+    for (int j = 0; j < cuts.cols(); ++j)
+      if (cuts(i,j))
+        inCut(mesh.F(i,j)) = 1;
+  
+  //if there are no cuts, the first singularity is the root of the cut
+  if ((inCut.sum() == 0) && (singularities.size() != 0))
+    inCut(singularities(0)) = 1;
+  
+  //multi-source breadth-first forest from the cut, where every vertex points to the edge leading to its closest cut vertex
+  Eigen::VectorXi prevEdge = Eigen::VectorXi::Constant(mesh.V.rows(), -1);
+  Eigen::VectorXi visited = inCut;
+  std::vector<int> bfsQueue;
+  bfsQueue.reserve(mesh.V.rows());
+  for (int i = 0; i < mesh.V.rows(); ++i)
+    if (inCut(i))
+      bfsQueue.push_back(i);
+  
+  for (int q = 0; q < bfsQueue.size(); ++q)
+  {
+    int v = bfsQueue[q];
+    for (int k = 0; k < mesh.vertexValence(v); ++k)
+    {
+      int e = mesh.VE(v,k);
+      int w = (mesh.EV(e,0) == v ? mesh.EV(e,1) : mesh.EV(e,0));
+      if (visited(w))
+        continue;
+      visited(w) = 1;
+      prevEdge(w) = e;
+      bfsQueue.push_back(w);
+    }
+  }
+  
+  //then, trace every singularity down the forest until it meets the cut, including paths of previous singularities
+  for (int i = 0; i < singularities.rows(); ++i)
+  {
+    int v = singularities(i);
+    while ((!inCut(v)) && (prevEdge(v) != -1))
+    {
+      inCut(v) = 1;
+      int e = prevEdge(v);
+      for (int k = 0; k < 2; ++k)
+        if (mesh.EF(e,k) != -1)
+          cuts(mesh.EF(e,k), mesh.EFi(e,k)) = 1;
+      v = (mesh.EV(e,0) == v ? mesh.EV(e,1) : mesh.EV(e,0));
+    }
+  }
+  
+}
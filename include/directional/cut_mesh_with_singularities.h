@@ -13,6 +13,7 @@
 
 #include <Eigen/Core>
 #include <vector>
+#include <directional/TriMesh.h>
 
 namespace directional {
   // Given a mesh and the singularities of a polyvector field, cut the mesh
@@ -52,6 +53,19 @@ namespace directional {
                                               const Eigen::VectorXi &singularities,
                                               Eigen::MatrixXi &cuts);
   
+  
+  //The same as the above, but connecting the singularities to the cut with a single multi-source breadth-first forest
+  //over the mesh adjacency, instead of a Dijkstra search per singularity. Paths of consecutive singularities merge when they
+  //meet (an approximate Steiner tree), and the running time and memory are linear in the mesh size.
+  // Inputs:
+  //   mesh             a triangle mesh
+  //   singularities    #S by 1 list of the indices of the singular vertices
+  // Outputs:
+  //   cuts             #F by 3 list of boolean flags, indicating the edges that need to be cut
+  IGL_INLINE void cut_mesh_with_singularities(const directional::TriMesh& mesh,
+                                              const Eigen::VectorXi &singularities,
+                                              Eigen::MatrixXi &cuts);
+  
 };
 
 
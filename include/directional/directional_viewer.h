@@ -51,13 +51,56 @@ namespace directional
         std::vector<Eigen::MatrixXd> fieldColors;
         std::vector<directional::StreamlineData> slData;
         std::vector<directional::StreamlineState> slState;
+        std::vector<Eigen::MatrixXd> slVList;  //streamline cylinder meshes, where every slot of the segment buffer occupies fixed vertex and face ranges
+        std::vector<Eigen::MatrixXi> slFList;
+        std::vector<Eigen::MatrixXd> slCList;
 
         std::vector<Eigen::MatrixXd> edgeVList;  //edge-diamond vertices list
         std::vector<Eigen::MatrixXi> edgeFList;  //edge-diamond faces list
         std::vector<Eigen::VectorXi> edgeFEList;  //edge-diamond faces->original mesh edges list
 
+        //persistent glyph meshes, where every sampled tangent space occupies fixed vertex and face ranges, so that edits only patch these ranges
         std::vector<Eigen::MatrixXd> fieldVList;
         std::vector<Eigen::MatrixXi> fieldFList;
+        std::vector<Eigen::MatrixXd> fieldCList;
+        std::vector<Eigen::VectorXi> fieldSampleList;  //tangent space->glyph sample (-1 if not sampled)
+        std::vector<Eigen::RowVector3d> glyphDimensions;  //length, width and height of the glyphs
+        std::vector<double> glyphSizeRatios;
+        std::vector<int> glyphSparsities;
+        std::vector<double> glyphOffsetRatios;
+
+        //(Re)generating the entire glyph mesh of a field with the current colors
+        void IGL_INLINE set_field_glyphs(const int meshNum,
+                                         const double sizeRatio,
+                                         const int sparsity,
+                                         const double offsetRatio)
+        {
+            if (fieldVList.size()<meshNum+1){
+                fieldVList.resize(meshNum+1);
+                fieldFList.resize(meshNum+1);
+                fieldCList.resize(meshNum+1);
+                fieldSampleList.resize(meshNum+1);
+                glyphDimensions.resize(meshNum+1);
+                glyphSizeRatios.resize(meshNum+1);
+                glyphSparsities.resize(meshNum+1);
+                glyphOffsetRatios.resize(meshNum+1);
+            }
+
+            const CartesianField& field=*(fieldList[meshNum]);
+            double avgScale=meshList[meshNum]->avgEdgeLength;
+            glyphDimensions[meshNum]<<sizeRatio*avgScale/3.0, sizeRatio*avgScale/15.0, avgScale*offsetRatio;
+            glyphSizeRatios[meshNum]=sizeRatio;
+            glyphSparsities[meshNum]=sparsity;
+            glyphOffsetRatios[meshNum]=offsetRatio;
+
+            Eigen::VectorXi sampledSpaces;
+            directional::glyph_sampled_spaces(field.tb->adjSpaces, field.extField.rows(), sparsity, sampledSpaces, fieldSampleList[meshNum]);
+            directional::glyph_lines_mesh(field.tb->sources, field.tb->normals, sampledSpaces, field.extField, fieldColors[meshNum], glyphDimensions[meshNum](0), glyphDimensions[meshNum](1), glyphDimensions[meshNum](2), fieldVList[meshNum], fieldFList[meshNum], fieldCList[meshNum]);
+            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].clear();
+            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_mesh(fieldVList[meshNum],fieldFList[meshNum]);
+            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_colors(fieldCList[meshNum]);
+            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].show_lines=false;
+        }
 
     public:
         DirectionalViewer(){}
@@ -226,32 +269,45 @@ namespace directional
             if (C.rows()==0)
                 fieldColors[meshNum]=default_glyph_color();
 
-            Eigen::MatrixXd VField, CField;
-            Eigen::MatrixXi FField;
-            /*const Eigen::MatrixXd& sources,
-             const Eigen::MatrixXi& normals,
-             const Eigen::MatrixXi& adjSpaces,
-             const Eigen::MatrixXd& extField,
-             const Eigen::MatrixXd &glyphColors,
-             const double sizeRatio,
-             const double avgScale,
-             Eigen::MatrixXd &fieldV,
-             Eigen::MatrixXi &fieldF,
-             Eigen::MatrixXd &fieldC,
-
-             const int sparsity=0,
-             const double offsetRatio = 0.2)*/
-            directional::glyph_lines_mesh(fieldList[meshNum]->tb->sources, fieldList[meshNum]->tb->normals, fieldList[meshNum]->tb->adjSpaces, fieldList[meshNum]->extField, fieldColors[meshNum], sizeRatio, meshList[meshNum]->avgEdgeLength, VField, FField, CField, sparsity, offsetRatio);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].clear();
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_mesh(VField,FField);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_colors(CField);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].show_lines=false;
+            set_field_glyphs(meshNum, sizeRatio, sparsity, offsetRatio);
 
             set_singularities(fieldList[meshNum]->singLocalCycles,
                               fieldList[meshNum]->singIndices,
                               meshNum);
         }
 
+        //Updates the glyphs of the given tangent spaces, after their vectors have been edited in the field object that was passed to set_field().
+        //Only the vertices of these glyphs are recomputed; the rest of the glyph mesh, and the singularities, are left as they are.
+        void IGL_INLINE update_field(const Eigen::VectorXi& changedSpaces,
+                                     const int meshNum=0)
+        {
+            const CartesianField& field=*(fieldList[meshNum]);
+            int N=field.N;
+            int numSamples=fieldVList[meshNum].rows()/(4*N);
+            assert(fieldSampleList[meshNum].size()==field.extField.rows() && "update_field(): the field has changed its size since set_field()");
+            directional::update_glyph_lines_mesh(field.tb->sources, field.tb->normals, fieldSampleList[meshNum], changedSpaces, field.extField, glyphDimensions[meshNum](0), glyphDimensions[meshNum](1), glyphDimensions[meshNum](2), fieldVList[meshNum]);
+
+            //patching the changed glyphs directly into the viewer data, without resetting the mesh
+            igl::opengl::ViewerData& fieldData=data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH];
+            for (int i=0;i<changedSpaces.size();i++){
+                int sample=fieldSampleList[meshNum](changedSpaces(i));
+                if (sample==-1)
+                    continue;
+                for (int j=0;j<N;j++){
+                    int arrow=j*numSamples+sample;
+                    fieldData.V.block(4*arrow,0,4,3)=fieldVList[meshNum].block(4*arrow,0,4,3);
+                    //the glyphs are planar, so both faces and all vertices share the normal
+                    Eigen::RowVector3d e1=fieldData.V.row(4*arrow+1)-fieldData.V.row(4*arrow);
+                    Eigen::RowVector3d e2=fieldData.V.row(4*arrow+2)-fieldData.V.row(4*arrow);
+                    Eigen::RowVector3d normal=e1.cross(e2).normalized();
+                    fieldData.F_normals.block(2*arrow,0,2,3)=normal.replicate(2,1);
+                    fieldData.V_normals.block(4*arrow,0,4,3)=normal.replicate(4,1);
+                }
+            }
+            fieldData.dirty|=igl::opengl::MeshGL::DIRTY_POSITION | igl::opengl::MeshGL::DIRTY_NORMAL;
+        }
+
+        //Sets the glyph colors. If the glyph size and sparsity are unchanged, only the colors of the tangent spaces whose colors have changed are patched, and the glyph mesh is not regenerated.
         void IGL_INLINE set_field_colors(const Eigen::MatrixXd& C=Eigen::MatrixXd(),
                                          const int meshNum=0,
                                          const double sizeRatio = 0.9,
@@ -261,20 +317,52 @@ namespace directional
                 fieldColors.resize(meshNum+1);
             if (fieldList.size()<meshNum+1)
                 fieldList.resize(meshNum+1);
-            fieldColors[meshNum]=C;
+            Eigen::MatrixXd newColors=C;
             if (C.rows()==0)
-                fieldColors[meshNum]=default_glyph_color();
-
-            //directional::glyph_lines_mesh(meshList[meshNum]->F, N[meshNum], fieldColors, CField);
+                newColors=default_glyph_color();
 
-            //TODO: something more efficient than feeding the entire field again
-            Eigen::MatrixXd VField, CField;
-            Eigen::MatrixXi FField;
-            directional::glyph_lines_mesh(fieldList[meshNum]->tb->sources, fieldList[meshNum]->tb->normals, fieldList[meshNum]->tb->adjSpaces, fieldList[meshNum]->extField, fieldColors[meshNum], sizeRatio,meshList[meshNum]->avgEdgeLength, VField, FField, CField, sparsity);
+            if ((fieldVList.size()<meshNum+1)||(fieldVList[meshNum].rows()==0)||(glyphSizeRatios[meshNum]!=sizeRatio)||(glyphSparsities[meshNum]!=sparsity)){
+                fieldColors[meshNum]=newColors;
+                set_field_glyphs(meshNum, sizeRatio, sparsity, (glyphOffsetRatios.size()<meshNum+1 ? 0.2 : glyphOffsetRatios[meshNum]));
+                return;
+            }
 
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_mesh(VField,FField);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].set_colors(CField);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].show_lines=false;
+            int numSpaces=fieldList[meshNum]->extField.rows();
+            std::vector<int> changedSpacesList;
+            if ((newColors.rows()==numSpaces)&&(newColors.rows()==fieldColors[meshNum].rows())&&(newColors.cols()==fieldColors[meshNum].cols())){
+                for (int i=0;i<numSpaces;i++)
+                    if (newColors.row(i)!=fieldColors[meshNum].row(i))
+                        changedSpacesList.push_back(i);
+            } else if ((newColors.rows()!=fieldColors[meshNum].rows())||(newColors.cols()!=fieldColors[meshNum].cols())||(newColors!=fieldColors[meshNum])){
+                for (int i=0;i<numSpaces;i++)
+                    changedSpacesList.push_back(i);
+            }
+            fieldColors[meshNum]=newColors;
+            if (changedSpacesList.empty())
+                return;
+
+            Eigen::VectorXi changedSpaces=Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(changedSpacesList.data(), changedSpacesList.size());
+            directional::update_glyph_lines_colors(fieldColors[meshNum], fieldSampleList[meshNum], changedSpaces, fieldList[meshNum]->N, fieldCList[meshNum]);
+
+            //patching the face materials of the changed glyphs directly into the viewer data, in the same way as ViewerData::set_colors() derives them
+            igl::opengl::ViewerData& fieldData=data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH];
+            int N=fieldList[meshNum]->N;
+            int numSamples=fieldCList[meshNum].rows()/(2*N);
+            for (int i=0;i<changedSpaces.size();i++){
+                int sample=fieldSampleList[meshNum](changedSpaces(i));
+                if (sample==-1)
+                    continue;
+                for (int j=0;j<N;j++){
+                    int arrow=j*numSamples+sample;
+                    for (int k=2*arrow;k<2*arrow+2;k++){
+                        Eigen::RowVector3d diffuse=fieldCList[meshNum].row(k);
+                        fieldData.F_material_diffuse.block(k,0,1,3)=diffuse;
+                        fieldData.F_material_ambient.block(k,0,1,3)=0.1*diffuse;  //ambient is a darker color
+                        fieldData.F_material_specular.block(k,0,1,3)=(0.3+0.1*(diffuse.array()-0.3)).matrix();  //specular is dampened
+                    }
+                }
+            }
+            fieldData.dirty|=igl::opengl::MeshGL::DIRTY_DIFFUSE | igl::opengl::MeshGL::DIRTY_AMBIENT | igl::opengl::MeshGL::DIRTY_SPECULAR;
         }
 
 
@@ -358,59 +446,98 @@ namespace directional
 
         void IGL_INLINE init_streamlines(const int meshNum=0,
                                          const Eigen::VectorXi& seedLocations=Eigen::VectorXi(),
-                                         const double distRatio=3.0)
+                                         const double distRatio=3.0,
+                                         const int maxSegments=0)
         {
             if (slData.size()<meshNum+1){
                 slData.resize(meshNum+1);
                 slState.resize(meshNum+1);
+                slVList.resize(meshNum+1);
+                slFList.resize(meshNum+1);
+                slCList.resize(meshNum+1);
             }
             //assert(fieldList[meshNum]->tb->discTangType()==discTangTypeEnum::FACE_SPACES);
-            directional::streamlines_init(*fieldList[meshNum], seedLocations,distRatio,slData[meshNum], slState[meshNum]);
+            directional::streamlines_init(*fieldList[meshNum], seedLocations,distRatio,slData[meshNum], slState[meshNum], maxSegments);
+            slVList[meshNum].resize(0,3);  //reallocated by the next advance_streamlines()
         }
 
+        //Advances the streamlines, regenerating only the cylinders of segments that were created or extended.
+        //Segments fade into the mesh color with their age, and the oldest are retired when the segment buffer is full.
         void IGL_INLINE advance_streamlines(const double dTimeRatio,
                                             const int meshNum=0,
                                             const double widthRatio=0.05,
                                             const double colorAttenuationRate = 0.9){
 
-            //double avgEdgeLength = igl::avg_edge_length(meshList[meshNum]->V, meshList[meshNum]->F);  //inefficient!
+            const int res=4;  //resolution of the cylinders
             double dTime = dTimeRatio*meshList[meshNum]->avgEdgeLength;
-            directional::streamlines_next(slData[meshNum], slState[meshNum],dTime);
+            directional::StreamlineState& state=slState[meshNum];
+            directional::streamlines_next(slData[meshNum], state,dTime);
             double width = widthRatio*meshList[meshNum]->avgEdgeLength;
 
-            //generating colors according to original elements and their time signature
-            Eigen::MatrixXd slColors(slState[meshNum].segStart.size(),3);
+            //allocating the cylinders of all slots, where the unused ones are degenerate
+            bool newMesh=(slVList[meshNum].rows()!=2*res*state.segCapacity);
+            if (newMesh){
+                Eigen::MatrixXd VTemplate, CTemplate;
+                Eigen::MatrixXi FTemplate;
+                directional::line_cylinders(Eigen::RowVector3d::Zero(), Eigen::RowVector3d::UnitX(), width, default_mesh_color(), res, VTemplate, FTemplate, CTemplate);
+                slVList[meshNum]=Eigen::MatrixXd::Zero(2*res*state.segCapacity,3);
+                slFList[meshNum].resize(2*res*state.segCapacity,3);
+                slCList[meshNum]=default_mesh_color().replicate(2*res*state.segCapacity,1);
+                for (int i=0;i<state.segCapacity;i++)
+                    slFList[meshNum].block(2*res*i,0,2*res,3)=FTemplate.array()+2*res*i;
+            }
+
+            //regenerating the cylinders of the segments changed by this step (or of all the live segments for a new mesh)
+            std::vector<int> changedSegments=state.changedSegments;
+            if (newMesh){
+                changedSegments.resize(state.segCount);
+                for (int i=0;i<state.segCount;i++)
+                    changedSegments[i]=i;
+            }
+            Eigen::MatrixXd P1(changedSegments.size(),3), P2(changedSegments.size(),3);
+            for (int i=0;i<changedSegments.size();i++){
+                P1.row(i)=state.segStart[changedSegments[i]];
+                P2.row(i)=state.segEnd[changedSegments[i]];
+            }
+            Eigen::MatrixXd VChanged, CChanged;
+            Eigen::MatrixXi FChanged;
+            directional::line_cylinders(P1,P2, width, Eigen::MatrixXd::Zero(P1.rows(),3), res, VChanged, FChanged, CChanged);
+            for (int i=0;i<changedSegments.size();i++)
+                slVList[meshNum].block(2*res*changedSegments[i],0,2*res,3)=VChanged.block(2*res*i,0,2*res,3);
 
+            //generating colors according to original elements and their age
             //problem: if the field is vertex-faced, "orig face" is invalid!
-            for (int i=0;i<slState[meshNum].segOrigFace.size();i++){
+            for (int i=0;i<state.segCount;i++){
+                Eigen::RowVector3d slColor;
                 if (fieldColors[meshNum].rows()==1)
-                    slColors.row(i)=fieldColors[meshNum];
+                    slColor=fieldColors[meshNum];
                 else{
-                    double blendFactor = pow(colorAttenuationRate,(double)slState[meshNum].segTimeSignatures[i]/meshList[meshNum]->avgEdgeLength);
+                    double blendFactor = pow(colorAttenuationRate,(state.currTime-state.segTimeSignatures[i])/meshList[meshNum]->avgEdgeLength);
                     //HACK: currently not supporting different colors for vertex-based fields
                     if(fieldList[meshNum]->tb->discTangType()==discTangTypeEnum::FACE_SPACES)
-                        slColors.row(i)=fieldColors[meshNum].block(slState[meshNum].segOrigFace[i], 3*slState[meshNum].segOrigVector[i], 1,3);
+                        slColor=fieldColors[meshNum].block(state.segOrigFace[i], 3*state.segOrigVector[i], 1,3);
                     else
-                        slColors.row(i)=fieldColors[meshNum].block(slState[meshNum].segOrigFace[0], 3*slState[meshNum].segOrigVector[i], 1,3);
-                    slColors.row(i).array()=slColors.row(i).array()*blendFactor+default_mesh_color().array()*(1.0-blendFactor);
+                        slColor=fieldColors[meshNum].block(state.segOrigFace[0], 3*state.segOrigVector[i], 1,3);
+                    slColor.array()=slColor.array()*blendFactor+default_mesh_color().array()*(1.0-blendFactor);
                 }
+                slCList[meshNum].block(2*res*i,0,2*res,3)=slColor.replicate(2*res,1);
             }
 
-            Eigen::MatrixXd VStream, CStream;
-            Eigen::MatrixXi FStream;
-            Eigen::MatrixXd P1(slState[meshNum].segStart.size(),3), P2(slState[meshNum].segEnd.size(),3);
-            for (int i=0;i<slState[meshNum].segStart.size();i++){
-                P1.row(i)=slState[meshNum].segStart[i];
-                P2.row(i)=slState[meshNum].segEnd[i];
+            //uploading only the live slots. The buffer fills from slot 0 and only wraps around when it is full, so the live range
+            //from the oldest segment to the newest is always slots 0...segCount-1, and the unused slots are never uploaded.
+            igl::opengl::ViewerData& slViewerData=data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH];
+            int liveRows=2*res*state.segCount;
+            if ((newMesh)||(slViewerData.V.rows()!=liveRows)){
+                slViewerData.clear();
+                if (liveRows==0)
+                    return;
+                slViewerData.set_mesh(slVList[meshNum].topRows(liveRows), slFList[meshNum].topRows(liveRows));
+                slViewerData.show_lines = false;
+            } else {
+                slViewerData.set_vertices(slVList[meshNum].topRows(liveRows));
+                slViewerData.compute_normals();
             }
-            directional::line_cylinders(P1,P2, width, slColors, 4, VStream, FStream, CStream);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].clear();
-            data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].set_mesh(VStream, FStream);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].set_colors(CStream);
-            data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].show_lines = false;
-
-
-
+            slViewerData.set_colors(slCList[meshNum].topRows(liveRows));
         }
 
         void IGL_INLINE set_isolines(const directional::TriMesh& cutMesh,
@@ -45,34 +45,61 @@ namespace directional
     }
 
 
-    // version that accepts a cartesian field object and operates on it as input and output.
-    IGL_INLINE void effort_to_indices(directional::CartesianField& field)
+    // Computes the singularities of the local cycles of a tangent bundle from the effort on all its adjacencies.
+    // Input:
+    //  tb:     the tangent bundle
+    //  effort: #adjSpaces the effort of every adjacency (only the inner ones are used)
+    //  N:      The degree of the field
+    // Output:
+    //  singCycles:  the singular local cycles
+    //  singIndices: their indices x N
+    IGL_INLINE void effort_to_indices(const directional::TangentBundle& tb,
+                                      const Eigen::VectorXd& effort,
+                                      const int N,
+                                      Eigen::VectorXi& singCycles,
+                                      Eigen::VectorXi& singIndices)
     {
-        //field.effort = Eigen::VectorXd::Zero(field.adjSpaces.rows());
-        Eigen::VectorXd effortInner(field.tb->innerAdjacencies.size());
-        for (int i=0;i<field.tb->innerAdjacencies.size();i++)
-            effortInner(i)=field.effort(field.tb->innerAdjacencies(i));
+        Eigen::VectorXd effortInner(tb.innerAdjacencies.size());
+        for (int i=0;i<tb.innerAdjacencies.size();i++)
+            effortInner(i)=effort(tb.innerAdjacencies(i));
         Eigen::VectorXi fullIndices;
-        directional::effort_to_indices(field.tb->cycles, effortInner, field.tb->cycleCurvatures, field.N, fullIndices);
+        directional::effort_to_indices(tb.cycles, effortInner, tb.cycleCurvatures, N, fullIndices);
 
-        Eigen::VectorXi indices(field.tb->local2Cycle.size());
-        for (int i=0;i<field.tb->local2Cycle.size();i++)
-            indices(i)=fullIndices(field.tb->local2Cycle(i));
+        Eigen::VectorXi indices(tb.local2Cycle.size());
+        for (int i=0;i<tb.local2Cycle.size();i++)
+            indices(i)=fullIndices(tb.local2Cycle(i));
 
         std::vector<int> singCyclesList;
         std::vector<int> singIndicesList;
-        for (int i=0;i<field.tb->local2Cycle.size();i++)
+        for (int i=0;i<tb.local2Cycle.size();i++)
             if (indices(i)!=0){
                 singCyclesList.push_back(i);
                 singIndicesList.push_back(indices(i));
             }
 
-        Eigen::VectorXi singCycles(singCyclesList.size());
-        Eigen::VectorXi singIndices(singIndicesList.size());
+        singCycles.resize(singCyclesList.size());
+        singIndices.resize(singIndicesList.size());
         for (int i=0;i<singCyclesList.size();i++){
             singCycles(i)=singCyclesList[i];
             singIndices(i)=singIndicesList[i];
         }
+    }
+
+
+    // version that accepts a cartesian field object and operates on it as input and output.
+    IGL_INLINE void effort_to_indices(directional::CartesianField& field)
+    {
+        Eigen::VectorXi singCycles, singIndices;
+        directional::effort_to_indices(*(field.tb), field.effort, field.N, singCycles, singIndices);
+        field.set_singularities(singCycles, singIndices);
+    }
+
+
+    // The same for a float-storage field
+    IGL_INLINE void effort_to_indices(directional::FloatCartesianField& field)
+    {
+        Eigen::VectorXi singCycles, singIndices;
+        directional::effort_to_indices(*(field.tb), field.effort, field.N, singCycles, singIndices);
         field.set_singularities(singCycles, singIndices);
     }
 }
@@ -0,0 +1,63 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_FACE_GEOMETRY_H
+#define DIRECTIONAL_FACE_GEOMETRY_H
+
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <igl/igl_inline.h>
+#include <igl/parallel_for.h>
+
+
+namespace directional
+{
+  // Computes the basic per-face geometric quantities of a triangle mesh in a single (parallel) pass, so that the mesh, the tangent bundles,
+  // and the FEM operators can share them instead of going over the mesh again for each.
+  // Corner j of face i is at F(i,j), and edge j goes from F(i,j) to F(i,(j+1)%3) (and is FE(i,j) by the igl::edge_topology convention).
+  // Input:
+  //  V:                  #V x 3 mesh vertices
+  //  F:                  #F x 3 mesh faces
+  // Output:
+  //  faceEdgeVectors:    #F x 9 the three edge vectors of each face, as xyzxyzxyz
+  //  faceDoubleAreas:    #F twice the area of each face
+  //  cornerAngles:       #F x 3 the angle at each corner
+  //  cornerCotangents:   #F x 3 the cotangent of the angle at each corner (zero for degenerate corners)
+  IGL_INLINE void face_geometry(const Eigen::MatrixXd& V,
+                                const Eigen::MatrixXi& F,
+                                Eigen::MatrixXd& faceEdgeVectors,
+                                Eigen::VectorXd& faceDoubleAreas,
+                                Eigen::MatrixXd& cornerAngles,
+                                Eigen::MatrixXd& cornerCotangents)
+  {
+    faceEdgeVectors.resize(F.rows(),9);
+    faceDoubleAreas.resize(F.rows());
+    cornerAngles.resize(F.rows(),3);
+    cornerCotangents.resize(F.rows(),3);
+    igl::parallel_for(F.rows(), [&](const int i){
+      Eigen::RowVector3d edgeVectors[3];
+      for (int j=0;j<3;j++){
+        edgeVectors[j] = V.row(F(i,(j+1)%3))-V.row(F(i,j));
+        faceEdgeVectors.block(i,3*j,1,3) = edgeVectors[j];
+      }
+      faceDoubleAreas(i) = edgeVectors[0].cross(edgeVectors[1]).norm();
+
+      for (int j=0;j<3;j++){
+        //the corner is between the outgoing edge j and the reverse of the incoming edge (j+2)%3
+        Eigen::RowVector3d vec12 = edgeVectors[j];
+        Eigen::RowVector3d vec13 = -edgeVectors[(j+2)%3];
+        double cosAngle = vec12.dot(vec13);
+        double sinAngle = (vec12.cross(vec13)).norm();
+        cornerAngles(i,j) = std::atan2(sinAngle, cosAngle);
+        cornerCotangents(i,j) = (std::abs(sinAngle)>10e-7 ? cosAngle/sinAngle : 0.0);
+      }
+    }, 1000);
+  }
+}
+
+#endif
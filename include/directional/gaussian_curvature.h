@@ -10,34 +10,44 @@
 
 #include <igl/PI.h>
 #include <Eigen/Core>
+#include <directional/face_geometry.h>
 
 
 namespace directional
 {
-    // Computes boundary-aware discrete Gaussian curvature on vertices (angle defect).
+    // Computes boundary-aware discrete Gaussian curvature on vertices (angle defect), from precomputed corner angles (see face_geometry()).
     // Input:
     //  V:                  #V by 3 vertices.
     //  F:                  #F by 3 triangles.
     //  isBoundaryVertex:   #V boolean indicating if vertex is a boundary.
+    //  cornerAngles:       #F by 3 the angle at each corner F(i,j).
     //output:
     //  G:                  #V discrete Gaussian curvature. sum(G) = eulerChar of mesh.
     IGL_INLINE void gaussian_curvature(const Eigen::MatrixXd& V,
                                        const Eigen::MatrixXi& F,
                                        const Eigen::VectorXi& isBoundaryVertex,
+                                       const Eigen::MatrixXd& cornerAngles,
                                        Eigen::VectorXd& G){
 
         G.resize(V.rows());
         for (int i=0;i<V.rows();i++)
             G(i)=(isBoundaryVertex(i) ? igl::PI : 2.0*igl::PI);
 
-        for (int i=0;i<F.rows();i++) {
-            for (int j = 0; j < 3; j++) {
-                Eigen::RowVector3d v1 = V.row(F(i, (j + 1) % 3)) - V.row(F(i, j));
-                Eigen::RowVector3d v2 = V.row(F(i, (j + 2) % 3)) - V.row(F(i, j));
-                double currAngle = std::acos(v1.dot(v2) / (v1.norm() * v2.norm()));
-                G(F(i, j)) -= currAngle;
-            }
-        }
+        for (int i=0;i<F.rows();i++)
+            for (int j = 0; j < 3; j++)
+                G(F(i, j)) -= cornerAngles(i, j);
+    }
+
+    // The same, computing the corner angles.
+    IGL_INLINE void gaussian_curvature(const Eigen::MatrixXd& V,
+                                       const Eigen::MatrixXi& F,
+                                       const Eigen::VectorXi& isBoundaryVertex,
+                                       Eigen::VectorXd& G){
+
+        Eigen::MatrixXd faceEdgeVectors, cornerAngles, cornerCotangents;
+        Eigen::VectorXd faceDoubleAreas;
+        directional::face_geometry(V, F, faceEdgeVectors, faceDoubleAreas, cornerAngles, cornerCotangents);
+        gaussian_curvature(V, F, isBoundaryVertex, cornerAngles, G);
     }
 }
 
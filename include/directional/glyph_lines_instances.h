@@ -0,0 +1,105 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_GLYPH_LINES_INSTANCES_H
+#define DIRECTIONAL_GLYPH_LINES_INSTANCES_H
+
+#include <cmath>
+#include <igl/igl_inline.h>
+#include <igl/PI.h>
+#include <directional/glyph_lines_mesh.h>
+#include <directional/mesh_instances.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+
+namespace directional
+{
+
+  // Creates an instanced glyph drawing of a directional field: the geometry of glyph_lines_mesh() at a fraction of its memory, to be fed
+  // to instanced renderers or exported (or expanded with mesh_instances_to_mesh()). The glyph of vector j of sample i is instance j*#sampledSpaces+i,
+  // as in glyph_lines_mesh(). The x axis of a glyph is its vector, the y axis is the unit normal x vector scaled by the length of the vector,
+  // and the z axis is the unit normal.
+  // Inputs:
+  //  sources:    #spaces by 3 the sources of the tangent spaces.
+  //  normals:    #spaces by 3 the normals of the tangent spaces.
+  //  sampledSpaces: the tangent spaces that carry glyphs (see glyph_sampled_spaces()).
+  //  extField:   A directional field in raw xyzxyz form, in double or float (for instance, of a FloatCartesianField)
+  //  glyphColor: An array of either 1 by 3 color values for each vector, #spaces by 3 colors for each individual directional or #spaces by 3*N colours for each individual vector.
+  //  length, width,  height: of the glyphs depicting the directionals
+  // Outputs:
+  //  instances:  the template glyph and the per-glyph frames and colors
+  template <typename DerivedF>
+  void IGL_INLINE glyph_lines_instances(const Eigen::MatrixXd& sources,
+                                        const Eigen::MatrixXd& normals,
+                                        const Eigen::VectorXi& sampledSpaces,
+                                        const Eigen::MatrixBase<DerivedF>& extField,
+                                        const Eigen::MatrixXd& glyphColor,
+                                        const double length,
+                                        const double width,
+                                        const double height,
+                                        MeshInstances& instances)
+  {
+    int N=extField.cols()/3;
+
+    double angle = 2*igl::PI/(double)(N);
+    if (N==1) angle=igl::PI;
+
+    //the template of angled_arrows()
+    double widthRatio = width/length;
+    instances.templateV.resize(4,3);
+    instances.templateF.resize(2,3);
+    instances.templateV<<0.0,0.0,0.0,
+    (widthRatio/2.0)*(cos(angle/2.0)/sin(angle/2.0)), -widthRatio/2.0, 0.0,
+    1.0,0.0,0.0,
+    (widthRatio/2.0)*(cos(angle/2.0)/sin(angle/2.0)), widthRatio/2.0, 0.0;
+    instances.templateF<<0,1,2,
+    2,3,0;
+
+    int numSamples=sampledSpaces.size();
+    instances.positions.resize(numSamples*N,3);
+    instances.xAxes.resize(numSamples*N,3);
+    instances.yAxes.resize(numSamples*N,3);
+    instances.zAxes.resize(numSamples*N,3);
+    instances.colors.resize(numSamples*N,3);
+    for (int i=0;i<numSamples;i++){
+      int space=sampledSpaces(i);
+      Eigen::RowVector3d position = sources.row(space)+height*width*normals.row(space);
+      for (int j=0;j<N;j++){
+        Eigen::RowVector3d direction = length*extField.block(space,3*j,1,3).template cast<double>();
+        Eigen::RowVector3d normal = normals.row(space);
+        instances.positions.row(j*numSamples+i) = position.cast<float>();
+        instances.xAxes.row(j*numSamples+i) = direction.cast<float>();
+        instances.yAxes.row(j*numSamples+i) = (normal.cross(direction).normalized()*direction.norm()).cast<float>();
+        instances.zAxes.row(j*numSamples+i) = normal.cast<float>();
+        instances.colors.row(j*numSamples+i) = glyph_color(glyphColor, extField.rows(), space, j).template cast<float>();
+      }
+    }
+  }
+
+
+  //A version without specification of glyph dimensions, with the same sizing as glyph_lines_mesh()
+  template <typename DerivedF>
+  void IGL_INLINE glyph_lines_instances(const Eigen::MatrixXd& sources,
+                                        const Eigen::MatrixXd& normals,
+                                        const Eigen::MatrixXi& adjSpaces,
+                                        const Eigen::MatrixBase<DerivedF>& extField,
+                                        const Eigen::MatrixXd &glyphColors,
+                                        const double sizeRatio,
+                                        const double avgScale,
+                                        MeshInstances& instances,
+                                        const int sparsity=0,
+                                        const double offsetRatio = 0.2)
+  {
+    Eigen::VectorXi sampledSpaces, space2Sample;
+    glyph_sampled_spaces(adjSpaces, extField.rows(), sparsity, sampledSpaces, space2Sample);
+    glyph_lines_instances(sources, normals, sampledSpaces, extField, glyphColors, sizeRatio*avgScale/3.0, sizeRatio*avgScale/15.0,  avgScale*offsetRatio, instances);
+  }
+
+}
+
+#endif
@@ -8,55 +8,38 @@
 #ifndef DIRECTIONAL_GLYPH_LINES_MESH_H
 #define DIRECTIONAL_GLYPH_LINES_MESH_H
 
+#include <vector>
+#include <set>
 #include <igl/igl_inline.h>
 #include <igl/colon.h>
+#include <igl/PI.h>
 #include <igl/speye.h>
 #include <directional/angled_arrows.h>
 #include <Eigen/Core>
+#include <Eigen/Sparse>
 
 
 namespace directional
 {
   
   
-  // Creates mesh elements that comprise glyph drawing of a directional field.
+  // Samples the tangent spaces that carry glyphs. With sparsity==0 these are all spaces, and otherwise a subset in which no two samples are within "sparsity" rings of each other.
   // Inputs:
-  //  V:          #V X 3 vertex coordinates.
-  //  F:          #F by 3 face vertex indices.
-  //  EF:         #E by 2 edge-face adjacency matrix (only used when sparsity !=0)
-  //  rawField:   A directional field in raw xyzxyz form
-  //  glyphColor: An array of either 1 by 3 color values for each vector, #F by 3 colors for each individual directional or #F*N by 3 colours for each individual vector, ordered by #F times vector 1, followed by #F times vector 2 etc.
-  //  length, width,  height: of the glyphs depicting the directionals
-  //  N:        The degree of the field.
-  
+  //  adjSpaces:  #adjacencies by 2 adjacent tangent spaces (-1 for none)
+  //  numSpaces:  number of tangent spaces
+  //  sparsity:   the ring distance between samples
   // Outputs:
-  //  fieldV: The vertices of the field mesh
-  //  fieldF: The faces of the field mesh
-  //  fieldC: The colors of the field mesh
-  
-  void IGL_INLINE glyph_lines_mesh(const Eigen::MatrixXd& sources,
-                                   const Eigen::MatrixXd& normals,
-                                   const Eigen::MatrixXi& adjSpaces,
-                                   const Eigen::MatrixXd& extField,
-                                   const Eigen::MatrixXd& glyphColor,
-                                   const double length,
-                                   const double width,
-                                   const double height,
-                                   const int sparsity,
-                                   Eigen::MatrixXd &fieldV,
-                                   Eigen::MatrixXi &fieldF,
-                                   Eigen::MatrixXd &fieldC)
+  //  sampledSpaces: the sampled tangent spaces
+  //  space2Sample:  #numSpaces index of each space into sampledSpaces, or -1 if it is not sampled
+  void IGL_INLINE glyph_sampled_spaces(const Eigen::MatrixXi& adjSpaces,
+                                       const int numSpaces,
+                                       const int sparsity,
+                                       Eigen::VectorXi& sampledSpaces,
+                                       Eigen::VectorXi& space2Sample)
   {
     using namespace Eigen;
     using namespace std;
     
-    int N=extField.cols()/3;
-    
-    double angle = 2*igl::PI/(double)(N);
-    if (N==1) angle=igl::PI;
-    Eigen::MatrixXd vectorColors, P1, P2;
-    
-    VectorXi sampledSpaces;
     if (sparsity!=0){
       //creating adjacency matrix
       vector<Triplet<int>> adjTris;
@@ -66,10 +49,10 @@ namespace directional
           adjTris.push_back(Triplet<int>(adjSpaces(i,1), adjSpaces(i,0),1));
         }
       
-      SparseMatrix<int> adjMat(extField.rows(),extField.rows());
+      SparseMatrix<int> adjMat(numSpaces,numSpaces);
       adjMat.setFromTriplets(adjTris.begin(), adjTris.end());
-      SparseMatrix<int> newAdjMat(extField.rows(),extField.rows()),matMult;
-      igl::speye(extField.rows(), extField.rows(), matMult);
+      SparseMatrix<int> newAdjMat(numSpaces,numSpaces),matMult;
+      igl::speye(numSpaces, numSpaces, matMult);
       for (int i=0;i<sparsity;i++){
         matMult=matMult*adjMat;
         newAdjMat+=matMult;
@@ -79,7 +62,7 @@ namespace directional
       
       adjMat=newAdjMat;
       
-      vector<set<int>> ringAdjacencies(extField.rows());
+      vector<set<int>> ringAdjacencies(numSpaces);
       for (int k=0; k<adjMat.outerSize(); ++k){
         for (SparseMatrix<int>::InnerIterator it(adjMat,k); it; ++it){
           ringAdjacencies[it.row()].insert(it.col());
@@ -87,8 +70,8 @@ namespace directional
         }
       }
       
-      VectorXi sampleMask=VectorXi::Zero(extField.rows());
-      for (int i=0;i<extField.rows();i++){
+      VectorXi sampleMask=VectorXi::Zero(numSpaces);
+      for (int i=0;i<numSpaces;i++){
         if (sampleMask(i)!=0) //occupied face
           continue;
         
@@ -108,7 +91,65 @@ namespace directional
       
       sampledSpaces = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(samplesList.data(), samplesList.size());
       
-    } else igl::colon(0,1,extField.rows()-1,sampledSpaces);
+    } else igl::colon(0,1,numSpaces-1,sampledSpaces);
+    
+    space2Sample=VectorXi::Constant(numSpaces,-1);
+    for (int i=0;i<sampledSpaces.size();i++)
+      space2Sample(sampledSpaces(i))=i;
+  }
+  
+  
+  // The color of the glyph of vector j in a tangent space, by the glyphColor conventions of glyph_lines_mesh().
+  Eigen::RowVector3d IGL_INLINE glyph_color(const Eigen::MatrixXd& glyphColor,
+                                            const int numSpaces,
+                                            const int space,
+                                            const int j)
+  {
+    if (glyphColor.rows() == 1)
+      return glyphColor.row(0).head(3);
+    if ((glyphColor.rows() == numSpaces)&&(glyphColor.cols()==3))
+      return glyphColor.row(space);
+    return glyphColor.block(space,3*j,1,3);
+  }
+  
+  
+  // Creates mesh elements that comprise glyph drawing of a directional field.
+  // The glyph of vector j of sample i is the arrow j*#sampledSpaces+i, which comprises vertices 4*arrow...4*arrow+3 and faces 2*arrow, 2*arrow+1.
+  // Inputs:
+  //  sources:    #spaces by 3 the sources of the tangent spaces.
+  //  normals:    #spaces by 3 the normals of the tangent spaces.
+  //  adjSpaces:  #adjacencies by 2 adjacent tangent spaces (only used when sparsity !=0)
+  //  extField:   A directional field in raw xyzxyz form, in double or float (for instance, of a FloatCartesianField)
+  //  glyphColor: An array of either 1 by 3 color values for each vector, #F by 3 colors for each individual directional or #F by 3*N colours for each individual vector, ordered by vector 1 xyz, vector 2 xyz, etc.
+  //  length, width,  height: of the glyphs depicting the directionals
+  //  sparsity:   the ring distance between sampled spaces (see glyph_sampled_spaces()).
+  
+  // Outputs:
+  //  fieldV: The vertices of the field mesh
+  //  fieldF: The faces of the field mesh
+  //  fieldC: The colors of the field mesh
+  
+  template <typename DerivedF>
+  void IGL_INLINE glyph_lines_mesh(const Eigen::MatrixXd& sources,
+                                   const Eigen::MatrixXd& normals,
+                                   const Eigen::VectorXi& sampledSpaces,
+                                   const Eigen::MatrixBase<DerivedF>& extField,
+                                   const Eigen::MatrixXd& glyphColor,
+                                   const double length,
+                                   const double width,
+                                   const double height,
+                                   Eigen::MatrixXd &fieldV,
+                                   Eigen::MatrixXi &fieldF,
+                                   Eigen::MatrixXd &fieldC)
+  {
+    using namespace Eigen;
+    using namespace std;
+    
+    int N=extField.cols()/3;
+    
+    double angle = 2*igl::PI/(double)(N);
+    if (N==1) angle=igl::PI;
+    Eigen::MatrixXd vectorColors, P1, P2;
     
     MatrixXd vectNormals(sampledSpaces.rows()*N,3);
     P1.resize(sampledSpaces.rows() * N, 3);
@@ -119,45 +160,126 @@ namespace directional
     for (int i=0;i<sampledSpaces.size();i++)
       for (int j=0;j<N;j++){
         P1.row(j*sampledSpaces.size()+i) = sources.row(sampledSpaces(i));
-        P2.row(j*sampledSpaces.size()+i) = extField.block(sampledSpaces(i),j*3,1,3);
+        P2.row(j*sampledSpaces.size()+i) = extField.block(sampledSpaces(i),j*3,1,3).template cast<double>();
         vectNormals.row(j*sampledSpaces.size()+i) = normals.row(sampledSpaces(i)).array()*width;
+        vectorColors.row(j*sampledSpaces.size()+i) = glyph_color(glyphColor, extField.rows(), sampledSpaces(i), j);
       }
     
-    /*P1 = barycenters.replicate(N, 1);
-    
-    for (int i = 0; i < N; i++)
-      P2.middleRows(F.rows()*i, F.rows()) = rawField.middleCols(3*i, 3);*/
-    
     P2.array() *= length;
     P2 += P1;
     
-    // Duplicate colors so each glyph gets the proper color
-    if (glyphColor.rows() == 1)
-      vectorColors = glyphColor.replicate(P1.rows(), 1);
-    else if ((glyphColor.rows() == extField.rows())&&(glyphColor.cols()==3)){
-      MatrixXd sampledColors(sampledSpaces.size(),3);
-      for (int i=0;i<sampledSpaces.size();i++)
-        sampledColors.row(i)=glyphColor.row(sampledSpaces(i));
-      vectorColors = sampledColors.replicate(N, 1);
-    }
-    else{
-      for (int i=0;i<N;i++)
-        vectorColors.block(i*sampledSpaces.rows(),0,sampledSpaces.rows(),3)=glyphColor.block(0,3*i,sampledSpaces.rows(),3);
-    }
-    
-    Eigen::MatrixXd Vc, Cc, Vs, Cs;
-    Eigen::MatrixXi Fc, Fs;
     directional::angled_arrows(P1,P2,vectNormals, width/length, height, angle, vectorColors, fieldV, fieldF, fieldC);
+  }
+  
+  
+  //A version that samples the spaces by the given sparsity
+  template <typename DerivedF>
+  void IGL_INLINE glyph_lines_mesh(const Eigen::MatrixXd& sources,
+                                   const Eigen::MatrixXd& normals,
+                                   const Eigen::MatrixXi& adjSpaces,
+                                   const Eigen::MatrixBase<DerivedF>& extField,
+                                   const Eigen::MatrixXd& glyphColor,
+                                   const double length,
+                                   const double width,
+                                   const double height,
+                                   const int sparsity,
+                                   Eigen::MatrixXd &fieldV,
+                                   Eigen::MatrixXi &fieldF,
+                                   Eigen::MatrixXd &fieldC)
+  {
+    Eigen::VectorXi sampledSpaces, space2Sample;
+    glyph_sampled_spaces(adjSpaces, extField.rows(), sparsity, sampledSpaces, space2Sample);
+    glyph_lines_mesh(sources, normals, sampledSpaces, extField, glyphColor, length, width, height, fieldV, fieldF, fieldC);
+  }
+  
+  
+  // Updates in place the glyphs of a few tangent spaces in a glyph mesh created by glyph_lines_mesh() with the same samples and dimensions.
+  // As every sample occupies fixed vertex ranges in the mesh, only these ranges are rewritten, and the faces are unchanged.
+  // Inputs:
+  //  space2Sample:   #spaces index of each space into the samples, or -1 if it is not sampled (see glyph_sampled_spaces())
+  //  changedSpaces:  the tangent spaces whose vectors have changed. Unsampled spaces are ignored.
+  //  other inputs:   as in glyph_lines_mesh()
+  // Outputs:
+  //  fieldV:         the glyph mesh vertices, updated in the vertices of the changed glyphs
+  void IGL_INLINE update_glyph_lines_mesh(const Eigen::MatrixXd& sources,
+                                          const Eigen::MatrixXd& normals,
+                                          const Eigen::VectorXi& space2Sample,
+                                          const Eigen::VectorXi& changedSpaces,
+                                          const Eigen::MatrixXd& extField,
+                                          const double length,
+                                          const double width,
+                                          const double height,
+                                          Eigen::MatrixXd &fieldV)
+  {
+    using namespace Eigen;
+    
+    int N=extField.cols()/3;
+    int numSamples=fieldV.rows()/(4*N);
+    
+    double angle = 2*igl::PI/(double)(N);
+    if (N==1) angle=igl::PI;
+    
+    std::vector<int> changedSamples;
+    for (int i=0;i<changedSpaces.size();i++)
+      if (space2Sample(changedSpaces(i))!=-1)
+        changedSamples.push_back(changedSpaces(i));
+    
+    MatrixXd P1(changedSamples.size()*N,3), P2(changedSamples.size()*N,3), vectNormals(changedSamples.size()*N,3);
+    for (int i=0;i<changedSamples.size();i++)
+      for (int j=0;j<N;j++){
+        P1.row(N*i+j) = sources.row(changedSamples[i]);
+        P2.row(N*i+j) = extField.block(changedSamples[i],j*3,1,3);
+        vectNormals.row(N*i+j) = normals.row(changedSamples[i]).array()*width;
+      }
+    
+    P2.array() *= length;
+    P2 += P1;
     
+    MatrixXd changedV, changedC;
+    MatrixXi changedF;
+    directional::angled_arrows(P1,P2,vectNormals, width/length, height, angle, MatrixXd::Zero(P1.rows(),3), changedV, changedF, changedC);
     
+    for (int i=0;i<changedSamples.size();i++)
+      for (int j=0;j<N;j++){
+        int arrow = j*numSamples+space2Sample(changedSamples[i]);
+        fieldV.block(4*arrow,0,4,3) = changedV.block(4*(N*i+j),0,4,3);
+      }
   }
-
+  
+  
+  // Updates in place the colors of the glyphs of a few tangent spaces in a glyph mesh created by glyph_lines_mesh() with the same samples.
+  // Inputs:
+  //  glyphColor:     the new glyph colors, in any of the formats of glyph_lines_mesh()
+  //  space2Sample:   #spaces index of each space into the samples, or -1 if it is not sampled (see glyph_sampled_spaces())
+  //  changedSpaces:  the tangent spaces whose colors have changed. Unsampled spaces are ignored.
+  //  N:              The degree of the field.
+  // Outputs:
+  //  fieldC:         the glyph mesh face colors, updated in the faces of the changed glyphs
+  void IGL_INLINE update_glyph_lines_colors(const Eigen::MatrixXd& glyphColor,
+                                            const Eigen::VectorXi& space2Sample,
+                                            const Eigen::VectorXi& changedSpaces,
+                                            const int N,
+                                            Eigen::MatrixXd &fieldC)
+  {
+    int numSamples=fieldC.rows()/(2*N);
+    for (int i=0;i<changedSpaces.size();i++){
+      int sample=space2Sample(changedSpaces(i));
+      if (sample==-1)
+        continue;
+      for (int j=0;j<N;j++){
+        int arrow = j*numSamples+sample;
+        fieldC.block(2*arrow,0,2,3) = glyph_color(glyphColor, space2Sample.size(), changedSpaces(i), j).replicate(2,1);
+      }
+    }
+  }
+  
   
   //A version without specification of glyph dimensions
+  template <typename DerivedF>
   void IGL_INLINE glyph_lines_mesh(const Eigen::MatrixXd& sources,
                                    const Eigen::MatrixXd& normals,
                                    const Eigen::MatrixXi& adjSpaces,
-                                   const Eigen::MatrixXd& extField,
+                                   const Eigen::MatrixBase<DerivedF>& extField,
                                    const Eigen::MatrixXd &glyphColors,
                                    const double sizeRatio,
                                    const double avgScale,
@@ -11,15 +11,18 @@
 #include <queue>
 #include <vector>
 #include <cmath>
+#include <iostream>
 #include <Eigen/Core>
+#include <Eigen/Sparse>
 #include <igl/igl_inline.h>
+#include <igl/parallel_for.h>
 #include <igl/diag.h>
 #include <igl/local_basis.h>
 #include <igl/edge_topology.h>
 #include <directional/FEM_masses.h>
 #include <directional/FEM_suite.h>
+#include <directional/face_geometry.h>
 #include <directional/dual_cycles.h>
-#include <igl/euler_characteristic.h>
 #include <igl/per_face_normals.h>
 #include <igl/boundary_loop.h>
 
@@ -28,27 +31,69 @@ namespace directional
 {
   
   
-  // Creating non-conforming mid-edge mesh, where the faces are between the midedges of each original face. This is generally only for visualization
+  // Solves L*x=rhs for all columns of rhs, where the rows with isFixed=1 are fixed to zero, with a single factorization of the reduced (positive-definite) system.
+  // The columns are solved in parallel.
+  IGL_INLINE void reduced_laplacian_solve(const Eigen::SparseMatrix<double>& L,
+                                          const Eigen::VectorXi& isFixed,
+                                          const Eigen::MatrixXd& rhs,
+                                          Eigen::MatrixXd& x)
+  {
+    using namespace Eigen;
+    VectorXi full2Free=VectorXi::Constant(L.rows(),-1);
+    std::vector<int> free2Full;
+    for (int i=0;i<L.rows();i++)
+      if (!isFixed(i)){
+        full2Free(i)=free2Full.size();
+        free2Full.push_back(i);
+      }
+    
+    std::vector<Triplet<double>> LffTris;
+    for (int k=0;k<L.outerSize();k++)
+      for (SparseMatrix<double>::InnerIterator it(L,k);it;++it)
+        if ((full2Free(it.row())>=0)&&(full2Free(it.col())>=0))
+          LffTris.push_back(Triplet<double>(full2Free(it.row()), full2Free(it.col()), it.value()));
+    SparseMatrix<double> Lff(free2Full.size(), free2Full.size());
+    Lff.setFromTriplets(LffTris.begin(), LffTris.end());
+    
+    x=MatrixXd::Zero(L.rows(), rhs.cols());
+    if (free2Full.empty())
+      return;
+    SimplicialLDLT<SparseMatrix<double>> solver;
+    solver.compute(Lff);
+    assert(solver.info()==Success && "reduced_laplacian_solve(): factorization failed");
+    
+    igl::parallel_for(rhs.cols(), [&](const int c)
+    {
+      VectorXd rhsf(free2Full.size());
+      for (int i=0;i<free2Full.size();i++)
+        rhsf(i)=rhs(free2Full[i],c);
+      VectorXd xf=solver.solve(rhsf);
+      for (int i=0;i<free2Full.size();i++)
+        x(free2Full[i],c)=xf(i);
+    }, 2);
+  }
+  
+  
+  // Computes a basis for the harmonic (curl- and divergence-free, tangent to the boundary) vector fields on a mesh, one per homology generator:
+  // 2g fields around the handles, and #b-1 fields circulating around all boundary loops but the first.
+  // The handle generators share a single factorization of the vertex Laplacian, and the boundary generators a single factorization of the mid-edge Laplacian,
+  // each solved together as the columns of one right-hand side.
   // Input:
-  //  VMesh:      #V x 3 conforming mesh vertices
-  //  FMesh:      #F x 3 conforming mesh faces
-  //  EV:         #E x 2 edges to vertices indices
-  //  EF:         #E x 2 edges to faces indices
-  //  FE:         #F x 3 faces to edges indices
+  //  V:      #V x 3 mesh vertices
+  //  F:      #F x 3 mesh faces
+  //  EV:     #E x 2 edges to vertices indices
+  //  FE:     #F x 3 faces to edges indices
+  //  EF:     #E x 2 edges to faces indices
+  //  verbose:  print the curl and divergence of each field as a sanity check
   // Output:
-  //  Gv:    #3f x V Conforming gradient matrix, returning vector of xyzxyz per face gradient vectors
-  //  Ge:    #3f x V Non-conforming gradient of the same style, but for mid-edge functions
-  //  J:    #3F x 3F rotation operator [Nx] per face
-  //  C:  Curl operator which is basically (JGe)^T * Mchi
-  //  C:  Divergence operator which is basically Gv^T * Mchi
-  
+  //  harmFields: the basis fields, as #F x 3 face-based vectors, appended to the list.
   IGL_INLINE void harmonic_basis(const Eigen::MatrixXd& V,
                                  const Eigen::MatrixXi& F,
                                  const Eigen::MatrixXi& EV,
                                  const Eigen::MatrixXi& FE,
                                  const Eigen::MatrixXi& EF,
-                                 
-                                 std::vector<Eigen::MatrixXd>& harmFields)
+                                 std::vector<Eigen::MatrixXd>& harmFields,
+                                 const bool verbose=false)
   {
     
     using namespace Eigen;
@@ -57,8 +102,11 @@ namespace directional
     SparseMatrix<double> Gv, Ge, J, Mv, Mchi, Mf, Me, C, D;
     VectorXd MvVec, MeVec, MfVec, MchiVec;
     
-    directional::FEM_suite(V, F, EV, FE, EF, Gv, Ge, J, C, D);
-    directional::FEM_masses(V, F, EV, FE, EF, MvVec, MeVec, MfVec, MchiVec);
+    MatrixXd faceEdgeVectors, cornerAngles, cornerCotangents;
+    VectorXd faceDoubleAreas;
+    directional::face_geometry(V, F, faceEdgeVectors, faceDoubleAreas, cornerAngles, cornerCotangents);
+    directional::FEM_suite(V, F, EV, FE, EF, faceEdgeVectors, faceDoubleAreas, Gv, Ge, J, C, D);
+    directional::FEM_masses(V, F, EV, FE, EF, faceDoubleAreas, MvVec, MeVec, MfVec, MchiVec);
     
     igl::diag(MvVec,Mv);
     igl::diag(MeVec,Me);
@@ -72,65 +120,88 @@ namespace directional
     std::vector<std::vector<int>> boundaryLoops;
     
     dual_cycles(V,F,EV,EF,basisCycles,cycleCurvature,vertex2cycle,innerEdges);
-    int eulerChar = igl::euler_characteristic(V,F);
     igl::boundary_loop(F, boundaryLoops);
     int numBoundaries=boundaryLoops.size();
-    int numGenerators=2-numBoundaries-eulerChar;
-    assert(numBoundaries==0 && "Currently not working with boundaries!");
+    VectorXi isBoundary=VectorXi::Zero(V.rows());
+    for (int i=0;i<boundaryLoops.size();i++)
+      for (int j=0;j<boundaryLoops[i].size();j++)
+        isBoundary(boundaryLoops[i][j])=1;
+    //the cycle matrix holds the inner vertex cycles, then the boundary cycles, and then the generators
+    int numGenerators=basisCycles.rows()-(V.rows()-isBoundary.sum())-numBoundaries;
+    int firstGenerator=basisCycles.rows()-numGenerators;
     
+    SparseMatrix<double> Lv = D*Gv;   //Gv^T * Mchi * Gv
     
-     SparseMatrix<double> Lv = D*Gv;   //Gv^T * Mchi * Gv
-    for (int cycle=basisCycles.rows()-numGenerators;cycle<basisCycles.rows();cycle++){
-      SparseVector<double> singleCycle = basisCycles.row(cycle).transpose();
-      
-      //VectorXi bmask=VectorXi::Zero(V.rows());
-      //VectorXd bcall=VectorXd::Zero(V.rows());
+    //Handle generators: the candidate field is the gradient of a step function across the cycle, restricted to the cycle faces,
+    //and its exact part is filtered with natural boundary conditions (one vertex fixed to remove the constant)
+    MatrixXd candidateFieldVecs(3*F.rows(), numGenerators);
+    igl::parallel_for(numGenerators, [&](const int i)
+    {
+      SparseVector<double> singleCycle = basisCycles.row(firstGenerator+i).transpose();
       VectorXd candidateFunc=VectorXd::Zero(V.rows());
-      
       VectorXi cycleFaces=VectorXi::Zero(F.rows());
       for (SparseVector<double>::InnerIterator it(singleCycle); it; ++it)
       {
-        candidateFunc(EV(it.index(),0))=(it.value() > 0 ? 1.0 : 0.0);
-        candidateFunc(EV(it.index(),1))=(it.value() > 0 ? 0.0 : 1.0);
-        cycleFaces(EF(it.index(),0))=1;
-        cycleFaces(EF(it.index(),1))=1;
+        int edge=innerEdges(it.index());
+        candidateFunc(EV(edge,0))=(it.value() > 0 ? 1.0 : 0.0);
+        candidateFunc(EV(edge,1))=(it.value() > 0 ? 0.0 : 1.0);
+        cycleFaces(EF(edge,0))=1;
+        cycleFaces(EF(edge,1))=1;
       }
       
       VectorXd candidateFieldVec = Gv*candidateFunc;
-      for(int i=0;i<F.rows();i++)
-        if (!cycleFaces(i))
-          candidateFieldVec.segment(3*i,3).setZero();
-      
-      //solving for exact part
-      VectorXd exactFunc;
-      igl::min_quad_with_fixed_data<double> mqwfExact;
-      // Linear term is 0
-      VectorXd B = -D*candidateFieldVec;
-      VectorXd Beq;
-      SparseMatrix<double> Aeq;
-      Eigen::VectorXi b(1); b(0)=0;
-      Eigen::VectorXd bc(1); bc(0)=0;
-
-      igl::min_quad_with_fixed_precompute(Lv,b,Aeq,true,mqwfExact);
-      igl::min_quad_with_fixed_solve(mqwfExact,B,bc,Beq,exactFunc);
-      
-      //FIltering exact part
-      VectorXd harmFieldVec = candidateFieldVec-Gv*exactFunc;
-      harmFieldVec=harmFieldVec/harmFieldVec.norm()*10.0;
-      
-      std::cout<<"harmFieldVec.norm(): "<<harmFieldVec.norm()<<std::endl;
+      for(int f=0;f<F.rows();f++)
+        if (!cycleFaces(f))
+          candidateFieldVec.segment(3*f,3).setZero();
+      candidateFieldVecs.col(i)=candidateFieldVec;
+    }, 2);
+    
+    MatrixXd harmFieldVecs(3*F.rows(), numGenerators+std::max(numBoundaries-1,0));
+    if (numGenerators>0){
+      VectorXi isFixed=VectorXi::Zero(V.rows());
+      isFixed(0)=1;
+      MatrixXd exactFuncs;
+      reduced_laplacian_solve(Lv, isFixed, D*candidateFieldVecs, exactFuncs);
+      harmFieldVecs.leftCols(numGenerators) = candidateFieldVecs-Gv*exactFuncs;
+    }
+    
+    //Boundary generators: rotated non-conforming gradients J*Ge*psi of the mid-edge (Crouzeix-Raviart) harmonic functions that are 1 on the edges
+    //of one boundary loop and 0 on the edges of all others. Their curl C*J*Ge*psi=Ge^T*Mchi*Ge*psi vanishes on the inner edges by construction,
+    //and rotated non-conforming gradients are orthogonal to all conforming gradients, so they are divergence-free as well.
+    if (numBoundaries>1){
+      VectorXi vertexLoop=VectorXi::Constant(V.rows(),-1);
+      for (int i=0;i<numBoundaries;i++)
+        for (int j=0;j<boundaryLoops[i].size();j++)
+          vertexLoop(boundaryLoops[i][j])=i;
+      VectorXi isBoundaryEdge=VectorXi::Zero(EV.rows());
+      MatrixXd boundaryValues=MatrixXd::Zero(EV.rows(), numBoundaries-1);
+      for (int i=0;i<EV.rows();i++){
+        if ((EF(i,0)!=-1)&&(EF(i,1)!=-1))
+          continue;
+        isBoundaryEdge(i)=1;
+        if (vertexLoop(EV(i,0))>0)
+          boundaryValues(i,vertexLoop(EV(i,0))-1)=1.0;
+      }
+      SparseMatrix<double> Le = Ge.transpose()*Mchi*Ge;
+      MatrixXd boundaryFuncs;
+      reduced_laplacian_solve(Le, isBoundaryEdge, -Le*boundaryValues, boundaryFuncs);
+      harmFieldVecs.rightCols(numBoundaries-1) = J*Ge*(boundaryFuncs+boundaryValues);
+    }
+    
+    for (int i=0;i<harmFieldVecs.cols();i++){
+      VectorXd harmFieldVec=harmFieldVecs.col(i)/harmFieldVecs.col(i).norm()*10.0;
       
-      //sanity check:
-      std::cout<<"(D*harmFieldVec).lpNorm<Infinity>(): "<<(D*harmFieldVec).lpNorm<Infinity>()<<std::endl;
-      std::cout<<"(C*harmFieldVec).lpNorm<Infinity>(): "<<(C*harmFieldVec).lpNorm<Infinity>()<<std::endl;
+      if (verbose){
+        std::cout<<"harmFieldVec.norm(): "<<harmFieldVec.norm()<<std::endl;
+        std::cout<<"(D*harmFieldVec).lpNorm<Infinity>(): "<<(D*harmFieldVec).lpNorm<Infinity>()<<std::endl;
+        std::cout<<"(C*harmFieldVec).lpNorm<Infinity>(): "<<(C*harmFieldVec).lpNorm<Infinity>()<<std::endl;
+      }
       
       harmFields.push_back(Eigen::MatrixXd(F.rows(),3));
-      for (int i=0;i<F.rows();i++)
+      for (int f=0;f<F.rows();f++)
         for (int j=0;j<3;j++)
-          harmFields[harmFields.size()-1](i,j)=harmFieldVec(3*i+j);
-
+          harmFields[harmFields.size()-1](f,j)=harmFieldVec(3*f+j);
     }
-
   }
 }
 
@@ -18,6 +18,7 @@
 #include <igl/edge_topology.h>
 #include <directional/FEM_masses.h>
 #include <directional/FEM_suite.h>
+#include <directional/face_geometry.h>
 #include <igl/per_face_normals.h>
 
 
@@ -60,8 +61,11 @@ namespace directional
     for (int i=0;i<F.rows();i++)
       rawFieldVec.segment(3*i,3)=rawField.row(i).transpose();
     
-    directional::FEM_suite(V, F, EV, FE, EF, Gv, Ge, J, C, D);
-    directional::FEM_masses(V, F, EV, FE, EF, MvVec, MeVec, MfVec, MchiVec);
+    MatrixXd faceEdgeVectors, cornerAngles, cornerCotangents;
+    VectorXd faceDoubleAreas;
+    directional::face_geometry(V, F, faceEdgeVectors, faceDoubleAreas, cornerAngles, cornerCotangents);
+    directional::FEM_suite(V, F, EV, FE, EF, faceEdgeVectors, faceDoubleAreas, Gv, Ge, J, C, D);
+    directional::FEM_masses(V, F, EV, FE, EF, faceDoubleAreas, MvVec, MeVec, MfVec, MchiVec);
     
     igl::diag(MvVec,Mv);
     igl::diag(MeVec,Me);
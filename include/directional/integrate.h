@@ -24,6 +24,7 @@
 #include <directional/setup_integration.h>
 #include <directional/branched_gradient.h>
 #include <directional/iterative_rounding.h>
+#include <directional/ProfileReport.h>
 
 
 namespace directional
@@ -35,6 +36,7 @@ namespace directional
     //  field:              The face-based field to be integrated, on the original mesh
     //  intData:            Integration data, which must be obtained from directional::setup_integration(). This is altered by the function.
     //  meshCut:            Cut mesh (obtained from setup_integration())
+    //  report:             optional profiling report
     // Output:
     //  NFunction:          #cV x N parameterization functions per cut vertex (full version with all symmetries unpacked)
     //  NCornerFunctions   (3*N) x #F parameterization functions per corner of whole mesh
@@ -42,12 +44,14 @@ namespace directional
                               IntegrationData& intData,
                               const directional::TriMesh& meshCut,
                               Eigen::MatrixXd& NFunction,
-                              Eigen::MatrixXd& NCornerFunctions)
+                              Eigen::MatrixXd& NCornerFunctions,
+                              directional::ProfileReport* report=NULL)
 
 
     {
         using namespace Eigen;
         using namespace std;
+        directional::ScopedTimer timer(report, "integrate");
 
         assert(field.tb->discTangType()==discTangTypeEnum::FACE_SPACES && "Integrate() only works with face-based fields");
         const directional::TriMesh& meshWhole = *((IntrinsicFaceTangentBundle*)field.tb)->mesh;
@@ -55,7 +59,7 @@ namespace directional
         VectorXd edgeWeights = VectorXd::Constant(meshWhole.FE.maxCoeff() + 1, 1.0);
         //double length = igl::bounding_box_diagonal(wholeV) * intData.lengthRatio;
 
-        int numVars = intData.linRedMat.cols();
+        int numVars = intData.x2CutMat.cols();
         //constructing face differentials
         vector<Triplet<double> >  d0Triplets;
         vector<Triplet<double> > M1Triplets;
@@ -119,25 +123,29 @@ namespace directional
         for (int i=0;i<intData.fixedValues.size();i++)
             fixedValues(intData.fixedIndices(i))=intData.fixedValues(i);
 
-        SparseMatrix<double> Efull = d0 * intData.vertexTrans2CutMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat;
+        SparseMatrix<double> Efull = d0 * intData.x2CutMat;
         VectorXd x, xprev;
 
         // until then all the N depedencies should be resolved?
 
         //reducing constraintMat
         SparseQR<SparseMatrix<double>, COLAMDOrdering<int> > qrsolver;
-        SparseMatrix<double> Cfull = intData.constraintMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat;
-        if (Cfull.rows()!=0){
-            qrsolver.compute(Cfull.transpose());
+        const SparseMatrix<double>& x2ConstraintMat = intData.x2ConstraintMat;
+        SparseMatrix<double> Cfull(0, x2ConstraintMat.cols());  //the linearly-independent rows of the constraints
+        if (x2ConstraintMat.rows()!=0){
+            directional::ScopedTimer qrTimer(report, "integrate.constraint_rank");
+            if (report)
+                report->add_counter("integrate.factorizations");
+            qrsolver.compute(x2ConstraintMat.transpose());
             int CRank = qrsolver.rank();
 
             //creating sliced permutation matrix
             VectorXi PIndices = qrsolver.colsPermutation().indices();
 
             vector<Triplet<double> > CTriplets;
-            for(int k = 0; k < Cfull.outerSize(); ++k)
+            for(int k = 0; k < x2ConstraintMat.outerSize(); ++k)
             {
-                for(SparseMatrix<double>::InnerIterator it(Cfull, k); it; ++it)
+                for(SparseMatrix<double>::InnerIterator it(x2ConstraintMat, k); it; ++it)
                 {
                     for(int j = 0; j < CRank; j++)
                         if(it.row() == PIndices(j))
@@ -145,13 +153,14 @@ namespace directional
                 }
             }
 
-            Cfull.resize(CRank, Cfull.cols());
+            Cfull.resize(CRank, x2ConstraintMat.cols());
             Cfull.setFromTriplets(CTriplets.begin(), CTriplets.end());
         }
         SparseMatrix<double> var2AllMat;
         VectorXd fullx(numVars); fullx.setZero();
         for(int intIter = 0; intIter < fixedMask.sum(); intIter++)
         {
+            directional::ScopedTimer poissonTimer(report, "integrate.poisson");
             //the non-fixed variables to all variables
             var2AllMat.resize(numVars, numVars - alreadyFixed.sum());
             int varCounter = 0;
@@ -175,6 +184,8 @@ namespace directional
             int CpartRank=0;
             VectorXi PIndices(0);
             if (Cpart.rows()!=0){
+                if (report)
+                    report->add_counter("integrate.factorizations");
                 qrsolver.compute(Cpart.transpose());
                 CpartRank = qrsolver.rank();
 
@@ -226,6 +237,8 @@ namespace directional
             b.segment(EtE.rows(), Cpart.rows()) = bpart;
 
             SparseLU<SparseMatrix<double> > lusolver;
+            if (report)
+                report->add_counter("integrate.factorizations");
             lusolver.compute(A);
             if(lusolver.info() != Success){
                 if (intData.verbose)
@@ -276,7 +289,7 @@ namespace directional
         }
 
         //the results are packets of N functions for each vertex, and need to be allocated for corners
-        VectorXd NFunctionVec = intData.vertexTrans2CutMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat * fullx;
+        VectorXd NFunctionVec = intData.x2CutMat * fullx;
         NFunction.resize(meshCut.V.rows(), intData.N);
         for(int i = 0; i < NFunction.rows(); i++)
             NFunction.row(i) << NFunctionVec.segment(intData.N * i, intData.N).transpose();
@@ -294,8 +307,7 @@ namespace directional
         //igl::per_face_normals(cutV, meshCut, FN);
         branched_gradient(meshCut.V,meshCut.F, intData.N, G);
         //cout<<"cutF.rows(): "<<cutF.rows()<<endl;
-        SparseMatrix<double> Gd=G*intData.vertexTrans2CutMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat;
-        SparseMatrix<double> x2CornerMat=intData.vertexTrans2CutMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat;
+        SparseMatrix<double> Gd=G*intData.x2CutMat;
         //igl::matlab::MatlabWorkspace mw;
         VectorXi integerIndices(intData.integerVars.size()*intData.n);
         for(int i = 0; i < intData.integerVars.size(); i++)
@@ -303,14 +315,14 @@ namespace directional
                 integerIndices(intData.n * i+j) = intData.n * intData.integerVars(i)+j;
 
 
-        bool success=directional::iterative_rounding(Efull, field.extField, intData.fixedIndices, intData.fixedValues, intData.singularIndices, integerIndices, intData.lengthRatio, gamma, Cfull, Gd, meshCut.faceNormals, intData.N, intData.n, meshCut.V, meshCut.F, x2CornerMat,  intData.integralSeamless, intData.roundSeams, intData.localInjectivity, intData.verbose, fullx);
+        bool success=directional::iterative_rounding(Efull, field.extField, intData.fixedIndices, intData.fixedValues, intData.singularIndices, integerIndices, intData.lengthRatio, gamma, Cfull, Gd, meshCut.faceNormals, intData.N, intData.n, meshCut.V, meshCut.F, intData.x2CutMat,  intData.integralSeamless, intData.roundSeams, intData.localInjectivity, intData.verbose, fullx, report);
 
 
         if ((!success)&&(intData.verbose))
             cout<<"Rounding has failed!"<<endl;
 
         //the results are packets of N functions for each vertex, and need to be allocated for corners
-        NFunctionVec = intData.vertexTrans2CutMat * intData.linRedMat * intData.singIntSpanMat * intData.intSpanMat * fullx;
+        NFunctionVec = intData.x2CutMat * fullx;
         NFunction.resize(meshCut.V.rows(), intData.N);
         for(int i = 0; i < NFunction.rows(); i++)
             NFunction.row(i) << NFunctionVec.segment(intData.N * i, intData.N).transpose();
@@ -14,6 +14,7 @@
 #include <SaddlePoint/DiagonalDamping.h>
 #include <directional/SIInitialSolutionTraits.h>
 #include <directional/IterativeRoundingTraits.h>
+#include <directional/ProfileReport.h>
 #include <iostream>
 #include <Eigen/Core>
 #include <iomanip>
@@ -39,8 +40,8 @@ bool iterative_rounding(const Eigen::SparseMatrix<double>& A,
                         const Eigen::VectorXi& integerIndices,
                         const double lengthRatio,
                         const Eigen::VectorXd& b,
-                        const Eigen::SparseMatrix<double> C,
-                        const Eigen::SparseMatrix<double> G,
+                        const Eigen::SparseMatrix<double>& C,
+                        const Eigen::SparseMatrix<double>& G,
                         const Eigen::MatrixXd& FN,
                         const int N,
                         const int n,
@@ -51,10 +52,12 @@ bool iterative_rounding(const Eigen::SparseMatrix<double>& A,
                         const bool roundSeams,
                         const bool localInjectivity,
                         const bool verbose,
-                        Eigen::VectorXd& fullx){
+                        Eigen::VectorXd& fullx,
+                        directional::ProfileReport* report=NULL){
   
   using namespace Eigen;
   using namespace std;
+  directional::ScopedTimer timer(report, "iterative_rounding");
   
   typedef SaddlePoint::EigenSolverWrapper<Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > > LinearSolver;
   
@@ -88,10 +91,15 @@ bool iterative_rounding(const Eigen::SparseMatrix<double>& A,
   //initial solution
   if (verbose)
     cout<<"Computing initial solution..."<<endl;
-  slTraits.init(verbose);
-  initialSolutionLMSolver.init(&lSolver1, &slTraits, &dISTraits, 100);
-  //SaddlePoint::check_traits(slTraits, slTraits.initXandFieldSmall);
-  initialSolutionLMSolver.solve(false);
+  {
+    directional::ScopedTimer initTimer(report, "iterative_rounding.initial_solution");
+    slTraits.init(verbose);
+    initialSolutionLMSolver.init(&lSolver1, &slTraits, &dISTraits, 100);
+    //SaddlePoint::check_traits(slTraits, slTraits.initXandFieldSmall);
+    initialSolutionLMSolver.solve(false);
+  }
+  if (report)
+    report->add_counter("iterative_rounding.lm_iterations", initialSolutionLMSolver.currIter);
   if (verbose){
     cout<<"Done!"<<endl;
     cout<<"Integrability error: "<<slTraits.integrability<<endl;
@@ -126,9 +134,14 @@ bool iterative_rounding(const Eigen::SparseMatrix<double>& A,
     if (!irTraits.initFixedIndices())
       continue;
     hasRounded=true;
+    directional::ScopedTimer roundTimer(report, "iterative_rounding.rounding_step");
     dIRTraits.currLambda=(localInjectivity ? 0.01 : 0.0);
     iterativeRoundingLMSolver.init(&lSolver2, &irTraits, &dIRTraits, 100, 1e-7, 1e-7);
     iterativeRoundingLMSolver.solve(false);
+    if (report){
+      report->add_counter("iterative_rounding.rounding_steps");
+      report->add_counter("iterative_rounding.lm_iterations", iterativeRoundingLMSolver.currIter);
+    }
     if (verbose){
       printElement(irTraits.currRoundIndex, colWidth);
       printElement(irTraits.origValue, colWidth);
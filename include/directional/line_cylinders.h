@@ -9,10 +9,13 @@
 #define DIRECTIONAL_LINE_CYLINDERS_H
 #include <igl/igl_inline.h>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <string>
 #include <vector>
 #include <cmath> 
 #include <complex>
+#include <igl/PI.h>
+#include <directional/mesh_instances.h>
 
 
 namespace directional
@@ -79,6 +82,59 @@ namespace directional
     }
     return true;
   }
+
+
+  // The same cylinders as an instanced representation: a template cylinder of unit length along the x axis with unit radius,
+  // and the frame and color of each cylinder (see mesh_instances_to_mesh()).
+  // Inputs:
+  //  P1,P2:      #P by 3 coordinates of the endpoints of the cylinders
+  //  radius:     Cylinder base radii
+  //  cyndColors: #P by 3 RBG colors per cylinder
+  //  res:        The resolution of the cylinder (size of base polygon)
+  // Outputs:
+  //  instances:  the template cylinder, and the per-cylinder frames and colors
+  IGL_INLINE void line_cylinders_instances(const Eigen::MatrixXd& P1,
+                                           const Eigen::MatrixXd& P2,
+                                           const double& radius,
+                                           const Eigen::MatrixXd& cyndColors,
+                                           const int res,
+                                           directional::MeshInstances& instances)
+  {
+    using namespace Eigen;
+    instances.templateV.resize(2*res,3);
+    instances.templateF.resize(2*res,3);
+    for (int j=0;j<res;j++){
+      std::complex<double> CurrRoot=exp(2*igl::PI*std::complex<double>(0,1)*(double)j/(double)res);
+      instances.templateV.row(2*j)<<0.0, CurrRoot.real(), CurrRoot.imag();
+      instances.templateV.row(2*j+1)<<1.0, CurrRoot.real(), CurrRoot.imag();
+      instances.templateF.row(2*j)<<2*((j+1)%res),2*j+1,2*j;
+      instances.templateF.row(2*j+1)<<2*((j+1)%res)+1,2*j+1,2*((j+1)%res);
+    }
+
+    RowVector3d ZAxis; ZAxis<<0.0,0.0,1.0;
+    RowVector3d YAxis; YAxis<<0.0,1.0,0.0;
+
+    instances.positions.resize(P1.rows(),3);
+    instances.xAxes.resize(P1.rows(),3);
+    instances.yAxes.resize(P1.rows(),3);
+    instances.zAxes.resize(P1.rows(),3);
+    instances.colors.resize(P1.rows(),3);
+    for (int i=0;i<P1.rows();i++){
+      RowVector3d NormAxis=(P2.row(i)-P1.row(i)).normalized();
+      RowVector3d PlaneAxis1=NormAxis.cross(ZAxis);
+      if (PlaneAxis1.norm()<10e-2)
+        PlaneAxis1=NormAxis.cross(YAxis).normalized();
+      else
+        PlaneAxis1=PlaneAxis1.normalized();
+      RowVector3d PlaneAxis2=NormAxis.cross(PlaneAxis1).normalized();
+
+      instances.positions.row(i)=P1.row(i).cast<float>();
+      instances.xAxes.row(i)=(P2.row(i)-P1.row(i)).cast<float>();
+      instances.yAxes.row(i)=(PlaneAxis1*radius).cast<float>();
+      instances.zAxes.row(i)=(PlaneAxis2*radius).cast<float>();
+      instances.colors.row(i)=cyndColors.row(i).cast<float>();
+    }
+  }
   
 }
 
@@ -21,6 +21,7 @@
 #include <directional/polygonal_edge_topology.h>
 #include <directional/FunctionMesh.h>
 #include <directional/setup_mesh_function_isolines.h>
+#include <directional/ProfileReport.h>
 
 namespace directional{
 
@@ -30,6 +31,7 @@ namespace directional{
 //  origMesh:     the original whole mesh
 //  mfiData:      a MeshFunctionIsolinesData object that is pre-filled with the N-function data (can be generated from the integrator with setup_mesh_function_isolines)
 //  verbose:      if to output mesh generation process comments
+//  report:       optional profiling report, which also counts the sizes of the generated arrangement
 //  VOutput:      all vertex coordinates of the output polygonal mesh
 //  DOutput:     |FOutput| vector of face valences
 //  FOutput:      |FOutput| x |max(DOutput)| vertex indices of the face polygons, indexed into VOutput.
@@ -38,23 +40,36 @@ bool mesh_function_isolines(const directional::TriMesh& origMesh,
                             const bool verbose,
                             Eigen::MatrixXd& VOutput,
                             Eigen::VectorXi& DOutput,
-                            Eigen::MatrixXi& FOutput){
-  
+                            Eigen::MatrixXi& FOutput,
+                            directional::ProfileReport* report=NULL){
   
+  directional::ScopedTimer timer(report, "mesh_function_isolines");
   NFunctionMesher TMesh, FMesh;
   
   Eigen::VectorXi VHPoly, HEPoly, HFPoly, nextHPoly, prevHPoly, twinHPoly, HVPoly,innerEdgesPoly;
   Eigen::MatrixXi EHPoly,EFiPoly, FHPoly, EFPoly,EVPoly,FEPoly;
   Eigen::MatrixXd FEsPoly;
-  hedra::polygonal_edge_topology(Eigen::VectorXi::Constant(origMesh.F.rows(),3), origMesh.F,EVPoly,FEPoly,EFPoly, EFiPoly, FEsPoly, innerEdgesPoly);
-  hedra::dcel(Eigen::VectorXi::Constant(origMesh.F.rows(),3),origMesh.F,EVPoly,EFPoly, EFiPoly,innerEdgesPoly,VHPoly, EHPoly, FHPoly,  HVPoly,  HEPoly, HFPoly, nextHPoly, prevHPoly, twinHPoly);
-  
-  TMesh.fromHedraDCEL(Eigen::VectorXi::Constant(origMesh.F.rows(),3),origMesh.V, origMesh.F, EVPoly,FEPoly,EFPoly, EFiPoly, FEsPoly, innerEdgesPoly,VHPoly, EHPoly, FHPoly,  HVPoly,  HEPoly, HFPoly, nextHPoly, prevHPoly, twinHPoly, mfiData.cutV, mfiData.cutF, mfiData.vertexNFunction,  mfiData.N, mfiData.orig2CutMat, mfiData.exactOrig2CutMat, mfiData.integerVars);
+  {
+    directional::ScopedTimer topologyTimer(report, "mesh_function_isolines.topology");
+    hedra::polygonal_edge_topology(Eigen::VectorXi::Constant(origMesh.F.rows(),3), origMesh.F,EVPoly,FEPoly,EFPoly, EFiPoly, FEsPoly, innerEdgesPoly);
+    hedra::dcel(Eigen::VectorXi::Constant(origMesh.F.rows(),3),origMesh.F,EVPoly,EFPoly, EFiPoly,innerEdgesPoly,VHPoly, EHPoly, FHPoly,  HVPoly,  HEPoly, HFPoly, nextHPoly, prevHPoly, twinHPoly);
+    
+    TMesh.fromHedraDCEL(Eigen::VectorXi::Constant(origMesh.F.rows(),3),origMesh.V, origMesh.F, EVPoly,FEPoly,EFPoly, EFiPoly, FEsPoly, innerEdgesPoly,VHPoly, EHPoly, FHPoly,  HVPoly,  HEPoly, HFPoly, nextHPoly, prevHPoly, twinHPoly, mfiData.cutV, mfiData.cutF, mfiData.vertexNFunction,  mfiData.N, mfiData.orig2CutMat, mfiData.exactOrig2CutMat, mfiData.integerVars);
+  }
   
-  if (verbose){
+  if (verbose)
     std::cout<<"Generating mesh"<<std::endl;
+  {
+    directional::ScopedTimer generateTimer(report, "mesh_function_isolines.arrangement");
     TMesh.GenerateMesh(FMesh);
+  }
+  if (verbose)
     std::cout<<"Done generating!"<<std::endl;
+  
+  if (report){
+    report->add_counter("mesh_function_isolines.arrangement_vertices", FMesh.Vertices.size());
+    report->add_counter("mesh_function_isolines.arrangement_halfedges", FMesh.Halfedges.size());
+    report->add_counter("mesh_function_isolines.arrangement_faces", FMesh.Faces.size());
   }
   
   Eigen::VectorXi genInnerEdges,genTF;
@@ -64,7 +79,11 @@ bool mesh_function_isolines(const directional::TriMesh& origMesh,
   if (verbose)
     std::cout<<"Cleaning Mesh"<<std::endl;
   
-  bool success = FMesh.SimplifyMesh(verbose, mfiData.N);
+  bool success;
+  {
+    directional::ScopedTimer simplifyTimer(report, "mesh_function_isolines.simplify");
+    success = FMesh.SimplifyMesh(verbose, mfiData.N);
+  }
   
   if (success){
     if (verbose)
@@ -0,0 +1,70 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_MESH_INSTANCES_H
+#define DIRECTIONAL_MESH_INSTANCES_H
+
+#include <igl/igl_inline.h>
+#include <Eigen/Core>
+
+
+namespace directional
+{
+
+  // An instanced representation of many copies of a single template mesh (such as the cylinders of line_cylinders(), the spheres of point_spheres(), or the glyphs of glyph_lines_mesh()),
+  // each placed by an affine frame and carrying a single color. A template vertex v is placed at position + v.x*xAxis + v.y*yAxis + v.z*zAxis,
+  // where the axes are not necessarily unit or orthogonal. This is meant to be fed to instanced renderers or exported.
+  struct MeshInstances{
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> InstanceMatrix;
+
+    Eigen::MatrixXd templateV;  //the vertices of the template mesh
+    Eigen::MatrixXi templateF;  //the faces of the template mesh
+
+    InstanceMatrix positions;   //#instances by 3 translations
+    InstanceMatrix xAxes;       //#instances by 3 images of the template x axis
+    InstanceMatrix yAxes;       //#instances by 3 images of the template y axis
+    InstanceMatrix zAxes;       //#instances by 3 images of the template z axis
+    InstanceMatrix colors;      //#instances by 3 RGB colors
+
+    MeshInstances(){}
+    ~MeshInstances(){}
+  };
+
+
+  // Expands mesh instances into an explicit mesh, for renderers without instancing.
+  // Input:
+  //  instances:    as created by line_cylinders_instances(), point_spheres_instances() or glyph_lines_instances()
+  //  vertexColors: whether the colors are given per vertex (as point_spheres()) or per face (as line_cylinders() and glyph_lines_mesh())
+  // Outputs:
+  //  V:  The vertices of the mesh
+  //  T:  The faces of the mesh
+  //  C:  The colors of the mesh
+  void IGL_INLINE mesh_instances_to_mesh(const MeshInstances& instances,
+                                         Eigen::MatrixXd &V,
+                                         Eigen::MatrixXi &T,
+                                         Eigen::MatrixXd &C,
+                                         const bool vertexColors=false)
+  {
+    int numTemplateV=instances.templateV.rows();
+    int numTemplateF=instances.templateF.rows();
+    int numInstances=instances.positions.rows();
+    int numTemplateC=(vertexColors ? numTemplateV : numTemplateF);
+    V.resize(numTemplateV*numInstances,3);
+    T.resize(numTemplateF*numInstances,3);
+    C.resize(numTemplateC*numInstances,3);
+    for (int i=0;i<numInstances;i++){
+      Eigen::Matrix3d frame;
+      frame<<instances.xAxes.row(i).cast<double>(), instances.yAxes.row(i).cast<double>(), instances.zAxes.row(i).cast<double>();
+      V.block(numTemplateV*i,0,numTemplateV,3) = instances.templateV*frame+instances.positions.row(i).cast<double>().replicate(numTemplateV,1);
+      T.block(numTemplateF*i,0,numTemplateF,3) = instances.templateF.array()+numTemplateV*i;
+      C.block(numTemplateC*i,0,numTemplateC,3) = instances.colors.row(i).cast<double>().replicate(numTemplateC,1);
+    }
+  }
+
+}
+
+#endif
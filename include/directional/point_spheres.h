@@ -12,11 +12,46 @@
 #include <vector>
 #include <cmath>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <igl/igl_inline.h>
+#include <igl/PI.h>
+#include <directional/mesh_instances.h>
 
 
 namespace directional
 {
+  // The template sphere of radius r around the origin, with its poles on the z axis
+  IGL_INLINE void sphere_template(const double& r,
+                                  const int res,
+                                  Eigen::MatrixXd& VSphere,
+                                  Eigen::MatrixXi& TSphere)
+  {
+    VSphere.resize(res*res,3);
+    TSphere.resize(2*(res-1)*res,3);
+    
+    //creating template sphere vertices
+    for (int j=0;j<res;j++){
+      double z=r*cos(igl::PI*(double)j/(double(res-1)));
+      for (int k=0;k<res;k++){
+        double x=r*sin(igl::PI*(double)j/(double(res-1)))*cos(2*igl::PI*(double)k/(double(res)));
+        double y=r*sin(igl::PI*(double)j/(double(res-1)))*sin(2*igl::PI*(double)k/(double(res)));
+        VSphere.row(j*res+k)<<x,y,z;
+      }
+    }
+    
+  
+    for (int j=0;j<res-1;j++){
+      for (int k=0;k<res;k++){
+        int v1=j*res+k;
+        int v2=(j+1)*res+k;
+        int v3=(j+1)*res+(k+1)%res;
+        int v4=j*res+(k+1)%res;
+        TSphere.row(2*(res*j+k))<<v1,v2,v3;
+        TSphere.row(2*(res*j+k)+1)<<v4,v1,v3;
+      }
+    }
+  }
+
   // creates small spheres to visualize P on the overlay of the mesh
   // Input:
   //  P:      #P by 3 coordinates of the centers of spheres
@@ -43,30 +78,9 @@ namespace directional
     T.resize(2*(res-1)*res*P.rows(),3);
     C.resize(V.rows(),3);*/
     
-    MatrixXd VSphere(res*res,3);
-    MatrixXi TSphere(2*(res-1)*res,3);
-    
-    //creating template sphere vertices
-    for (int j=0;j<res;j++){
-      double z=r*cos(igl::PI*(double)j/(double(res-1)));
-      for (int k=0;k<res;k++){
-        double x=r*sin(igl::PI*(double)j/(double(res-1)))*cos(2*igl::PI*(double)k/(double(res)));
-        double y=r*sin(igl::PI*(double)j/(double(res-1)))*sin(2*igl::PI*(double)k/(double(res)));
-        VSphere.row(j*res+k)<<x,y,z;
-      }
-    }
-    
-  
-    for (int j=0;j<res-1;j++){
-      for (int k=0;k<res;k++){
-        int v1=j*res+k;
-        int v2=(j+1)*res+k;
-        int v3=(j+1)*res+(k+1)%res;
-        int v4=j*res+(k+1)%res;
-        TSphere.row(2*(res*j+k))<<v1,v2,v3;
-        TSphere.row(2*(res*j+k)+1)<<v4,v1,v3;
-      }
-    }
+    MatrixXd VSphere;
+    MatrixXi TSphere;
+    sphere_template(r, res, VSphere, TSphere);
     
     //std::cout<<"TSphere: "<<TSphere<<std::endl;
     V.resize(VSphere.rows()*P.rows(),3);
@@ -95,6 +109,50 @@ namespace directional
     return true;
   }
 
+  // The same spheres as an instanced representation: a template sphere of radius r around the origin, with its poles on the z axis,
+  // and the frame and color of each sphere (see mesh_instances_to_mesh(), with vertexColors=true).
+  // Input:
+  //  P:      #P by 3 coordinates of the centers of spheres
+  //  N:      #P by 3 normals (the south-north pole direction of the spheres).
+  //  r: radii of the spheres
+  //  sphereColors:      #P by 3 - RBG colors per sphere
+  //  res:    the resolution of the sphere discretization
+  // Output:
+  //  instances:  the template sphere, and the per-sphere frames and colors
+  IGL_INLINE void point_spheres_instances(const Eigen::MatrixXd& P,
+                                          const Eigen::MatrixXd& normals,
+                                          const double& r,
+                                          const Eigen::MatrixXd& sphereColors,
+                                          const int res,
+                                          directional::MeshInstances& instances)
+  {
+    using namespace Eigen;
+    sphere_template(r, res, instances.templateV, instances.templateF);
+
+    instances.positions.resize(P.rows(),3);
+    instances.xAxes.resize(P.rows(),3);
+    instances.yAxes.resize(P.rows(),3);
+    instances.zAxes.resize(P.rows(),3);
+    instances.colors.resize(P.rows(),3);
+    for (int i=0;i<P.rows();i++){
+      RowVector3d ZAxis=normals.row(i);
+      ZAxis.normalize();
+      RowVector3d XAxis; XAxis<<0.0, -normals(i,2), normals(i,1);
+      if (XAxis.squaredNorm()<1e-4)
+        XAxis<<-normals(i,2),0.0,normals(i,0);
+      XAxis.normalize();
+      
+      RowVector3d YAxis =ZAxis.cross(XAxis);
+      YAxis.rowwise().normalize();
+
+      instances.positions.row(i)=P.row(i).cast<float>();
+      instances.xAxes.row(i)=XAxis.cast<float>();
+      instances.yAxes.row(i)=YAxis.cast<float>();
+      instances.zAxes.row(i)=ZAxis.cast<float>();
+      instances.colors.row(i)=sphereColors.row(i).cast<float>();
+    }
+  }
+
 }
 
 
@@ -8,10 +8,14 @@
 
 
 #include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <limits>
 #include <igl/parallel_transport_angles.h>
 #include <igl/local_basis.h>
 #include <igl/edge_topology.h>
-#include <igl/sparse.h>
+#include <igl/parallel_for.h>
 #include <igl/sort.h>
 #include <igl/slice.h>
 #include <igl/slice_into.h>
@@ -32,7 +36,26 @@ IGL_INLINE directional::polycurl_reduction_parameters::polycurl_reduction_parame
         wCloseConstrained(100),
         redFactor_wsmooth(.8),
         gamma(0.1),
-        tikh_gamma(1e-8)
+        tikh_gamma(1e-8),
+        timeBudget(0.0),
+        verbose(false)
+{}
+
+
+IGL_INLINE directional::polycurl_reduction_status::polycurl_reduction_status():
+        success(true),
+        converged(false),
+        cancelled(false),
+        iterations(0),
+        energy(0.0),
+        ESmooth(0.0),
+        EClose(0.0),
+        EBarrier(0.0),
+        ECurl(0.0),
+        EQuotCurl(0.0),
+        timeResiduals(0.0),
+        timeLinearSolve(0.0),
+        timeLineSearch(0.0)
 {}
 
 
@@ -45,6 +68,8 @@ namespace directional
     private:
 
         PolyCurlReductionSolverData &data;
+        //the minimal size of the inner loops to run in parallel, kept per solve so that the data is not modified
+        int minParallel;
         //Symbolic calculations
         IGL_INLINE void rj_barrier_face(const Eigen::RowVectorXd &vec2D_a,
                                         const double &s,
@@ -79,14 +104,17 @@ namespace directional
 
     public:
         IGL_INLINE PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata);
+        IGL_INLINE PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata, const int _minParallel);
 
         IGL_INLINE bool solve(polycurl_reduction_parameters &params,
                               Eigen::MatrixXd& currentField,
-                              bool fieldNotCCW);
+                              bool fieldNotCCW,
+                              polycurl_reduction_status &status);
 
         IGL_INLINE void solveGaussNewton(polycurl_reduction_parameters &params,
                                          const Eigen::VectorXd &x_initial,
-                                         Eigen::VectorXd &x);
+                                         Eigen::VectorXd &x,
+                                         polycurl_reduction_status &status);
 
         //Compute residuals and Jacobian for Gauss Newton
         IGL_INLINE double RJ(const Eigen::VectorXd &x,
@@ -126,11 +154,17 @@ namespace directional
 
 
     };
+
+    //Solves for a single field with the given solver, writing the result back into the field
+    IGL_INLINE polycurl_reduction_status solve_polycurl_field(PolyCurlReductionSolver &cffs,
+                                                              polycurl_reduction_parameters &params,
+                                                              directional::CartesianField& currentField,
+                                                              bool fieldNotCCW);
 };
 
 
 
-IGL_INLINE directional::PolyCurlReductionSolverData::PolyCurlReductionSolverData(){}
+IGL_INLINE directional::PolyCurlReductionSolverData::PolyCurlReductionSolverData():minParallel(1000){}
 
 IGL_INLINE void directional::PolyCurlReductionSolverData::precomputeMesh(const Eigen::MatrixXd &_V,
                                                                          const Eigen::MatrixXi &_F)
@@ -445,7 +479,17 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeJacobianPattern
                          startIndexInVectors,
                          II_Jac,
                          JJ_Jac);
-    igl::sparse(II_Jac, JJ_Jac, SS_Jac, Jac);
+
+    //grouping the elements by column, for J^T*r
+    jacColStart.assign(numVariables+1, 0);
+    for (int i=0; i<numJacElements; ++i)
+        jacColStart[JJ_Jac(i)+1]++;
+    for (int c=0; c<numVariables; ++c)
+        jacColStart[c+1]+=jacColStart[c];
+    jacColElements.resize(numJacElements);
+    std::vector<int> colPos(jacColStart.begin(), jacColStart.end()-1);
+    for (int i=0; i<numJacElements; ++i)
+        jacColElements[colPos[JJ_Jac(i)]++] = i;
 }
 
 
@@ -453,6 +497,8 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeJacobianPattern
 IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern()
 {
     //II_Jac is sorted in ascending order already
+    std::vector<int> pairs1, pairs2;
+    std::vector<Eigen::Triplet<double> > Hess_triplets;
     int starti = 0;
     int currI = II_Jac(0);
     for (int ii = 0; ii<II_Jac.rows(); ++ii)
@@ -468,8 +514,8 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern(
             int k2  = II_Jac(jj);
             if (k1 !=k2)
                 break;
-            indInSS_Hess_1_vec.push_back(ii);
-            indInSS_Hess_2_vec.push_back(jj);
+            pairs1.push_back(ii);
+            pairs2.push_back(jj);
             Hess_triplets.push_back(Eigen::Triplet<double> (JJ_Jac(ii),
                                                             JJ_Jac(jj),
                                                             SS_Jac(ii)*SS_Jac(jj)
@@ -477,33 +523,78 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern(
             );
         }
     }
-    Hess.resize(Jac.cols(),Jac.cols());
+    Hess.resize(numVariables,numVariables);
     Hess.setFromTriplets(Hess_triplets.begin(), Hess_triplets.end());
     Hess.makeCompressed();
+
+    //locating every pair in the value array of Hess, and grouping the pairs by it (stably, to sum in the same order as setFromTriplets())
+    std::vector<int> pairPos(pairs1.size());
+    igl::parallel_for(pairs1.size(), [&](const int i)
+    {
+        const int col = Hess_triplets[i].col();
+        const int* begin = Hess.innerIndexPtr()+Hess.outerIndexPtr()[col];
+        const int* end = Hess.innerIndexPtr()+Hess.outerIndexPtr()[col+1];
+        pairPos[i] = std::lower_bound(begin, end, Hess_triplets[i].row())-Hess.innerIndexPtr();
+    }, minParallel);
+
+    hessPairStart.assign(Hess.nonZeros()+1, 0);
+    for (int i=0; i<pairPos.size(); ++i)
+        hessPairStart[pairPos[i]+1]++;
+    for (int i=0; i<Hess.nonZeros(); ++i)
+        hessPairStart[i+1]+=hessPairStart[i];
+    indInSS_Hess_1_vec.resize(pairs1.size());
+    indInSS_Hess_2_vec.resize(pairs2.size());
+    std::vector<int> currPos(hessPairStart.begin(), hessPairStart.end()-1);
+    for (int i=0; i<pairPos.size(); ++i)
+    {
+        indInSS_Hess_1_vec[currPos[pairPos[i]]] = pairs1[i];
+        indInSS_Hess_2_vec[currPos[pairPos[i]]++] = pairs2[i];
+    }
 }
 
 
 
-IGL_INLINE void directional::PolyCurlReductionSolverData::computeNewHessValues()
+IGL_INLINE void directional::PolyCurlReductionSolverData::computeNewHessValues(const int loopMinParallel)
 {
-    for (int i =0; i<Hess_triplets.size(); ++i)
-        Hess_triplets[i] = Eigen::Triplet<double>(Hess_triplets[i].row(),
-                                                  Hess_triplets[i].col(),
-                                                  SS_Jac(indInSS_Hess_1_vec[i])*SS_Jac(indInSS_Hess_2_vec[i])
-        );
+    //J^T*J straight into the values of the fixed pattern; every nonzero is independent
+    double* values = Hess.valuePtr();
+    igl::parallel_for(Hess.nonZeros(), [&](const int i)
+    {
+        double value = 0.0;
+        for (int p = hessPairStart[i]; p<hessPairStart[i+1]; ++p)
+            value += SS_Jac(indInSS_Hess_1_vec[p])*SS_Jac(indInSS_Hess_2_vec[p]);
+        values[i] = value;
+    }, loopMinParallel);
+}
 
-    Hess.setFromTriplets(Hess_triplets.begin(), Hess_triplets.end());
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::computeJtR(Eigen::VectorXd &JtR, const int loopMinParallel) const
+{
+    JtR.resize(numVariables);
+    igl::parallel_for(numVariables, [&](const int c)
+    {
+        double value = 0.0;
+        for (int p = jacColStart[c]; p<jacColStart[c+1]; ++p)
+            value += SS_Jac(jacColElements[p])*residuals(II_Jac(jacColElements[p]));
+        JtR(c) = value;
+    }, loopMinParallel);
 }
 
 
 
-IGL_INLINE directional::PolyCurlReductionSolver::PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata):data(cffsoldata)
+IGL_INLINE directional::PolyCurlReductionSolver::PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata):data(cffsoldata), minParallel(cffsoldata.minParallel)
+{ };
+
+
+IGL_INLINE directional::PolyCurlReductionSolver::PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata, const int _minParallel):data(cffsoldata), minParallel(_minParallel)
 { };
 
 
 IGL_INLINE bool directional::PolyCurlReductionSolver::solve(polycurl_reduction_parameters &params,
                                                             Eigen::MatrixXd& currentField,
-                                                            bool fieldNotCCW)
+                                                            bool fieldNotCCW,
+                                                            polycurl_reduction_status &status)
 {
     Eigen::MatrixXd sol2D;
     Eigen::MatrixXd sol3D = currentField.cast<double>();
@@ -517,75 +608,78 @@ IGL_INLINE bool directional::PolyCurlReductionSolver::solve(polycurl_reduction_p
         x.segment(i*2*2, 2*2) = sol2D.row(i);
 
     //get x
-    solveGaussNewton(params, data.xOriginal, x);
+    solveGaussNewton(params, data.xOriginal, x, status);
     //get output from x
     for (int i =0; i<data.numF; i++)
         sol2D.row(i) = x.segment(i*2*2, 2*2);
     igl::local2global(data.B1, data.B2, sol2D, sol3D);
     currentField = sol3D.cast<double>();
-    return true;
+    return status.success;
 }
 
 
 IGL_INLINE void directional::PolyCurlReductionSolver::solveGaussNewton(polycurl_reduction_parameters &params,
                                                                        const Eigen::VectorXd &x_initial,
-                                                                       Eigen::VectorXd &x)
+                                                                       Eigen::VectorXd &x,
+                                                                       polycurl_reduction_status &status)
 {
-    bool converged = false;
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](const Clock::time_point& from){return std::chrono::duration<double>(Clock::now()-from).count();};
+    const Clock::time_point solveStart = Clock::now();
 
+    status = polycurl_reduction_status();
     double F;
     Eigen::VectorXd xprev = x;
     Eigen::VectorXd xc = igl::slice(x_initial, data.constrained, 1);
-    //  double ESmooth, EClose, ECurl, EQuotCurl, EBarrier;
     for (int innerIter = 0; innerIter<params.numIter; ++innerIter)
     {
+        if ((params.timeBudget>0.0)&&(seconds(solveStart)>params.timeBudget))
+        {
+            status.cancelled = true;
+            status.message = "time budget exceeded";
+            break;
+        }
 
         //set constrained entries to those of the initial
         igl::slice_into(xc, data.constrained, 1, xprev);
 
-
         //get function, gradients and Hessians
+        Clock::time_point phaseStart = Clock::now();
         F = RJ(x, xprev, params, true);
+        status.timeResiduals += seconds(phaseStart);
 
-        printf("PolyCurlReductionSolver -- Iteration %d\n", innerIter);
+        if (params.verbose)
+            std::cout<<"PolyCurlReductionSolver -- Iteration "<<innerIter<<", energy "<<F<<std::endl;
 
-        if((data.residuals.array() == std::numeric_limits<double>::infinity()).any())
+        if(!data.residuals.allFinite())
         {
-            std::cerr<<"PolyCurlReductionSolver -- residuals: got infinity somewhere"<<std::endl;
-            exit(1);
-        };
-        if((data.residuals.array() != data.residuals.array()).any())
-        {
-            std::cerr<<"PolyCurlReductionSolver -- residuals: got infinity somewhere"<<std::endl;
-            exit(1);
-        };
-
-        converged = false;
+            status.success = false;
+            status.message = "non-finite residuals";
+            break;
+        }
 
-        Eigen::VectorXd rhs = data.Jac.transpose()*data.residuals;
+        phaseStart = Clock::now();
+        Eigen::VectorXd rhs;
+        data.computeJtR(rhs, minParallel);
 
-        bool success;
         data.solver.factorize(data.Hess);
-        success = data.solver.info() == Eigen::Success;
-
-        if(!success)
-            std::cerr<<"PolyCurlReductionSolver -- Could not do LU"<<std::endl;
-
-        Eigen::VectorXd direction;
-
-        double error;
-        direction = data.solver.solve(rhs);
-        error = (data.Hess*direction - rhs).cwiseAbs().maxCoeff();
-        if(error> 1e-4)
+        if(data.solver.info() != Eigen::Success)
         {
-            std::cerr<<"PolyCurlReductionSolver -- Could not solve"<<std::endl;
+            status.success = false;
+            status.message = "factorization failed";
+            break;
         }
 
+        Eigen::VectorXd direction = data.solver.solve(rhs);
+        if ((params.verbose)&&((data.Hess*direction - rhs).cwiseAbs().maxCoeff() > 1e-4))
+            std::cout<<"PolyCurlReductionSolver -- inaccurate linear solve"<<std::endl;
+        status.timeLinearSolve += seconds(phaseStart);
+
         // adaptive backtracking
+        phaseStart = Clock::now();
         bool repeat = true;
         int run = 0;
         Eigen::VectorXd cx;
-        Eigen::VectorXd tRes;
         double newF;
         while(repeat)
         {
@@ -603,26 +697,44 @@ IGL_INLINE void directional::PolyCurlReductionSolver::solveGaussNewton(polycurl_
                 if(params.gamma<1e-30)
                 {
                     repeat = false;
-                    converged = true;
+                    status.converged = true;
                 }
             }
             run++;
         }
+        status.timeLineSearch += seconds(phaseStart);
+        status.iterations++;
 
-
-        if (!converged)
+        if (status.converged)
         {
-            xprev = x;
-            x = cx;
+            if (params.verbose)
+                std::cout<<"PolyCurlReductionSolver -- Converged"<<std::endl;
+            break;
         }
-        else
+
+        xprev = x;
+        x = cx;
+
+        if ((params.iterationCallback)&&(!params.iterationCallback(innerIter, newF)))
         {
-            std::cerr<<"PolyCurlReductionSolver -- Converged"<<std::endl;
+            status.cancelled = true;
+            status.message = "cancelled by the iteration callback";
             break;
         }
     }
 
-
+    //the energies at the returned field
+    status.energy = RJ(x, xprev, params);
+    int startRow = 0;
+    status.ESmooth = data.residuals.segment(startRow, data.num_residuals_smooth).squaredNorm();
+    startRow += data.num_residuals_smooth;
+    status.EClose = data.residuals.segment(startRow, data.num_residuals_close).squaredNorm();
+    startRow += data.num_residuals_close;
+    status.EBarrier = data.residuals.segment(startRow, data.num_residuals_barrier).squaredNorm();
+    startRow += data.num_residuals_barrier;
+    status.ECurl = data.residuals.segment(startRow, data.num_residuals_polycurl).squaredNorm();
+    startRow += data.num_residuals_polycurl;
+    status.EQuotCurl = data.residuals.segment(startRow, data.num_residuals_quotcurl).squaredNorm();
 }
 
 
@@ -637,7 +749,9 @@ IGL_INLINE double directional::PolyCurlReductionSolver::RJ(const Eigen::VectorXd
     for (int i =0; i<data.numF; i++)
         sol02D.row(i) = x0.segment(i*2*2, 2*2);
 
-    data.SS_Jac.setZero(data.numJacElements);
+    //a residual-only evaluation (as in the line search) does not touch the Jacobian
+    if (doJacs)
+        data.SS_Jac.setZero(data.numJacElements);
 
     //set stuff (attention: order !)
     int startRowInJacobian = 0;
@@ -667,13 +781,9 @@ IGL_INLINE double directional::PolyCurlReductionSolver::RJ(const Eigen::VectorXd
     RJ_QuotCurl(sol2D, sqrt(params.wQuotCurl), startRowInJacobian, doJacs, startIndexInVectors);
 
     if(doJacs)
-    {
-        for (int i =0; i<data.numJacElements; ++i)
-            data.Jac.coeffRef(data.II_Jac(i), data.JJ_Jac(i)) = data.SS_Jac(i);
-        data.computeNewHessValues();
-    }
+        data.computeNewHessValues(minParallel);
 
-    return data.residuals.transpose()*data.residuals;
+    return data.residuals.squaredNorm();
 }
 
 
@@ -761,8 +871,12 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Smoothness(const Eigen:
                                                                     const int startIndexInVectors)
 {
     if (wSmoothSqrt ==0)
+    {
+        data.residuals.segment(startRowInJacobian, data.num_residuals_smooth).setZero();
         return;
-    for (int ii=0; ii<data.numInteriorEdges; ++ii)
+    }
+    //every element writes its own residual rows and Jacobian slots
+    igl::parallel_for(data.numInteriorEdges, [&](const int ii)
     {
         // the two faces of the flap
         int a = data.E2F_int(ii,0);
@@ -789,7 +903,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Smoothness(const Eigen:
             int startIndex = startIndexInVectors+data.numInnerJacRows_smooth*data.numInnerJacCols_edge*ii;
             data.add_Jacobian_to_svector(startIndex, wSmoothSqrt*tJac,data.SS_Jac);
         }
-    }
+    }, minParallel);
 }
 
 
@@ -851,9 +965,12 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Barrier(const Eigen::Ma
                                                                  const int startIndexInVectors)
 {
     if (wBarrierSqrt ==0)
+    {
+        data.residuals.segment(startRowInJacobian, data.num_residuals_barrier).setZero();
         return;
+    }
 
-    for (int fi=0; fi<data.numF; ++fi)
+    igl::parallel_for(data.numF, [&](const int fi)
     {
         Eigen::MatrixXd tJac;
         Eigen::VectorXd tRes;
@@ -871,7 +988,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Barrier(const Eigen::Ma
             int startIndex = startIndexInVectors+data.numInnerJacRows_barrier*data.numInnerJacCols_face*fi;
             data.add_Jacobian_to_svector(startIndex, wBarrierSqrt*tJac,data.SS_Jac);
         }
-    }
+    }, minParallel);
 }
 
 
@@ -884,8 +1001,11 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Closeness(const Eigen::
                                                                    const int startIndexInVectors)
 {
     if (wCloseUnconstrainedSqrt ==0 && wCloseConstrainedSqrt ==0)
+    {
+        data.residuals.segment(startRowInJacobian, data.num_residuals_close).setZero();
         return;
-    for (int fi=0; fi<data.numF; ++fi)
+    }
+    igl::parallel_for(data.numF, [&](const int fi)
     {
         Eigen::Vector4d weights;
         if (!data.is_constrained_face[fi])
@@ -913,7 +1033,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Closeness(const Eigen::
             data.add_Jacobian_to_svector(startIndex, weights.asDiagonal()*tJac,data.SS_Jac);
         }
 
-    }
+    }, minParallel);
 }
 
 
@@ -969,8 +1089,11 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Curl(const Eigen::Matri
                                                               const int startIndexInVectors)
 {
     if((wCASqrt==0) &&(wCBSqrt==0))
+    {
+        data.residuals.segment(startRowInJacobian, data.num_residuals_polycurl).setZero();
         return;
-    for (int ii=0; ii<data.numInteriorEdges; ++ii)
+    }
+    igl::parallel_for(data.numInteriorEdges, [&](const int ii)
     {
         // the two faces of the flap
         int a = data.E2F_int(ii,0);
@@ -1016,7 +1139,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Curl(const Eigen::Matri
             data.add_Jacobian_to_svector(startIndex, tJac,data.SS_Jac);
         }
 
-    }
+    }, minParallel);
 }
 
 
@@ -1068,7 +1191,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_QuotCurl(const Eigen::M
                                                                   bool doJacs,
                                                                   const int startIndexInVectors)
 {
-    for (int ii=0; ii<data.numInteriorEdges; ++ii)
+    igl::parallel_for(data.numInteriorEdges, [&](const int ii)
     {
         // the two faces of the flap
         int a = data.E2F_int(ii,0);
@@ -1107,7 +1230,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_QuotCurl(const Eigen::M
             int startIndex = startIndexInVectors+data.numInnerJacRows_quotcurl*data.numInnerJacCols_edge*ii;
             data.add_Jacobian_to_svector(startIndex, wQuotCurlSqrt*tJac,data.SS_Jac);
         }
-    }
+    }, minParallel);
 }
 
 
@@ -1131,18 +1254,49 @@ IGL_INLINE void directional::polycurl_reduction_precompute(const directional::Tr
 
 
 
-IGL_INLINE void directional::polycurl_reduction_solve(directional::PolyCurlReductionSolverData &cffsoldata,
-                                                      directional::polycurl_reduction_parameters &params,
-                                                      directional::CartesianField& currentField,
-                                                      bool fieldNotCCW)
+IGL_INLINE directional::polycurl_reduction_status directional::solve_polycurl_field(directional::PolyCurlReductionSolver &cffs,
+                                                                                     directional::polycurl_reduction_parameters &params,
+                                                                                     directional::CartesianField& currentField,
+                                                                                     bool fieldNotCCW)
 {
     Eigen::MatrixXd twoFieldMat=currentField.extField.block(0,0,currentField.extField.rows(),6);
-    directional::PolyCurlReductionSolver cffs(cffsoldata);
-    cffs.solve(params, twoFieldMat, fieldNotCCW);
+    directional::polycurl_reduction_status status;
+    cffs.solve(params, twoFieldMat, fieldNotCCW, status);
 
     Eigen::MatrixXd newExtField(currentField.extField.rows(), currentField.extField.cols());
     newExtField.block(0,0,currentField.extField.rows(),6)=twoFieldMat;
     newExtField.block(0,6,currentField.extField.rows(),6)=-twoFieldMat;
     currentField.set_extrinsic_field(newExtField);
+    return status;
+};
+
+
+
+IGL_INLINE directional::polycurl_reduction_status directional::polycurl_reduction_solve(directional::PolyCurlReductionSolverData &cffsoldata,
+                                                                                        directional::polycurl_reduction_parameters &params,
+                                                                                        directional::CartesianField& currentField,
+                                                                                        bool fieldNotCCW)
+{
+    directional::PolyCurlReductionSolver cffs(cffsoldata);
+    return solve_polycurl_field(cffs, params, currentField, fieldNotCCW);
 };
 
+
+
+IGL_INLINE void directional::polycurl_reduction_solve(const std::vector<directional::PolyCurlReductionSolverData*> &cffsoldata,
+                                                      const std::vector<const directional::polycurl_reduction_parameters*> &params,
+                                                      const std::vector<directional::CartesianField*> &currentFields,
+                                                      bool fieldNotCCW,
+                                                      std::vector<directional::polycurl_reduction_status> &statuses)
+{
+    assert(cffsoldata.size()==currentFields.size() && params.size()==currentFields.size() && "polycurl_reduction_solve(): one data and parameter set per field");
+    statuses.resize(currentFields.size());
+    igl::parallel_for(currentFields.size(), [&](const int i)
+    {
+        //the solves are the parallel work: not spawning threads within them. The parameters are copied, since
+        //the line search adapts the step size in them, and the same parameters might be given for several solves.
+        directional::PolyCurlReductionSolver cffs(*cffsoldata[i], std::numeric_limits<int>::max());
+        directional::polycurl_reduction_parameters solveParams = *params[i];
+        statuses[i] = solve_polycurl_field(cffs, solveParams, *currentFields[i], fieldNotCCW);
+    }, 1);
+};
@@ -9,6 +9,9 @@
 #ifndef DIRECTIONAL_POLYCURL_REDUCTION
 #define DIRECTIONAL_POLYCURL_REDUCTION
 
+#include <vector>
+#include <string>
+#include <functional>
 #include <Eigen/Core>
 #include <Eigen/Sparse>
 #include <igl/igl_inline.h>
@@ -23,6 +26,9 @@ namespace directional {
     // Set of parameters used during solve
     struct polycurl_reduction_parameters;
 
+    // The outcome of a solve: convergence, energies and timings
+    struct polycurl_reduction_status;
+
     // All data necessary for solving. Gets initialized from the original field
     //  and gets updated during each solve.
     class PolyCurlReductionSolverData;
@@ -63,10 +69,23 @@ namespace directional {
     //                                needs to be set to true during the first call to solve(). If unsure, set to true.
     // Returns:
     //   currentField                updated estimate for the integrable field
-    IGL_INLINE void polycurl_reduction_solve(PolyCurlReductionSolverData &cffsoldata,
-                                             polycurl_reduction_parameters &params,
-                                             directional::CartesianField& currentField,
-                                             bool fieldNotCCW);
+    //   status                       whether the solve succeeded, converged or was cancelled, with the final energies and the time of each phase.
+    //                                On failure (non-finite residuals or a failed factorization) currentField holds the last valid iterate.
+    // The solve has no global state: independent solves (each with its own data, parameters and field) can run concurrently.
+    IGL_INLINE polycurl_reduction_status polycurl_reduction_solve(PolyCurlReductionSolverData &cffsoldata,
+                                                                  polycurl_reduction_parameters &params,
+                                                                  directional::CartesianField& currentField,
+                                                                  bool fieldNotCCW);
+
+
+    // Runs a batch of independent solves concurrently, one per field, with their inner loops running serially.
+    // Inputs/Outputs are as above, per solve, except that every solve works on its own copy of its parameters, which are left unchanged
+    // (and can therefore be shared between solves). Each solve needs its own data.
+    IGL_INLINE void polycurl_reduction_solve(const std::vector<PolyCurlReductionSolverData*> &cffsoldata,
+                                             const std::vector<const polycurl_reduction_parameters*> &params,
+                                             const std::vector<directional::CartesianField*> &currentFields,
+                                             bool fieldNotCCW,
+                                             std::vector<polycurl_reduction_status> &statuses);
 
 
 };
@@ -97,11 +116,39 @@ struct directional::polycurl_reduction_parameters
     double gamma;
     //tikhonov regularization term (typically not needed, default value should suffice)
     double tikh_gamma;
+    //the wall-time budget of a single solve in seconds (0 for none). The solve stops at the first iteration that starts beyond it
+    double timeBudget;
+    //called after every iteration with its index and energy. Returning false cancels the solve
+    std::function<bool(int, double)> iterationCallback;
+    //print the progress of the iterations
+    bool verbose;
 
     IGL_INLINE polycurl_reduction_parameters();
 
 };
 
+//solve status
+struct directional::polycurl_reduction_status
+{
+    //false if the residuals became non-finite or the factorization failed
+    bool success;
+    //the line search could not reduce the energy anymore
+    bool converged;
+    //stopped by the iteration callback or the time budget
+    bool cancelled;
+    //number of Gauss-Newton iterations performed
+    int iterations;
+    //the total energy at the returned field, and its terms
+    double energy;
+    double ESmooth, EClose, EBarrier, ECurl, EQuotCurl;
+    //wall time in seconds of the residual and Jacobian evaluations, of the linear solves, and of the line searches
+    double timeResiduals, timeLinearSolve, timeLineSearch;
+    //what went wrong, if anything
+    std::string message;
+
+    IGL_INLINE polycurl_reduction_status();
+};
+
 //solver data
 class directional::PolyCurlReductionSolverData
 {
@@ -132,9 +179,11 @@ public:
 
     //Solver Data
     Eigen::VectorXd residuals;
-    Eigen::SparseMatrix<double> Jac;
+    //the Jacobian is only kept as its (fixed) pattern II_Jac/JJ_Jac and values SS_Jac: J^T*J and J^T*r are assembled from them directly
     Eigen::VectorXi II_Jac, JJ_Jac;
     Eigen::VectorXd SS_Jac;
+    //the Jacobian elements of each column (variable), in ascending order
+    std::vector<int> jacColStart, jacColElements;
     int numVariables;
     int num_residuals;
     int num_residuals_smooth;
@@ -188,18 +237,22 @@ public:
                                           const int &numInnerCols,
                                           Eigen::VectorXi &rows,
                                           Eigen::VectorXi &columns);
+    //the pairs of Jacobian elements whose products sum to each nonzero of Hess (in the order of its value array)
+    std::vector<int> hessPairStart;
     std::vector<int> indInSS_Hess_1_vec;
     std::vector<int> indInSS_Hess_2_vec;
     Eigen::SparseMatrix<double> Hess;
-    std::vector<Eigen::Triplet<double> > Hess_triplets;
     Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > solver;
+    //the minimal size of the inner loops to run in parallel (see igl::parallel_for())
+    int minParallel;
 
     IGL_INLINE void precomputeMesh(const Eigen::MatrixXd &_V,
                                    const Eigen::MatrixXi &_F);
     IGL_INLINE void computeInteriorEdges();
     IGL_INLINE void computeJacobianPattern();
     IGL_INLINE void computeHessianPattern();
-    IGL_INLINE void computeNewHessValues();
+    IGL_INLINE void computeNewHessValues(const int loopMinParallel);
+    IGL_INLINE void computeJtR(Eigen::VectorXd &JtR, const int loopMinParallel) const;
     IGL_INLINE void initializeOriginalVariable(const Eigen::MatrixXd& originalField);
     IGL_INLINE void initializeConstraints(const Eigen::VectorXi& b,
                                           const Eigen::MatrixXd& bc,
@@ -15,10 +15,12 @@
 #include <unsupported/Eigen/Polynomials>
 #include <igl/speye.h>
 #include <igl/eigs.h>
+#include <igl/parallel_for.h>
 #include <iostream>
 #include <directional/complex_eigs.h>
 #include <directional/TangentBundle.h>
 #include <directional/CartesianField.h>
+#include <directional/ProfileReport.h>
 
 namespace directional
 {
@@ -50,15 +52,199 @@ namespace directional
         Eigen::SparseMatrix<std::complex<double>> WSmooth, WAlign, WRoSy, M;
         double totalRoSyWeight, totalConstrainedWeight, totalSmoothWeight;    //for co-scaling energies
 
-        PolyVectorData():signSymmetry(true),  wSmooth(1.0), wRoSy(0.0) {wAlignment.resize(0); constSpaces.resize(0); constVectors.resize(0,3);}
+        //The constraint layout that the sparsity patterns of reducMat, alignMat and WAlign were built from, so that they are only reused for the same layout
+        Eigen::VectorXi patternConstSpaces;     //constSpaces at the time of building
+        Eigen::VectorXi patternIsHard;          //whether each constraint was hard (wAlignment<0) at the time of building
+        int patternSizeT, patternRealN, patternJump;
+
+        PolyVectorData():signSymmetry(true),  wSmooth(1.0), wRoSy(0.0), patternSizeT(-1), patternRealN(-1), patternJump(-1) {wAlignment.resize(0); constSpaces.resize(0); constVectors.resize(0,3);}
         ~PolyVectorData(){}
     };
 
 
+    // Builds the constraint operators of pvData (reducMat, reducRhs, alignMat, alignRhs, WAlign) from constSpaces, constVectors and wAlignment.
+    // Each constraint c (the value of the constrained vector in the reduced PolyVector variable) cuts a root (z-c) from the local polynomial:
+    // a hard constraint multiplies the local reduction by the bidiagonal matrix A with -c on the diagonal and 1 below it, and a soft constraint
+    // penalizes the projection I-A*A^+ onto the complement of range(A). The latter is spanned by v with v_j=conj(c)^j, and is therefore
+    // computed in closed form as v*v^H/|v|^2. The matrices are written directly into their compressed sparse storage in parallel.
+    // If reuseStructure is set and the constraint layout (the constrained spaces, which of them are hard, and the degree and symmetry) did not change
+    // since the patterns were built, only the values are rewritten into the existing patterns.
+    IGL_INLINE void polyvector_constraint_operators(const directional::TangentBundle& tb,
+                                                    PolyVectorData& pvData,
+                                                    const bool reuseStructure=false)
+    {
+        using namespace std;
+        using namespace Eigen;
+        int sizeT = pvData.sizeT;
+        int numConstraints = pvData.constSpaces.size();
+        int realN = (pvData.signSymmetry ? pvData.N/2 : pvData.N);
+        realN = (pvData.wRoSy < 0.0 ? 1 : realN);
+        int jump = (pvData.signSymmetry ? 2 : 1);
+        jump = (pvData.wRoSy < 0.0 ? pvData.N : jump);
+
+        MatrixXd constVectorsIntrinsic=tb.project_to_intrinsic(pvData.constSpaces,pvData.constVectors);
+        VectorXcd constValues(numConstraints);
+        igl::parallel_for(numConstraints, [&](const int i){
+            complex<double> constVectorComplexRaw = complex<double>(constVectorsIntrinsic(i,0),constVectorsIntrinsic(i,1));
+            complex<double> constVectorComplex = (pvData.signSymmetry ? constVectorComplexRaw*constVectorComplexRaw : constVectorComplexRaw);
+            constValues(i) = (pvData.wRoSy < 0.0 ? pow(constVectorComplexRaw, pvData.N) : constVectorComplex);
+        }, 1000);
+
+        //grouping the constraints by space, in their original order. Hard constraints beyond realN on a space overconstrain it and are ignored.
+        VectorXi numHard = VectorXi::Zero(sizeT), numSoft = VectorXi::Zero(sizeT);
+        VectorXi isUsed = VectorXi::Zero(numConstraints), softRank(numConstraints), softRow(numConstraints);
+        int numSoftTotal=0;
+        for (int i=0;i<numConstraints;i++){
+            int space = pvData.constSpaces(i);
+            if (pvData.wAlignment(i)<0.0){
+                if (numHard(space)==realN)
+                    continue;
+                numHard(space)++;
+            } else {
+                softRank(i) = numSoft(space)++;
+                softRow(i) = realN*(numSoftTotal++);
+            }
+            isUsed(i)=1;
+        }
+
+        VectorXi hardStart(sizeT+1), hardList(numHard.sum());
+        hardStart(0)=0;
+        for (int i=0;i<sizeT;i++)
+            hardStart(i+1)=hardStart(i)+numHard(i);
+        VectorXi hardCursor=hardStart.head(sizeT);
+        for (int i=0;i<numConstraints;i++)
+            if ((isUsed(i))&&(pvData.wAlignment(i)<0.0))
+                hardList(hardCursor(pvData.constSpaces(i))++)=i;
+
+        //the patterns can only be reused if they were built from the same constraint layout
+        VectorXi isHard = (pvData.wAlignment.array()<0.0).cast<int>();
+        bool sameLayout = reuseStructure && (pvData.patternSizeT==sizeT) && (pvData.patternRealN==realN) && (pvData.patternJump==jump)
+                          && (pvData.patternConstSpaces.size()==numConstraints) && (pvData.patternConstSpaces==pvData.constSpaces) && (pvData.patternIsHard==isHard);
+
+        /*************Hard-constraint reduction matrices******************/
+        //column and nonzero offsets of each space in reducMat: unconstrained spaces are an identity, and constrained ones a dense block
+        VectorXi colStart(sizeT+1), nnzStart(sizeT+1);
+        colStart(0)=0; nnzStart(0)=0;
+        for (int i=0;i<sizeT;i++){
+            colStart(i+1)=colStart(i)+realN-numHard(i);
+            nnzStart(i+1)=nnzStart(i)+(numHard(i)==0 ? realN : realN*(realN-numHard(i)));
+        }
+
+        bool reuseReduc = sameLayout && pvData.reducMat.isCompressed() && (pvData.reducMat.cols()==colStart(sizeT)) && (pvData.reducMat.nonZeros()==nnzStart(sizeT));
+        if (!reuseReduc){
+            pvData.reducMat.resize(pvData.N*sizeT, colStart(sizeT));
+            pvData.reducMat.resizeNonZeros(nnzStart(sizeT));
+            pvData.reducMat.outerIndexPtr()[colStart(sizeT)]=nnzStart(sizeT);
+        }
+        pvData.reducRhs=VectorXcd::Zero(pvData.N*sizeT);
+        int* reducOuter = pvData.reducMat.outerIndexPtr();
+        int* reducInner = pvData.reducMat.innerIndexPtr();
+        complex<double>* reducValues = pvData.reducMat.valuePtr();
+        igl::parallel_for(sizeT, [&](const int i){
+            MatrixXcd localReducMat = MatrixXcd::Identity(realN,realN);
+            VectorXcd localReducRhs = VectorXcd::Zero(realN);
+            for (int h=hardStart(i);h<hardStart(i+1);h++){
+                //multiplying by the single reduction matrix of the constraint, which removes one degree of freedom
+                int currNumDof = realN-(h-hardStart(i));
+                complex<double> c = constValues(hardList(h));
+                localReducRhs -= c*localReducMat.col(currNumDof-1);
+                MatrixXcd nextReducMat(realN, currNumDof-1);
+                for (int j=0;j<currNumDof-1;j++)
+                    nextReducMat.col(j) = localReducMat.col(j+1) - c*localReducMat.col(j);
+                localReducMat = nextReducMat;
+            }
+
+            int localNnz = (numHard(i)==0 ? 1 : realN);
+            for (int k=0;k<localReducMat.cols();k++){
+                int currNnz = nnzStart(i)+k*localNnz;
+                if (!reuseReduc)
+                    reducOuter[colStart(i)+k] = currNnz;
+                for (int l=0;l<realN;l++){
+                    if ((numHard(i)==0)&&(l!=k))
+                        continue;
+                    if (!reuseReduc)
+                        reducInner[currNnz] = l*jump*sizeT+i;
+                    reducValues[currNnz++] = localReducMat(l,k);
+                }
+            }
+
+            for (int l=0;l<realN;l++)
+                pvData.reducRhs(l*jump*sizeT+i) = localReducRhs(l);
+        }, 1000);
+
+        /*****************Soft alignment matrices*******************/
+        //alignMat has realN rows for each soft constraint, and column k*jump*sizeT+space holds the k-th column of the projection of every soft constraint on that space
+        pvData.totalConstrainedWeight=0.0;
+        for (int i=0;i<numConstraints;i++)
+            if (pvData.wAlignment(i)>=0.0)
+                pvData.totalConstrainedWeight+=realN*tb.tangentSpaceMass(pvData.constSpaces(i));
+        if (numSoftTotal==0)
+            pvData.totalConstrainedWeight=1.0;  //it wouldn't be used, except just to avoid a division by zero in the energy formulation
+
+        int alignRows = realN*numSoftTotal;
+        bool reuseAlign = sameLayout && pvData.alignMat.isCompressed() && (pvData.alignMat.rows()==alignRows) && (pvData.alignMat.cols()==pvData.N*sizeT) && (pvData.alignMat.nonZeros()==realN*alignRows)
+                          && pvData.WAlign.isCompressed() && (pvData.WAlign.rows()==alignRows) && (pvData.WAlign.nonZeros()==alignRows);
+        if (!reuseAlign){
+            pvData.alignMat.resize(alignRows, pvData.N*sizeT);
+            pvData.alignMat.resizeNonZeros(realN*alignRows);
+            int* alignOuter = pvData.alignMat.outerIndexPtr();
+            alignOuter[0]=0;
+            for (int col=0;col<pvData.N*sizeT;col++)
+                alignOuter[col+1] = alignOuter[col] + ((col/sizeT)%jump==0 ? realN*numSoft(col%sizeT) : 0);
+
+            pvData.WAlign.resize(alignRows, alignRows);
+            pvData.WAlign.resizeNonZeros(alignRows);
+            for (int i=0;i<=alignRows;i++)
+                pvData.WAlign.outerIndexPtr()[i]=i;
+        }
+        pvData.alignRhs.resize(alignRows);
+        const int* alignOuter = pvData.alignMat.outerIndexPtr();
+        int* alignInner = pvData.alignMat.innerIndexPtr();
+        complex<double>* alignValues = pvData.alignMat.valuePtr();
+        int* WAlignInner = pvData.WAlign.innerIndexPtr();
+        complex<double>* WAlignValues = pvData.WAlign.valuePtr();
+        igl::parallel_for(numConstraints, [&](const int i){
+            if (pvData.wAlignment(i)<0.0)
+                return;  //here we only handle soft alignments
+
+            complex<double> c = constValues(i);
+            VectorXcd v(realN);
+            v(0)=1.0;
+            for (int j=1;j<realN;j++)
+                v(j)=v(j-1)*conj(c);
+            double vNormSquared = v.squaredNorm();
+            complex<double> cPowN = conj(v(realN-1))*c;
+            int space = pvData.constSpaces(i);
+            for (int k=0;k<realN;k++){
+                int currNnz = alignOuter[k*jump*sizeT+space] + softRank(i)*realN;
+                for (int j=0;j<realN;j++){
+                    if (!reuseAlign)
+                        alignInner[currNnz+j] = softRow(i)+j;
+                    alignValues[currNnz+j] = v(j)*conj(v(k))/vNormSquared;
+                }
+            }
+
+            for (int j=0;j<realN;j++){
+                pvData.alignRhs(softRow(i)+j) = -v(j)*cPowN/vNormSquared;
+                if (!reuseAlign)
+                    WAlignInner[softRow(i)+j] = softRow(i)+j;
+                WAlignValues[softRow(i)+j] = pvData.wAlignment(i)*tb.tangentSpaceMass(space);
+            }
+        }, 1000);
+
+        pvData.patternConstSpaces = pvData.constSpaces;
+        pvData.patternIsHard = isHard;
+        pvData.patternSizeT = sizeT;
+        pvData.patternRealN = realN;
+        pvData.patternJump = jump;
+    }
+
+
     // Precalculate the operators needed for PolyVector computation according to the user-prescribed parameters. Must be called whenever any of them changes
     // Input:
     //  tb:     underlying tangent bundle
     //  N:      degree of the field
+    //  report: optional profiling report
     //
     // Output:
     //  pvField: POLYVECTOR_FIELD cartesian field initalized with the tangent bundle
@@ -66,11 +252,15 @@ namespace directional
     IGL_INLINE void polyvector_precompute(const directional::TangentBundle& tb,
                                           const int N,
                                           directional::CartesianField& pvField,
-                                          PolyVectorData& pvData)
+                                          PolyVectorData& pvData,
+                                          directional::ProfileReport* report=NULL)
     {
 
         using namespace std;
         using namespace Eigen;
+        directional::ScopedTimer timer(report, "polyvector_precompute");
+        if (report)
+            report->add_counter("polyvector.constraints", pvData.constSpaces.size());
 
         pvField.init(tb, fieldTypeEnum::POLYVECTOR_FIELD, N);
 
@@ -113,71 +303,6 @@ namespace directional
         pvData.M.resize(pvData.N*pvField.intField.rows(), pvData.N*pvField.intField.rows());
         pvData.M.setFromTriplets(MTriplets.begin(), MTriplets.end());
 
-        //creating reduction transformation
-        VectorXi numSpaceConstraints = Eigen::VectorXi::Zero(pvField.intField.rows());
-        int realN = (pvData.signSymmetry ? N/2 : N);
-        realN = (pvData.wRoSy < 0.0 ? 1 : realN);
-        //MatrixXcd faceConstraints(F.rows(),realN);
-        std::vector<MatrixXcd> localSpaceReducMats; localSpaceReducMats.resize(pvField.intField.rows());
-        std::vector<VectorXcd> localSpaceReducRhs;  localSpaceReducRhs.resize(pvField.intField.rows());
-
-        for (int i=0;i<pvField.intField.rows();i++){
-            localSpaceReducMats[i]=MatrixXcd::Identity(realN,realN);
-            localSpaceReducRhs[i]=VectorXcd::Zero(realN);
-        }
-
-        /*************Hard-constraint reduction matrices******************/
-        MatrixXd constVectorsIntrinsic=pvField.tb->project_to_intrinsic(pvData.constSpaces,pvData.constVectors);
-        //cout<<"constVectorsIntrinsic: "<<constVectorsIntrinsic<<endl;
-        for (int i=0;i<pvData.constSpaces.size();i++){
-            if (pvData.wAlignment(i)>=0.0)
-                continue;  //here we only handle the reduction caused by a fixed dof
-            if (numSpaceConstraints(pvData.constSpaces(i))==realN)
-                continue; //overconstrained; we ignore any further constraints on that face
-
-            int currSpaceNumDof = numSpaceConstraints(pvData.constSpaces(i));
-
-            complex<double> constVectorComplexRaw = complex<double>(constVectorsIntrinsic(i,0),constVectorsIntrinsic(i,1));
-            complex<double> constVectorComplex = (pvData.signSymmetry ? constVectorComplexRaw*constVectorComplexRaw : constVectorComplexRaw);
-            constVectorComplex = (pvData.wRoSy < 0.0 ? pow(constVectorComplexRaw, N) :constVectorComplex);
-
-            MatrixXcd singleReducMat=MatrixXcd::Zero(realN-currSpaceNumDof,realN-currSpaceNumDof-1);
-            VectorXcd singleReducRhs=VectorXcd::Zero(realN-currSpaceNumDof);
-            for (int j=0;j<realN-currSpaceNumDof-1;j++){
-                singleReducMat(j,j)=-constVectorComplex;
-                singleReducMat(j+1,j)=complex<double>(1.0,0.0);
-            }
-            singleReducRhs(realN-currSpaceNumDof-1) = -constVectorComplex;
-
-            localSpaceReducRhs[pvData.constSpaces(i)] = localSpaceReducMats[pvData.constSpaces(i)]*singleReducRhs + localSpaceReducRhs[pvData.constSpaces(i)];
-            localSpaceReducMats[pvData.constSpaces(i)] = localSpaceReducMats[pvData.constSpaces(i)]*singleReducMat;
-
-            numSpaceConstraints(pvData.constSpaces(i))++;
-
-            //faceConstraints(pvData.constSpaces(i), numSpaceConstraints(pvData.constSpaces(i))++) = constVectorComplex;
-        }
-
-        //creating the global reduction matrices
-        double colCounter=0;
-        pvData.reducRhs=VectorXcd::Zero(pvData.N*pvField.intField.rows());
-        vector<Triplet<complex<double>>> reducMatTriplets;
-        int jump = (pvData.signSymmetry ? 2 : 1);
-        jump = (pvData.wRoSy < 0.0 ? pvData.N : jump);
-        for (int i=0;i<pvField.intField.rows();i++){
-            for (int j=0;j<pvData.N;j+=jump){
-                for (int k=0;k<localSpaceReducMats[i].cols();k++)
-                    reducMatTriplets.push_back(Triplet<complex<double>>(j*pvField.intField.rows()+i, colCounter+k, localSpaceReducMats[i](j/jump,k)));
-
-                pvData.reducRhs(j*pvField.intField.rows()+i) = localSpaceReducRhs[i](j/jump);
-            }
-
-            colCounter+=localSpaceReducMats[i].cols();
-        }
-
-        pvData.reducMat.resize(pvData.N*pvField.intField.rows(), colCounter);
-        pvData.reducMat.setFromTriplets(reducMatTriplets.begin(), reducMatTriplets.end());
-
-
         /****************rotational-symmetry matrices********************/
         //TODO: use new massweights
         if (pvData.wRoSy >= 0.0){ //this is anyhow enforced, this matrix is unnecessary)
@@ -200,78 +325,41 @@ namespace directional
             pvData.totalRoSyWeight=1.0;
         }
 
-        /*****************Soft alignment matrices*******************/
-        rowCounter=0;
-        vector<Triplet<complex<double>>> alignTriplets;
-        vector<VectorXcd> alignRhsList;
-        vector<Triplet<complex<double>>> WAlignTriplets;
-        pvData.totalConstrainedWeight=0.0;
-        bool noSoftAlignment = true;
-        for (int i=0;i<pvData.constSpaces.size();i++){
-            if (pvData.wAlignment(i)<0.0)
-                continue;  //here we only handle soft alignments
-
-            noSoftAlignment=false;
-
-            //complex<double> constVectorComplexSingle=std::complex<double>(pvData.constVectors.row(i).dot(mesh.Bx.row(pvData.constSpaces(i))), pvData.constVectors.row(i).dot(mesh.By.row(pvData.constSpaces(i))));
-            complex<double> constVectorComplexRaw = complex<double>(constVectorsIntrinsic(i,0),constVectorsIntrinsic(i,1));
-            complex<double> constVectorComplex = (pvData.signSymmetry ? constVectorComplexRaw*constVectorComplexRaw : constVectorComplexRaw);
-            constVectorComplex = (pvData.wRoSy < 0.0 ? pow(constVectorComplexRaw, N) : constVectorComplex);
-            numSpaceConstraints(pvData.constSpaces(i))++;
-            //faceConstraints(pvData.constSpaces(i), numSpaceConstraints(pvData.constSpaces(i))++) = constVectorComplex;
-
-            MatrixXcd singleReducMat=MatrixXcd::Zero(realN,realN-1);
-            VectorXcd singleReducRhs=VectorXcd::Zero(realN);
-            for (int j=0;j<realN-1;j++){
-                singleReducMat(j,j)=-constVectorComplex;
-                singleReducMat(j+1,j)=complex<double>(1.0,0.0);
-            }
-            singleReducRhs(realN-1) = -constVectorComplex;
-
-            MatrixXcd IAiA;
-            if (realN>1){
-                MatrixXcd invSingleReducMat = singleReducMat.completeOrthogonalDecomposition().pseudoInverse();
-                IAiA = MatrixXcd::Identity(realN,realN) - singleReducMat*invSingleReducMat;
-            } else IAiA = MatrixXcd::Ones(realN,realN);
-            singleReducRhs = IAiA*singleReducRhs;
-            for (int j=0;j<IAiA.rows();j++)
-                for (int k=0;k<IAiA.cols();k++)
-                    alignTriplets.push_back(Triplet<complex<double>>(rowCounter+j, k*jump*pvField.intField.rows()+pvData.constSpaces(i), IAiA(j,k)));
-
-            alignRhsList.push_back(singleReducRhs);
-            for (int j=0;j<singleReducRhs.size();j++){
-                WAlignTriplets.push_back(Triplet<complex<double>>(rowCounter+j, rowCounter+j, pvData.wAlignment(i)*pvField.tb->tangentSpaceMass(pvData.constSpaces(i))));
-                pvData.totalConstrainedWeight+=pvField.tb->tangentSpaceMass(pvData.constSpaces(i));
-            }
-            rowCounter+=realN;
-        }
-
-        if (noSoftAlignment)
-            pvData.totalConstrainedWeight=1.0;  //it wouldn't be used, except just to avoid a division by zero in the energy formulation
-
-        pvData.alignRhs.resize(rowCounter);
-        for (int i=0;i<alignRhsList.size();i++)
-            pvData.alignRhs.segment(i*realN,realN)=alignRhsList[i];
+        polyvector_constraint_operators(tb, pvData);
+    }
 
-        pvData.alignMat.resize(rowCounter, N*pvField.intField.rows());
-        pvData.alignMat.setFromTriplets(alignTriplets.begin(), alignTriplets.end());
 
-        pvData.WAlign.resize(rowCounter,rowCounter);
-        pvData.WAlign.setFromTriplets(WAlignTriplets.begin(), WAlignTriplets.end());
+    // Updates the constraint operators of pvData after the constraints changed, with the same N and symmetry parameters.
+    // The smoothness, rotational-symmetry and mass operators are kept. If the constraint layout is the same as when the patterns were built
+    // (e.g., only pvData.constVectors or the soft weights changed), the new values are written into the existing sparsity patterns; otherwise they are rebuilt.
+    // Input:
+    //  tb:     underlying tangent bundle
+    //  report: optional profiling report
+    // Output:
+    //  pvData: structure initialized with polyvector_precompute(), with updated constraint operators.
+    IGL_INLINE void polyvector_update_constraints(const directional::TangentBundle& tb,
+                                                  PolyVectorData& pvData,
+                                                  directional::ProfileReport* report=NULL)
+    {
+        directional::ScopedTimer timer(report, "polyvector_update_constraints");
+        polyvector_constraint_operators(tb, pvData, true);
     }
 
 
     // Computes a polyvector field on the entire mesh, where precomputation has taken place.
     // Inputs:
     //  PolyVectorData: The data structure which should have been initialized with polyvector_precompute()
+    //  report:         optional profiling report
     // Outputs:
     //  pvField: a POLYVECTOR_FIELD type cartesian field object
 
     IGL_INLINE void polyvector_field(const PolyVectorData& pvData,
-                                     directional::CartesianField& pvField)
+                                     directional::CartesianField& pvField,
+                                     directional::ProfileReport* report=NULL)
     {
         using namespace std;
         using namespace Eigen;
+        directional::ScopedTimer timer(report, "polyvector_field");
 
         //forming total energy matrix;
         SparseMatrix<complex<double>> totalUnreducedLhs =(pvData.smoothMat.adjoint()*pvData.WSmooth*pvData.smoothMat) * (pvData.wSmooth / pvData.totalSmoothWeight);
@@ -307,7 +395,10 @@ namespace directional
             //Extracting first eigenvector
             Eigen::MatrixXcd U;
             Eigen::VectorXcd S;
-            complex_eigs(X0Lhs, X0M, 10, U, S);
+            {
+                directional::ScopedTimer eigsTimer(report, "polyvector_field.eigensolve");
+                complex_eigs(X0Lhs, X0M, 10, U, S);
+            }
             int smallestIndex; S.cwiseAbs().minCoeff(&smallestIndex);
 
             pvField.fieldType = fieldTypeEnum::POLYVECTOR_FIELD;
@@ -317,8 +408,14 @@ namespace directional
         } else { //just solving the system
             SimplicialLDLT<SparseMatrix<complex<double>>> solver;
             //solver.analyzePattern(totalLhs);   // for this step the numerical values of A are not used
-            solver.compute(totalLhs);
-            VectorXcd reducedDofs = solver.solve(totalRhs);
+            VectorXcd reducedDofs;
+            {
+                directional::ScopedTimer solveTimer(report, "polyvector_field.solve");
+                solver.compute(totalLhs);
+                reducedDofs = solver.solve(totalRhs);
+            }
+            if (report)
+                report->add_counter("polyvector.factorizations");
             assert(solver.info() == Success);
             VectorXcd fullDofs = pvData.reducMat*reducedDofs+pvData.reducRhs;
             MatrixXcd intField(pvData.sizeT, pvData.N);
@@ -342,7 +439,8 @@ namespace directional
                                      const double roSyWeight,
                                      const Eigen::VectorXd& alignWeights,
                                      const int N,
-                                     directional::CartesianField& pvField)
+                                     directional::CartesianField& pvField,
+                                     directional::ProfileReport* report=NULL)
     {
         PolyVectorData pvData;
         if (constSpaces.size()!=0) {
@@ -358,8 +456,8 @@ namespace directional
         pvData.wSmooth = smoothWeight;
         pvData.wRoSy = roSyWeight;
         pvField.init(tb,fieldTypeEnum::POLYVECTOR_FIELD,N);
-        polyvector_precompute(tb,N,pvField,pvData);
-        polyvector_field(pvData, pvField);
+        polyvector_precompute(tb,N,pvField,pvData,report);
+        polyvector_field(pvData, pvField, report);
     }
 
 
@@ -368,7 +466,8 @@ namespace directional
                                      const Eigen::VectorXi& constSpaces,
                                      const Eigen::MatrixXd& constVectors,
                                      const int N,
-                                     directional::CartesianField& pvField)
+                                     directional::CartesianField& pvField,
+                                     directional::ProfileReport* report=NULL)
     {
 
         PolyVectorData pvData;
@@ -385,8 +484,8 @@ namespace directional
         pvData.wAlignment = Eigen::VectorXd::Constant(constSpaces.size(),-1.0);
         pvData.wSmooth = 1.0;
         pvData.wRoSy = 0.0;
-        polyvector_precompute(tb, N, pvField,pvData);
-        polyvector_field(pvData, pvField);
+        polyvector_precompute(tb, N, pvField,pvData,report);
+        polyvector_field(pvData, pvField, report);
     }
 
 }
@@ -190,6 +190,21 @@ namespace directional {
         return true;
     }
 
+
+    // The same, with the roots (computed in double) stored in a float-storage field
+    IGL_INLINE bool polyvector_to_raw(const directional::CartesianField &pvField,
+                                      directional::FloatCartesianField &rawField,
+                                      bool signSymmetry = true,
+                                      const double rootTolerance = 1e-8) {
+
+        rawField.init(*(pvField.tb), fieldTypeEnum::RAW_FIELD, pvField.N);
+        Eigen::MatrixXcd intField;
+        if (pvField.N % 2 != 0) signSymmetry = false;  //by definition
+        bool success = polyvector_to_raw(pvField.intField, pvField.N, intField, signSymmetry, rootTolerance);
+        rawField.set_intrinsic_field(intField);
+        return success;
+    }
+
 }
 
 #endif
@@ -9,23 +9,241 @@
 #define DIRECTIONAL_POWER_FIELD_H
 
 #include <iostream>
+#include <vector>
+#include <complex>
 #include <Eigen/Geometry>
 #include <Eigen/Sparse>
-#include <directional/polyvector_field.h>
+#include <Eigen/SparseCholesky>
+#include <directional/complex_eigs.h>
+#include <directional/ProfileReport.h>
 #include <directional/TangentBundle.h>
 #include <directional/CartesianField.h>
 
 
 namespace directional
 {
+    //Data for the power-field solver. A power field is a perfectly rotationally-symmetric PolyVector, which has a single
+    //complex unknown u^N per tangent space, so the system only has #spaces unknowns (instead of N*#spaces for a general PolyVector).
+    struct PowerFieldData{
+    public:
+
+        //User parameters
+        Eigen::VectorXi constSpaces;    // List of tangent spaces where there are constraints. If a space is repeated with hard constraints all but the first are ignored.
+        Eigen::MatrixXd constVectors;   // Corresponding to constSpaces. Can be changed between solves without a new precomputation.
+        Eigen::VectorXd wAlignment;     // Weight of alignment per each of the constSpaces. "-1" means a fixed vector
+
+        int N;                          // Degree of field
+        int sizeT;                      // #tangent spaces
+        double wSmooth;                 // Weight of smoothness
+
+        Eigen::SparseMatrix<std::complex<double>> smoothLhs;   //The (scaled) connection Laplacian of the single power coefficient
+        Eigen::VectorXd alignLhs;                               //The (scaled) diagonal of the soft alignment energy
+        Eigen::VectorXi fixedSpaces;                            //The spaces with hard constraints, with their index into constSpaces
+        Eigen::VectorXi fixedConstraints;
+        Eigen::VectorXi full2Free;                              //Index of each space among the free unknowns (-1 for fixed ones)
+        Eigen::SparseMatrix<std::complex<double>> freeLhs;      //The reduced system on the free unknowns
+        Eigen::SparseMatrix<std::complex<double>> freeFixedLhs; //The coupling of the free to the fixed unknowns
+        double totalSmoothWeight, totalConstrainedWeight;       //for co-scaling energies
+
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<std::complex<double>>> solver;
+        bool isFactored;
+
+        PowerFieldData():N(1), sizeT(0), wSmooth(1.0), isFactored(false) {wAlignment.resize(0); constSpaces.resize(0); constVectors.resize(0,3);}
+        ~PowerFieldData(){}
+    };
+
+
+    // Precomputes and factors the power-field system for the given constraint spaces, weights, and degree. Must be called whenever
+    // any of them (except the constraint vectors) changes.
+    // Input:
+    //  tb:     underlying tangent bundle
+    //  N:      degree of the field
+    //  report: optional profiling report
+    // Output:
+    //  powerData: Updated structure with the factored system
+    IGL_INLINE void power_field_precompute(const directional::TangentBundle& tb,
+                                           const int N,
+                                           PowerFieldData& powerData,
+                                           directional::ProfileReport* report=NULL)
+    {
+        using namespace std;
+        using namespace Eigen;
+        directional::ScopedTimer timer(report, "power_field_precompute");
+
+        powerData.N = N;
+        powerData.sizeT = tb.sources.rows();
+        powerData.totalSmoothWeight = tb.connectionMass.sum();
+
+        //the connection Laplacian of u^N: sum_e m_e|c_e^N*x_a - x_b|^2
+        vector<Triplet<complex<double>>> smoothTriplets;
+        for (int i=0;i<tb.adjSpaces.rows();i++){
+            if ((tb.adjSpaces(i,0)==-1)||(tb.adjSpaces(i,1)==-1))
+                continue;  //boundary edge
+            const int a = tb.adjSpaces(i,0), b = tb.adjSpaces(i,1);
+            const complex<double> c = pow(tb.connection(i),N);
+            const double m = tb.connectionMass(i)*powerData.wSmooth/powerData.totalSmoothWeight;
+            smoothTriplets.push_back(Triplet<complex<double>>(a, a, m*std::norm(c)));
+            smoothTriplets.push_back(Triplet<complex<double>>(b, b, m));
+            smoothTriplets.push_back(Triplet<complex<double>>(a, b, -m*std::conj(c)));
+            smoothTriplets.push_back(Triplet<complex<double>>(b, a, -m*c));
+        }
+        powerData.smoothLhs.resize(powerData.sizeT, powerData.sizeT);
+        powerData.smoothLhs.setFromTriplets(smoothTriplets.begin(), smoothTriplets.end());
+
+        //hard constraints (first one per space) and the soft alignment diagonal
+        VectorXi isFixed = VectorXi::Zero(powerData.sizeT);
+        vector<int> fixedSpaces, fixedConstraints;
+        powerData.alignLhs = VectorXd::Zero(powerData.sizeT);
+        powerData.totalConstrainedWeight = 0.0;
+        for (int i=0;i<powerData.constSpaces.size();i++){
+            if (powerData.wAlignment(i)<0.0){
+                if (isFixed(powerData.constSpaces(i)))
+                    continue;  //overconstrained; we ignore any further constraints on that space
+                isFixed(powerData.constSpaces(i)) = 1;
+                fixedSpaces.push_back(powerData.constSpaces(i));
+                fixedConstraints.push_back(i);
+            } else {
+                powerData.alignLhs(powerData.constSpaces(i)) += powerData.wAlignment(i)*tb.tangentSpaceMass(powerData.constSpaces(i));
+                powerData.totalConstrainedWeight += tb.tangentSpaceMass(powerData.constSpaces(i));
+            }
+        }
+        if (powerData.totalConstrainedWeight==0.0)
+            powerData.totalConstrainedWeight=1.0;  //it wouldn't be used, except just to avoid a division by zero in the energy formulation
+        powerData.alignLhs /= powerData.totalConstrainedWeight;
+        powerData.fixedSpaces = Map<VectorXi>(fixedSpaces.data(), fixedSpaces.size());
+        powerData.fixedConstraints = Map<VectorXi>(fixedConstraints.data(), fixedConstraints.size());
+
+        //eliminating the fixed unknowns
+        powerData.full2Free = VectorXi::Constant(powerData.sizeT, -1);
+        VectorXi full2Fixed = VectorXi::Constant(powerData.sizeT, -1);
+        int numFree = 0;
+        for (int i=0;i<powerData.sizeT;i++)
+            if (!isFixed(i))
+                powerData.full2Free(i) = numFree++;
+        for (int i=0;i<powerData.fixedSpaces.size();i++)
+            full2Fixed(powerData.fixedSpaces(i)) = i;
+
+        vector<Triplet<complex<double>>> freeTriplets, freeFixedTriplets;
+        for (int i=0;i<powerData.sizeT;i++)
+            if (powerData.full2Free(i)>=0)
+                freeTriplets.push_back(Triplet<complex<double>>(powerData.full2Free(i), powerData.full2Free(i), powerData.alignLhs(i)));
+        for (int k=0;k<powerData.smoothLhs.outerSize();k++)
+            for (SparseMatrix<complex<double>>::InnerIterator it(powerData.smoothLhs,k);it;++it){
+                if (powerData.full2Free(it.row())<0)
+                    continue;
+                if (powerData.full2Free(it.col())>=0)
+                    freeTriplets.push_back(Triplet<complex<double>>(powerData.full2Free(it.row()), powerData.full2Free(it.col()), it.value()));
+                else
+                    freeFixedTriplets.push_back(Triplet<complex<double>>(powerData.full2Free(it.row()), full2Fixed(it.col()), it.value()));
+            }
+        powerData.freeLhs.resize(numFree, numFree);
+        powerData.freeLhs.setFromTriplets(freeTriplets.begin(), freeTriplets.end());
+        powerData.freeFixedLhs.resize(numFree, powerData.fixedSpaces.size());
+        powerData.freeFixedLhs.setFromTriplets(freeFixedTriplets.begin(), freeFixedTriplets.end());
+
+        powerData.isFactored = false;
+        if ((numFree==0)||(powerData.constSpaces.size()==0))
+            return;  //nothing to solve, or an eigenvalue problem
+
+        {
+            directional::ScopedTimer factorTimer(report, "power_field_precompute.factorize");
+            powerData.solver.compute(powerData.freeLhs);
+        }
+        if (report)
+            report->add_counter("power_field.factorizations");
+        powerData.isFactored = (powerData.solver.info() == Success);
+        assert(powerData.isFactored && "power_field_precompute(): factorization failed");
+    }
+
+
+    // Computes a power field on the entire mesh, where precomputation has taken place. Solving again with different constVectors
+    // (but the same constSpaces and weights) reuses the factorization. If no constraints are given the lowest-eigenvalue
+    // (of smoothness energy) field will be returned.
+    // Inputs:
+    //  tb:         underlying tangent bundle (the same one of the precomputation).
+    //  powerData:  The data structure which should have been initialized with power_field_precompute()
+    //  report:     optional profiling report
+    // Outputs:
+    //  field:  a POWER_FIELD type cartesian field object
+    IGL_INLINE void power_field(const directional::TangentBundle& tb,
+                                const PowerFieldData& powerData,
+                                directional::CartesianField& field,
+                                directional::ProfileReport* report=NULL)
+    {
+        using namespace std;
+        using namespace Eigen;
+        directional::ScopedTimer timer(report, "power_field");
+
+        VectorXcd powerField(powerData.sizeT);
+        if (powerData.constSpaces.size()==0){
+            //the smallest eigenvector of the connection Laplacian
+            SparseMatrix<complex<double>> X0Lhs = powerData.smoothLhs*powerData.totalSmoothWeight;  //to bypass the early convergence of igl eigenvalues...
+            vector<Triplet<complex<double>>> X0MTriplets;
+            for (int i=0;i<powerData.sizeT;i++)
+                X0MTriplets.push_back(Triplet<complex<double>>(i, i, tb.tangentSpaceMass(i)*powerData.totalSmoothWeight));
+            SparseMatrix<complex<double>> X0M(powerData.sizeT, powerData.sizeT);
+            X0M.setFromTriplets(X0MTriplets.begin(), X0MTriplets.end());
+
+            Eigen::MatrixXcd U;
+            Eigen::VectorXcd S;
+            {
+                directional::ScopedTimer eigsTimer(report, "power_field.eigensolve");
+                complex_eigs(X0Lhs, X0M, 10, U, S);
+            }
+            int smallestIndex; S.cwiseAbs().minCoeff(&smallestIndex);
+            powerField = U.col(smallestIndex);
+        } else {
+            //power fields are represented as -u^N since they are a special case of PVs.
+            MatrixXd constVectorsIntrinsic = tb.project_to_intrinsic(powerData.constSpaces, powerData.constVectors);
+            VectorXcd constPowers(powerData.constSpaces.size());
+            for (int i=0;i<powerData.constSpaces.size();i++)
+                constPowers(i) = -pow(complex<double>(constVectorsIntrinsic(i,0),constVectorsIntrinsic(i,1)), powerData.N);
+
+            VectorXcd fixedValues(powerData.fixedSpaces.size());
+            for (int i=0;i<powerData.fixedSpaces.size();i++)
+                fixedValues(i) = constPowers(powerData.fixedConstraints(i));
+
+            VectorXcd alignRhs = VectorXcd::Zero(powerData.sizeT);
+            for (int i=0;i<powerData.constSpaces.size();i++)
+                if (powerData.wAlignment(i)>=0.0)
+                    alignRhs(powerData.constSpaces(i)) += powerData.wAlignment(i)*tb.tangentSpaceMass(powerData.constSpaces(i))*constPowers(i)/powerData.totalConstrainedWeight;
+
+            VectorXcd freeRhs = -(powerData.freeFixedLhs*fixedValues);
+            for (int i=0;i<powerData.sizeT;i++)
+                if (powerData.full2Free(i)>=0)
+                    freeRhs(powerData.full2Free(i)) += alignRhs(i);
+
+            VectorXcd freeValues;
+            if (freeRhs.size()!=0){
+                assert(powerData.isFactored && "power_field(): call power_field_precompute() first");
+                directional::ScopedTimer solveTimer(report, "power_field.solve");
+                freeValues = powerData.solver.solve(freeRhs);
+            }
+
+            for (int i=0;i<powerData.sizeT;i++)
+                if (powerData.full2Free(i)>=0)
+                    powerField(i) = freeValues(powerData.full2Free(i));
+            for (int i=0;i<powerData.fixedSpaces.size();i++)
+                powerField(powerData.fixedSpaces(i)) = fixedValues(i);
+        }
+
+        field.init(tb, fieldTypeEnum::POWER_FIELD, powerData.N);
+        MatrixXd intField(powerData.sizeT, 2);
+        intField.col(0) = powerField.real();
+        intField.col(1) = powerField.imag();
+        field.set_intrinsic_field(intField);
+    }
+
+
     // Computes a power field on the entire mesh from given values at the prescribed indices.
-    // If no constraints are given the lowest-eigenvalue (of smoothness energy) field will be returned.
+    // If no constraints are given, the field is fixed to a single arbitrary vector on the first space, to remove the rotation null-space.
     // Input:
     //  tb: underlying tangent bundle.
     //  constFaces: the faces on which the polyvector is prescribed. If a face is repeated and the alignment is hard then all but the first vector in the face will be ignored.
     //  constVectors: #F by 3 in representative form of the N-RoSy's on the tangent spaces.
     //  alignWeights: #constFaces x 1 soft weights for alignment (negative values = fixed faces).
     //  N: The degree of the field.
+    //  report: optional profiling report
     // Output:
     //  powerField: a cartesian power-field object.
     IGL_INLINE void power_field(const TangentBundle& tb,
@@ -33,17 +251,23 @@ namespace directional
                                 const Eigen::MatrixXd& constVectors,
                                 const Eigen::VectorXd& alignWeights,
                                 const int N,
-                                directional::CartesianField& field)
+                                directional::CartesianField& field,
+                                directional::ProfileReport* report=NULL)
     {
-        //TODO: have the field be initialized here
-        polyvector_field(tb,constSpaces,constVectors,1.0, -1.0, alignWeights, N,field);
-        field.fieldType = fieldTypeEnum::POWER_FIELD;
-        //getting rid of the redundant zeros, in case they were allocated.
-        field.intField.conservativeResize(field.intField.rows(),2);
-        field.extField.conservativeResize(field.extField.rows(),3);
-        //powerField=-pvField.col(0);  //powerfield is represented positively
+        PowerFieldData powerData;
+        if (constSpaces.size()!=0) {
+            powerData.constSpaces = constSpaces;
+            powerData.constVectors = constVectors;
+            powerData.wAlignment = alignWeights;
+        }else{
+            powerData.constSpaces.resize(1); powerData.constSpaces(0)=0;
+            Eigen::RowVector2d intConstVector; intConstVector<<1.0,0.0;
+            powerData.constVectors = tb.project_to_extrinsic(powerData.constSpaces, intConstVector);
+            powerData.wAlignment = Eigen::VectorXd::Constant(powerData.constSpaces.size(),-1.0);
+        }
+        power_field_precompute(tb, N, powerData, report);
+        power_field(tb, powerData, field, report);
     }
 }
 
-
 #endif
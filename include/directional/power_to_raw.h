@@ -8,17 +8,65 @@
 #ifndef DIRECTIONAL_POWER_TO_RAW_H
 #define DIRECTIONAL_POWER_TO_RAW_H
 
+#include <cmath>
 #include <igl/igl_inline.h>
+#include <igl/PI.h>
+#include <igl/parallel_for.h>
 #include <directional/TangentBundle.h>
 #include <directional/CartesianField.h>
 
 namespace directional
 {
+    // Computes the (CCW sorted) roots of a power field, in the intrinsic raw format of any scalar type.
+    // Input:
+    //  powerIntField: #T by 2 intrinsic power field
+    //  N: the degree of the field.
+    //  normalize: whether to produce a normalized result (length = 1). Zero power vectors give zero roots either way.
+    // Output:
+    //  rawIntField: #T by 2N the intrinsic roots
+    template <typename DerivedP, typename DerivedR>
+    IGL_INLINE void power_to_raw(const Eigen::MatrixBase<DerivedP>& powerIntField,
+                                 int N,
+                                 Eigen::PlainObjectBase<DerivedR>& rawIntField,
+                                 bool normalize=false)
+    {
+        typedef typename DerivedR::Scalar Scalar;
+
+        //the unit N-th roots of unity, by which the principal root is rotated to get the others
+        Eigen::VectorXd rootCos(N), rootSin(N);
+        for (int k=0;k<N;k++){
+            rootCos(k)=cos(2*igl::PI*(double)k/(double)N);
+            rootSin(k)=sin(2*igl::PI*(double)k/(double)N);
+        }
+
+        //the principal root from the magnitude and angle (instead of a complex pow()), written with all its rotations
+        //(and normalized) straight into the intrinsic field. Power fields are represented as -u^N since they are a special case of PVs.
+        rawIntField.resize(powerIntField.rows(),2*N);
+        igl::parallel_for(powerIntField.rows(), [&](const int i)
+        {
+            const double re=-(double)powerIntField(i,0);
+            const double im=-(double)powerIntField(i,1);
+            const double magnitude=sqrt(re*re+im*im);
+            double rootRe=0.0, rootIm=0.0;
+            if (magnitude>0.0){
+                const double rootMagnitude=(normalize ? 1.0 : pow(magnitude,1.0/(double)N));
+                const double rootAngle=atan2(im,re)/(double)N;
+                rootRe=rootMagnitude*cos(rootAngle);
+                rootIm=rootMagnitude*sin(rootAngle);
+            }
+            for (int k=0;k<N;k++){
+                rawIntField(i,2*k)=(Scalar)(rootRe*rootCos(k)-rootIm*rootSin(k));
+                rawIntField(i,2*k+1)=(Scalar)(rootRe*rootSin(k)+rootIm*rootCos(k));
+            }
+        }, 1000);
+    }
+
+
     // Converts the power complex representation to raw representation.
     // Input:
     //  powerField: a POWER_FIELD field object
     //  N: the degree of the field.
-    //  normalize: whether to produce a normalized result (length = 1)
+    //  normalize: whether to produce a normalized result (length = 1). Zero power vectors give zero roots either way.
     // Output:
     //  rawField: a RAW_FIELD object representing the (CCW sorted) roots of the power field.
     IGL_INLINE void power_to_raw(const directional::CartesianField& powerField,
@@ -28,26 +76,21 @@ namespace directional
     {
         assert(powerField.fieldType==fieldTypeEnum::POWER_FIELD && "The input field should be a power/PolyVector field");
         rawField.init(*(powerField.tb), fieldTypeEnum::RAW_FIELD,N);
-        Eigen::MatrixXcd intFieldComplex(powerField.intField.rows(),N);
-        Eigen::VectorXcd complexPowerField(powerField.intField.rows());
-
-        //power fields are represented as -u^N since they are a special case of PVs.
-        complexPowerField.array().real()=-powerField.intField.col(0);
-        complexPowerField.array().imag()=-powerField.intField.col(1);
-        intFieldComplex.col(0)=pow(complexPowerField.array(),1.0/(double)N);
-        for (int i=1;i<N;i++)
-            intFieldComplex.col(i)=intFieldComplex.col(0)*exp(std::complex<double>(0,2*igl::PI*(double)i/(double)N));
-
-        if (normalize)
-            intFieldComplex.array()/=intFieldComplex.array().abs();
-
-        Eigen::MatrixXd intField(intFieldComplex.rows(),2*N);
-        for (int i=0;i<N;i++){
-            intField.col(2*i)=intFieldComplex.col(i).real();
-            intField.col(2*i+1)=intFieldComplex.col(i).imag();
-        }
+        power_to_raw(powerField.intField, N, rawField.intField, normalize);
+        rawField.extField=rawField.tb->project_to_extrinsic(Eigen::VectorXi(), rawField.intField);
+    }
 
-        rawField.set_intrinsic_field(intField);
+
+    // The same, with the roots stored in a float-storage field
+    IGL_INLINE void power_to_raw(const directional::CartesianField& powerField,
+                                 int N,
+                                 directional::FloatCartesianField& rawField,
+                                 bool normalize=false)
+    {
+        assert(powerField.fieldType==fieldTypeEnum::POWER_FIELD && "The input field should be a power/PolyVector field");
+        rawField.init(*(powerField.tb), fieldTypeEnum::RAW_FIELD,N);
+        power_to_raw(powerField.intField, N, rawField.intField, normalize);
+        rawField.update_extrinsic_field();
     }
 
 }
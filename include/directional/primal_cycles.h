@@ -0,0 +1,148 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2022 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_PRIMAL_CYCLES_H
+#define DIRECTIONAL_PRIMAL_CYCLES_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <igl/igl_inline.h>
+#include <directional/TriMesh.h>
+
+namespace directional
+{
+  // Creates the basis cycles of the primal graph of a mesh (closed loops of edges between vertices), for vertex-based tangent bundles.
+  // The basis cycle matrix first contains #F cycles around every face (by order), then #b cycles along the boundary loops (in the order of mesh.boundaryLoops),
+  // and finally 2*g generator cycles around all handles. The cycles are oriented with the faces, and indexed into all edges: an edge is +1 if it is traversed from EV(i,0) to EV(i,1).
+  // The generators come from a tree-cotree decomposition: a spanning tree of the faces (where every boundary loop is closed by a virtual face), and a spanning tree
+  // of the vertices through the remaining edges. Every edge in neither tree closes a generator with the path between its vertices in the vertex tree.
+  // Everything is linear in the size of the mesh, except the generators, that cost the length of their paths.
+  // Input:
+  //  mesh:             a triangle mesh
+  // Output:
+  //  basisCycles:      #c by #E basis cycles
+  //  face2Cycle:       #F map between faces and their cycles (for comfort; the identity).
+  IGL_INLINE void primal_cycles(const directional::TriMesh& mesh,
+                                Eigen::SparseMatrix<double>& basisCycles,
+                                Eigen::VectorXi& face2Cycle)
+  {
+    using namespace Eigen;
+    using namespace std;
+
+    int numFaces = mesh.F.rows();
+    int numBoundaries = mesh.boundaryLoops.size();
+
+    vector<Triplet<double>> basisCycleTriplets;
+    basisCycleTriplets.reserve(3*numFaces+mesh.boundEdges.size());
+    face2Cycle.resize(numFaces);
+    for (int i=0;i<numFaces;i++){
+      face2Cycle(i)=i;
+      for (int j=0;j<3;j++)
+        basisCycleTriplets.push_back(Triplet<double>(i, mesh.FE(i,j), mesh.FEs(i,j)));
+    }
+
+    //boundary loops, with the orientation of the single face of each boundary edge
+    VectorXi vertex2Loop = VectorXi::Constant(mesh.V.rows(),-1);
+    for (int i=0;i<numBoundaries;i++)
+      for (int j=0;j<mesh.boundaryLoops[i].size();j++)
+        vertex2Loop(mesh.boundaryLoops[i][j])=i;
+
+    vector<vector<int>> loopEdges(numBoundaries);
+    for (int i=0;i<mesh.boundEdges.size();i++){
+      int edge = mesh.boundEdges(i);
+      int loop = vertex2Loop(mesh.EV(edge,0));
+      loopEdges[loop].push_back(edge);
+      basisCycleTriplets.push_back(Triplet<double>(numFaces+loop, edge, (mesh.EF(edge,0)!=-1 ? 1.0 : -1.0)));
+    }
+
+    //spanning tree of the faces and the virtual boundary faces
+    VectorXi isDualTreeEdge = VectorXi::Zero(mesh.EV.rows());
+    VectorXi visitedFaces = VectorXi::Zero(numFaces+numBoundaries);
+    auto edge_faces = [&](const int edge, int& f0, int& f1){
+      f0 = (mesh.EF(edge,0)!=-1 ? mesh.EF(edge,0) : numFaces+vertex2Loop(mesh.EV(edge,0)));
+      f1 = (mesh.EF(edge,1)!=-1 ? mesh.EF(edge,1) : numFaces+vertex2Loop(mesh.EV(edge,0)));
+    };
+    vector<int> faceQueue;
+    faceQueue.reserve(numFaces+numBoundaries);
+    for (int root=0;root<numFaces;root++){  //a forest in case of several components
+      if (visitedFaces(root))
+        continue;
+      visitedFaces(root)=1;
+      faceQueue.push_back(root);
+      for (int q=faceQueue.size()-1;q<faceQueue.size();q++){
+        int currFace = faceQueue[q];
+        int numEdges = (currFace<numFaces ? 3 : loopEdges[currFace-numFaces].size());
+        for (int j=0;j<numEdges;j++){
+          int edge = (currFace<numFaces ? mesh.FE(currFace,j) : loopEdges[currFace-numFaces][j]);
+          int f0, f1;
+          edge_faces(edge, f0, f1);
+          int nextFace = (f0==currFace ? f1 : f0);
+          if (visitedFaces(nextFace))
+            continue;
+          visitedFaces(nextFace)=1;
+          isDualTreeEdge(edge)=1;
+          faceQueue.push_back(nextFace);
+        }
+      }
+    }
+
+    //spanning tree of the vertices through the edges that are not in the face tree
+    VectorXi fatherEdge = VectorXi::Constant(mesh.V.rows(),-1);
+    VectorXi depth = VectorXi::Constant(mesh.V.rows(),-1);
+    vector<int> vertexQueue;
+    vertexQueue.reserve(mesh.V.rows());
+    for (int root=0;root<mesh.V.rows();root++){
+      if ((depth(root)!=-1)||(mesh.vertexValence(root)==0))
+        continue;
+      depth(root)=0;
+      vertexQueue.push_back(root);
+      for (int q=vertexQueue.size()-1;q<vertexQueue.size();q++){
+        int currVertex = vertexQueue[q];
+        for (int j=0;j<mesh.vertexValence(currVertex);j++){
+          int edge = mesh.VE(currVertex,j);
+          if (isDualTreeEdge(edge))
+            continue;
+          int nextVertex = (mesh.EV(edge,0)==currVertex ? mesh.EV(edge,1) : mesh.EV(edge,0));
+          if (depth(nextVertex)!=-1)
+            continue;
+          depth(nextVertex)=depth(currVertex)+1;
+          fatherEdge(nextVertex)=edge;
+          vertexQueue.push_back(nextVertex);
+        }
+      }
+    }
+
+    //every edge in neither tree closes a generator: from EV(i,0) to EV(i,1) on the edge, and back through the tree
+    int currGenerator=numFaces+numBoundaries;
+    for (int i=0;i<mesh.EV.rows();i++){
+      if ((isDualTreeEdge(i))||(fatherEdge(mesh.EV(i,0))==i)||(fatherEdge(mesh.EV(i,1))==i))
+        continue;
+
+      basisCycleTriplets.push_back(Triplet<double>(currGenerator, i, 1.0));
+      int upVertex = mesh.EV(i,1);    //walking up towards the common ancestor
+      int downVertex = mesh.EV(i,0);  //the path from the common ancestor down to EV(i,0), walked in reverse
+      while (upVertex!=downVertex){
+        if (depth(upVertex)>=depth(downVertex)){
+          int edge = fatherEdge(upVertex);
+          basisCycleTriplets.push_back(Triplet<double>(currGenerator, edge, (mesh.EV(edge,0)==upVertex ? 1.0 : -1.0)));
+          upVertex = (mesh.EV(edge,0)==upVertex ? mesh.EV(edge,1) : mesh.EV(edge,0));
+        } else {
+          int edge = fatherEdge(downVertex);
+          basisCycleTriplets.push_back(Triplet<double>(currGenerator, edge, (mesh.EV(edge,1)==downVertex ? 1.0 : -1.0)));
+          downVertex = (mesh.EV(edge,0)==downVertex ? mesh.EV(edge,1) : mesh.EV(edge,0));
+        }
+      }
+      currGenerator++;
+    }
+
+    basisCycles.resize(currGenerator, mesh.EV.rows());
+    basisCycles.setFromTriplets(basisCycleTriplets.begin(), basisCycleTriplets.end());
+  }
+}
+
+#endif
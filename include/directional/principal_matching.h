@@ -13,25 +13,35 @@
 #include <igl/igl_inline.h>
 #include <directional/effort_to_indices.h>
 #include <directional/TangentBundle.h>
+#include <directional/ProfileReport.h>
 
 namespace directional
 {
-    // Takes a field in raw form and computes both the principal effort and the consequent principal matching on every edge.
-    // Important: if the Raw field in not CCW ordered, the result is meaningless.
-    // The input and output are both a RAW_FIELD type cartesian field, in which the matching, effort, and singularities are set.
-    IGL_INLINE void principal_matching(directional::CartesianField& field)
+    // Computes the principal effort and matching on every edge from a raw intrinsic field of any scalar type (the computation is in double).
+    // Input:
+    //  tb:         the tangent bundle of the field
+    //  intField:   #T by 2N CCW-ordered raw intrinsic field
+    //  N:          the degree of the field
+    // Output:
+    //  matching:   #adjSpaces principal matching (-1 for boundary adjacencies)
+    //  effort:     #adjSpaces principal effort
+    template <typename DerivedF>
+    IGL_INLINE void principal_matching(const directional::TangentBundle& tb,
+                                       const Eigen::MatrixBase<DerivedF>& intField,
+                                       const int N,
+                                       Eigen::VectorXi& matching,
+                                       Eigen::VectorXd& effort)
     {
-
         typedef std::complex<double> Complex;
         using namespace Eigen;
         using namespace std;
 
-        field.matching.conservativeResize(field.tb->adjSpaces.rows());
-        field.matching.setConstant(-1);
+        matching.conservativeResize(tb.adjSpaces.rows());
+        matching.setConstant(-1);
 
-        field.effort = VectorXd::Zero(field.tb->adjSpaces.rows());
-        for (int i = 0; i < field.tb->adjSpaces.rows(); i++) {
-            if (field.tb->adjSpaces(i, 0) == -1 || field.tb->adjSpaces(i, 1) == -1)
+        effort = VectorXd::Zero(tb.adjSpaces.rows());
+        for (int i = 0; i < tb.adjSpaces.rows(); i++) {
+            if (tb.adjSpaces(i, 0) == -1 || tb.adjSpaces(i, 1) == -1)
                 continue;
 
             double minRotAngle=10000.0;
@@ -40,15 +50,15 @@ namespace directional
             //computing some effort and the extracting principal one
             Complex freeCoeff(1.0,0.0);
             //finding where the 0 vector in EF(i,0) goes to with smallest rotation angle in EF(i,1), computing the effort, and then adjusting the matching to have principal effort.
-            RowVector2d vec0f = field.intField.block(field.tb->adjSpaces(i, 0), 0, 1, 2);
+            RowVector2d vec0f = intField.block(tb.adjSpaces(i, 0), 0, 1, 2).template cast<double>();
             Complex vec0fc = Complex(vec0f(0), vec0f(1));
-            Complex transvec0fc = vec0fc*field.tb->connection(i);
-            for (int j = 0; j < field.N; j++) {
-                RowVector2d vecjf = field.intField.block(field.tb->adjSpaces(i, 0), 2 * j, 1, 2);
+            Complex transvec0fc = vec0fc*tb.connection(i);
+            for (int j = 0; j < N; j++) {
+                RowVector2d vecjf = intField.block(tb.adjSpaces(i, 0), 2 * j, 1, 2).template cast<double>();
                 Complex vecjfc = Complex(vecjf(0),vecjf(1));
-                RowVector2d vecjg = field.intField.block(field.tb->adjSpaces(i, 1), 2 * j, 1, 2);
+                RowVector2d vecjg = intField.block(tb.adjSpaces(i, 1), 2 * j, 1, 2).template cast<double>();
                 Complex vecjgc = Complex(vecjg(0),vecjg(1));
-                Complex transvecjfc = vecjfc*field.tb->connection(i);
+                Complex transvecjfc = vecjfc*tb.connection(i);
                 freeCoeff *= (vecjgc / transvecjfc);
                 double currRotAngle =arg(vecjgc / transvec0fc);
                 if (abs(currRotAngle)<abs(minRotAngle)){
@@ -59,26 +69,47 @@ namespace directional
                 //taking principal effort
 
             }
-            field.effort(i) = arg(freeCoeff);
+            effort(i) = arg(freeCoeff);
 
             //finding the matching that implements effort(i)
             //This is still not perfect
             double currEffort=0;
-            for (int j = 0; j < field.N; j++) {
-                RowVector2d vecjf = field.intField.block(field.tb->adjSpaces(i, 0), 2*j, 1, 2);
+            for (int j = 0; j < N; j++) {
+                RowVector2d vecjf = intField.block(tb.adjSpaces(i, 0), 2*j, 1, 2).template cast<double>();
                 Complex vecjfc = Complex(vecjf(0), vecjf(1));
-                RowVector2d vecjg = field.intField.block(field.tb->adjSpaces(i, 1), 2 *((j+indexMinFromZero+field.N)%field.N), 1, 2);
+                RowVector2d vecjg = intField.block(tb.adjSpaces(i, 1), 2 *((j+indexMinFromZero+N)%N), 1, 2).template cast<double>();
                 Complex vecjgc = Complex(vecjg(0), vecjg(1));
-                Complex transvecjfc = vecjfc*field.tb->connection(i);
+                Complex transvecjfc = vecjfc*tb.connection(i);
                 currEffort+= arg(vecjgc / transvecjfc);
             }
 
-            field.matching(i)=indexMinFromZero-round((currEffort-field.effort(i))/(2.0*igl::PI));
+            matching(i)=indexMinFromZero-round((currEffort-effort(i))/(2.0*igl::PI));
         }
+    }
+
+
+    // Takes a field in raw form and computes both the principal effort and the consequent principal matching on every edge.
+    // Important: if the Raw field in not CCW ordered, the result is meaningless.
+    // The input and output are both a RAW_FIELD type cartesian field, in which the matching, effort, and singularities are set.
+    // report (optional) collects the timing of the function.
+    IGL_INLINE void principal_matching(directional::CartesianField& field,
+                                       directional::ProfileReport* report=NULL)
+    {
+        directional::ScopedTimer timer(report, "principal_matching");
+        principal_matching(*(field.tb), field.intField, field.N, field.matching, field.effort);
 
         //Getting final singularities and their indices
         effort_to_indices(field);
+    }
 
+
+    // The same for a float-storage field
+    IGL_INLINE void principal_matching(directional::FloatCartesianField& field,
+                                       directional::ProfileReport* report=NULL)
+    {
+        directional::ScopedTimer timer(report, "principal_matching");
+        principal_matching(*(field.tb), field.intField, field.N, field.matching, field.effort);
+        effort_to_indices(field);
     }
 }
 
@@ -22,6 +22,7 @@
 #include <directional/dcel.h>
 #include <directional/cut_mesh_with_singularities.h>
 #include <directional/combing.h>
+#include <directional/ProfileReport.h>
 
 namespace directional
 {
@@ -32,11 +33,6 @@ namespace directional
         int n;                                              // # independent parameteric functions
         Eigen::MatrixXi linRed;                             // Linear Reduction tying the n dofs to the full N
         Eigen::MatrixXi periodMat;                          // Function spanning integers
-        Eigen::SparseMatrix<double> vertexTrans2CutMat;     // Map between the whole mesh (vertex + translational jump) representation to the vertex-based representation on the cut mesh
-        Eigen::SparseMatrix<double> constraintMat;          // Linear constraints (resulting from non-singular nodes)
-        Eigen::SparseMatrix<double> linRedMat;              // Global uncompression of n->N
-        Eigen::SparseMatrix<double> intSpanMat;             // Spanning the translational jump lattice
-        Eigen::SparseMatrix<double> singIntSpanMat;         // Layer for the singularities
         Eigen::VectorXi constrainedVertices;                // Constrained vertices (fixed points in the parameterization)
         Eigen::VectorXi integerVars;                        // Variables that are to be rounded.
         Eigen::MatrixXi face2cut;                           // |F|x3 map of which edges of faces are seams
@@ -46,12 +42,14 @@ namespace directional
         Eigen::VectorXd fixedValues;                        // Translation fixed values
         Eigen::VectorXi singularIndices;                    // Singular-vertex indices
 
-        //integer versions, for exact seamless parameterizations (good for error-free meshing)
-        Eigen::SparseMatrix<int> vertexTrans2CutMatInteger;
-        Eigen::SparseMatrix<int> constraintMatInteger;
-        Eigen::SparseMatrix<int> linRedMatInteger;
-        Eigen::SparseMatrix<int> intSpanMatInteger;
-        Eigen::SparseMatrix<int> singIntSpanMatInteger;
+        //Operators from the reduced variables, composed once by setup_integration() from the layers
+        //vertexTrans2CutMat (whole mesh vertices + translational jumps -> cut mesh vertices), constraintMat (linear constraints from non-singular nodes),
+        //linRedMat (global uncompression of n->N), singIntSpanMat (layer for the singularities) and intSpanMat (spanning the translational jump lattice).
+        //Only the compositions are kept (the seam layers stay in IntegrationSetupCache for reuse).
+        Eigen::SparseMatrix<double> x2CutMat;               // vertexTrans2CutMat * linRedMat * singIntSpanMat * intSpanMat
+        Eigen::SparseMatrix<double> x2ConstraintMat;        // constraintMat * linRedMat * singIntSpanMat * intSpanMat
+        Eigen::SparseMatrix<int> x2CutMatInteger;           // integer versions, for exact seamless parameterizations (good for error-free meshing)
+        Eigen::SparseMatrix<int> x2ConstraintMatInteger;
 
         double lengthRatio;                                 // Global scaling of functions
         //Flags
@@ -100,13 +98,74 @@ namespace directional
         IGL_INLINE void set_default_period_matrix(int n){
             periodMat=Eigen::MatrixXi::Identity(n,n);
         }
+
+        //Composes the operator chains from the individual layers. The shared reduction chain is multiplied from the right once,
+        //so that all intermediate products stay in the reduced variable space.
+        template<typename Scalar>
+        IGL_INLINE static void compose_operators(const Eigen::SparseMatrix<Scalar>& vertexTrans2CutMat,
+                                                 const Eigen::SparseMatrix<Scalar>& constraintMat,
+                                                 const Eigen::SparseMatrix<Scalar>& linRedMat,
+                                                 const Eigen::SparseMatrix<Scalar>& singIntSpanMat,
+                                                 const Eigen::SparseMatrix<Scalar>& intSpanMat,
+                                                 Eigen::SparseMatrix<Scalar>& x2CutMat,
+                                                 Eigen::SparseMatrix<Scalar>& x2ConstraintMat){
+            Eigen::SparseMatrix<Scalar> reducedSpanMat = linRedMat * Eigen::SparseMatrix<Scalar>(singIntSpanMat * intSpanMat);
+            x2CutMat = vertexTrans2CutMat * reducedSpanMat;
+            x2ConstraintMat = constraintMat * reducedSpanMat;
+        }
     };
 
+    //Data of setup_integration() that depends only on the whole mesh, the singularities, and the matching (and N), but not on the linear reduction,
+    //the period matrix, or lengthRatio. Passing the same object to consecutive calls of setup_integration() only rebuilds the layers whose input has changed,
+    //which makes sweeps over linear reductions or rounding parameters on a fixed singularity set cheap.
+    struct IntegrationSetupCache
+    {
+        //Keys
+        const directional::TriMesh* mesh;                   // The whole mesh on which the cache was computed
+        Eigen::MatrixXd V;                                  // Its content, so that a mesh edited in place (or a new mesh at the same address) is detected
+        Eigen::MatrixXi F, EV;
+        int N;                                              // # of functions for which the seam maps were computed
+        Eigen::VectorXi singLocalCycles;                    // Singularities that generated the cut
+        Eigen::VectorXi matching;                           // Matching of the uncombed field
+        Eigen::MatrixXd intField;                           // The uncombed field
+
+        //Mesh layer
+        Eigen::VectorXi VH, HV, HE, HF, nextH, prevH, twinH;// Half-edge representation of the whole mesh
+        Eigen::MatrixXi EH, FH;
+        Eigen::VectorXi isBoundary;                         // Boundary vertices
+
+        //Cut layer
+        Eigen::MatrixXi face2cut;                           // |F|x3 map of which edges of faces are seams
+        Eigen::VectorXi isSingular;                         // Inner singular vertices
+        Eigen::VectorXi isHEcut;                            // Half-edges on the seams
+        Eigen::VectorXi Halfedge2TransitionIndices;         // Signed (1-based) translational jump of every seam half-edge
+        int numTransitions;                                 // # translational jumps
+        directional::TriMesh meshCut;                       // The cut mesh
+
+        //Combing layer
+        directional::CartesianField combedField;            // The field combed with respect to face2cut
+
+        //Seam layer
+        Eigen::VectorXi constrainedVertices;
+        Eigen::SparseMatrix<double> vertexTrans2CutMat;
+        Eigen::SparseMatrix<double> constraintMat;
+        Eigen::SparseMatrix<int> vertexTrans2CutMatInteger;
+        Eigen::SparseMatrix<int> constraintMatInteger;
+
+        IntegrationSetupCache():mesh(NULL), N(-1), numTransitions(0){}
+        ~IntegrationSetupCache(){}
+
+        //Invalidates all layers. This is not needed when the mesh changes, as its content (V, F, EV) is compared on every call.
+        IGL_INLINE void clear(){mesh=NULL; N=-1; V.resize(0,0); F.resize(0,0); EV.resize(0,0);}
+    };
 
 
     // Setting up the seamless integration algorithm. Seamless integration only works on IntrinsicFaceTangentBundle at the moment.
     // Input:
     //  field:        a face-based raw field that is to be integrated.
+    // Input/Output:
+    //  cache:        cached topology from previous calls. Only the layers whose keys (mesh and its V, F, EV, singularities, matching, field, N) differ are recomputed.
+    //  report:       optional profiling report, which also counts the rebuilt layers.
     // Output:
     //  intData:      updated integration data.
     //  meshCut:      a mesh which is face-corresponding with meshWhole, but is cut so that it has disc-topology.
@@ -114,410 +173,475 @@ namespace directional
     IGL_INLINE void setup_integration(const directional::CartesianField& field,
                                       IntegrationData& intData,
                                       directional::TriMesh& meshCut,
-                                      directional::CartesianField& combedField)
+                                      directional::CartesianField& combedField,
+                                      IntegrationSetupCache& cache,
+                                      directional::ProfileReport* report=NULL)
     {
 
         using namespace Eigen;
         using namespace std;
+        directional::ScopedTimer timer(report, "setup_integration");
 
         assert(field.tb->discTangType()==discTangTypeEnum::FACE_SPACES && "setup_integration() only works with face-based fields");
 
         const directional::TriMesh& meshWhole = *((IntrinsicFaceTangentBundle*)(field.tb))->mesh;
-        //cutting mesh and combing field.
-        cut_mesh_with_singularities(meshWhole.V, meshWhole.F, field.singLocalCycles, intData.face2cut);
-        combing(field, combedField, intData.face2cut);
-
-        MatrixXi EFi,EH, FH;
-        MatrixXd FEs;
-        VectorXi VH, HV, HE, HF, nextH, prevH, twinH, innerEdges;
-
-        // it stores number of edges per face, for now only tirangular
-        VectorXi D = VectorXi::Constant(meshWhole.F.rows(), 3);
-
-        // mark vertices as being a singularity vertex of the vector field
-        VectorXi isSingular = VectorXi::Zero(meshWhole.V.rows());
-        for (int i = 0; i < field.singLocalCycles.size(); i++)
-            isSingular(field.singLocalCycles(i)) = 1;
-
-        //cout<<"singVertices: "<<singVertices<<endl;
-
-        intData.constrainedVertices = VectorXi::Zero(meshWhole.V.rows());
-
-        // compute the half-edge representation
-        hedra::dcel(D, meshWhole.F, meshWhole.EV, meshWhole.EF, meshWhole.EFi, meshWhole.innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH);
-
-        // find boundary vertices and mark them
-        VectorXi isBoundary = VectorXi::Zero(meshWhole.V.rows());
-        for (int i = 0; i < HV.rows(); i++)
-            if (twinH(i) == -1){
-                isBoundary(HV(i)) = 1;
-                isSingular(HV(i)) = 0; //boundary vertices cannot be singular
-            }
 
-        // here we compute a permutation matrix
-        vector<MatrixXi> constParmMatrices(intData.N);
-        MatrixXi unitPermMatrix = MatrixXi::Zero(intData.N, intData.N);
-        for (int i = 0; i < intData.N; i++)
-            unitPermMatrix((i + 1) % intData.N, i) = 1;
-
-        // generate all the members of the permutation group
-        constParmMatrices[0] = MatrixXi::Identity(intData.N, intData.N);
-        for (int i = 1; i < intData.N; i++)
-            constParmMatrices[i] = unitPermMatrix * constParmMatrices[i - 1];
-
-        // each edge which is on the cut seam is marked by 1 and 0 otherwise
-        VectorXi isSeam = VectorXi::Zero(meshWhole.EV.rows());
-        for(int i = 0; i < meshWhole.FE.rows(); i++)
-        {
-            for (int j = 0; j < 3; j++)
-                if (intData.face2cut(i, j)) // face2cut is initalized by directional::cut_mesh_with_singularities
-                    isSeam(meshWhole.FE(i, j)) = 1;
-        }
-
-        // do the same for the half-edges, mark edges which correspond to the cut seam
-        VectorXi isHEcut = VectorXi::Zero(HE.rows());
-        for(int i = 0; i < meshWhole.F.rows(); i++)
-        {
-            for (int j = 0; j < 3; j++)
-                if (intData.face2cut(i, j)) // face2cut is initalized by directional::cut_mesh_with_singularities
-                    isHEcut(FH(i, j)) = 1; // FH is face to half-edge mapping
+        bool meshChanged = (cache.mesh!=&meshWhole) || (cache.HE.rows()!=3*meshWhole.F.rows()) ||
+                           (cache.V.rows()!=meshWhole.V.rows()) || (cache.V.cols()!=meshWhole.V.cols()) || (cache.V!=meshWhole.V) ||
+                           (cache.F.rows()!=meshWhole.F.rows()) || (cache.F!=meshWhole.F) ||
+                           (cache.EV.rows()!=meshWhole.EV.rows()) || (cache.EV!=meshWhole.EV);
+        bool singsChanged = meshChanged || (cache.singLocalCycles.size()!=field.singLocalCycles.size()) || (cache.singLocalCycles!=field.singLocalCycles);
+        bool fieldChanged = singsChanged || (cache.combedField.N!=field.N) ||
+                            (cache.matching.size()!=field.matching.size()) || (cache.matching!=field.matching) ||
+                            (cache.intField.rows()!=field.intField.rows()) || (cache.intField.cols()!=field.intField.cols()) || (cache.intField!=field.intField);
+        bool seamsChanged = singsChanged || (cache.N!=intData.N);
+
+        VectorXi& VH = cache.VH; VectorXi& HV = cache.HV; VectorXi& HE = cache.HE; VectorXi& HF = cache.HF;
+        VectorXi& nextH = cache.nextH; VectorXi& prevH = cache.prevH; VectorXi& twinH = cache.twinH;
+        MatrixXi& EH = cache.EH; MatrixXi& FH = cache.FH;
+        VectorXi& isBoundary = cache.isBoundary;
+        VectorXi& isSingular = cache.isSingular;
+        VectorXi& isHEcut = cache.isHEcut;
+        VectorXi& Halfedge2TransitionIndices = cache.Halfedge2TransitionIndices;
+
+        if (meshChanged){
+            directional::ScopedTimer layerTimer(report, "setup_integration.mesh");
+            if (report)
+                report->add_counter("setup_integration.mesh_rebuilds");
+            // it stores number of edges per face, for now only tirangular
+            VectorXi D = VectorXi::Constant(meshWhole.F.rows(), 3);
+
+            // compute the half-edge representation
+            hedra::dcel(D, meshWhole.F, meshWhole.EV, meshWhole.EF, meshWhole.EFi, meshWhole.innerEdges, VH, EH, FH, HV, HE, HF, nextH, prevH, twinH);
+
+            // find boundary vertices and mark them
+            isBoundary = VectorXi::Zero(meshWhole.V.rows());
+            for (int i = 0; i < HV.rows(); i++)
+                if (twinH(i) == -1)
+                    isBoundary(HV(i)) = 1;
         }
 
-        // calculate valency of the vertices which lay on the seam
-        VectorXi cutValence = VectorXi::Zero(meshWhole.V.rows());
-        for(int i = 0; i < meshWhole.EV.rows(); i++)
-        {
-            if (isSeam(i))
+        if (singsChanged){
+            directional::ScopedTimer layerTimer(report, "setup_integration.cut");
+            if (report)
+                report->add_counter("setup_integration.cut_rebuilds");
+            //cutting mesh
+            cut_mesh_with_singularities(meshWhole, field.singLocalCycles, cache.face2cut);
+
+            // mark vertices as being a singularity vertex of the vector field
+            isSingular = VectorXi::Zero(meshWhole.V.rows());
+            for (int i = 0; i < field.singLocalCycles.size(); i++)
+                isSingular(field.singLocalCycles(i)) = 1;
+
+            for (int i = 0; i < isBoundary.size(); i++)
+                if (isBoundary(i))
+                    isSingular(i) = 0; //boundary vertices cannot be singular
+
+            // each edge which is on the cut seam is marked by 1 and 0 otherwise
+            VectorXi isSeam = VectorXi::Zero(meshWhole.EV.rows());
+            for(int i = 0; i < meshWhole.FE.rows(); i++)
             {
-                cutValence(meshWhole.EV(i, 0))++;
-                cutValence(meshWhole.EV(i, 1))++;
+                for (int j = 0; j < 3; j++)
+                    if (cache.face2cut(i, j)) // face2cut is initalized by directional::cut_mesh_with_singularities
+                        isSeam(meshWhole.FE(i, j)) = 1;
             }
-        }
-
 
-        //establishing transition variables by tracing cut curves
-        VectorXi Halfedge2TransitionIndices = VectorXi::Constant(HE.rows(), 32767);
-        VectorXi Halfedge2Matching(HE.rows());
-        VectorXi isHEClaimed = VectorXi::Zero(HE.rows());
+            // do the same for the half-edges, mark edges which correspond to the cut seam
+            isHEcut = VectorXi::Zero(HE.rows());
+            for(int i = 0; i < meshWhole.F.rows(); i++)
+            {
+                for (int j = 0; j < 3; j++)
+                    if (cache.face2cut(i, j)) // face2cut is initalized by directional::cut_mesh_with_singularities
+                        isHEcut(FH(i, j)) = 1; // FH is face to half-edge mapping
+            }
 
-        // here we convert the matching that was calculated for the vector field over edges to half-edges
-        for (int i = 0; i < HE.rows(); i++)
-        {
-            // HE is a map between half-edges to edges, but it does not carry the direction
-            // EH edge to half-edge mapping
-            Halfedge2Matching(i) = (EH(HE(i), 0) == i ? -combedField.matching(HE(i)) : combedField.matching(HE(i)));
-            if(Halfedge2Matching(i) < 0)
-                Halfedge2Matching(i) = (intData.N + (Halfedge2Matching(i) % intData.N)) % intData.N;
-        }
+            // calculate valency of the vertices which lay on the seam
+            VectorXi cutValence = VectorXi::Zero(meshWhole.V.rows());
+            for(int i = 0; i < meshWhole.EV.rows(); i++)
+            {
+                if (isSeam(i))
+                {
+                    cutValence(meshWhole.EV(i, 0))++;
+                    cutValence(meshWhole.EV(i, 1))++;
+                }
+            }
 
-        int currTransition = 1;
+            //establishing transition variables by tracing cut curves
+            Halfedge2TransitionIndices = VectorXi::Constant(HE.rows(), 32767);
+            VectorXi isHEClaimed = VectorXi::Zero(HE.rows());
 
-        /*
-         * Next steps: cutting mesh and creating map between wholeF and cutF
-         */
+            int currTransition = 1;
 
-        //cutting the mesh
-        vector<int> cut2whole;
-        vector<RowVector3d> cutVlist;
-        MatrixXi cutF;
-        MatrixXd cutV;
-        cutF.resize(meshWhole.F.rows(),3);
-        for (int i = 0; i < VH.rows(); i++)
-        {
-            //creating corners whereever we have non-trivial matching
-            int beginH = VH(i);
-            int currH = beginH;
+            /*
+             * Next steps: cutting mesh and creating map between wholeF and cutF
+             */
 
-            //reseting to first cut or first boundary, if exists
-            if (!isBoundary(i))
+            //cutting the mesh
+            vector<int> cut2whole;
+            vector<RowVector3d> cutVlist;
+            MatrixXi cutF;
+            MatrixXd cutV;
+            cutF.resize(meshWhole.F.rows(),3);
+            for (int i = 0; i < VH.rows(); i++)
             {
-                do
+                //creating corners whereever we have non-trivial matching
+                int beginH = VH(i);
+                int currH = beginH;
+
+                //reseting to first cut or first boundary, if exists
+                if (!isBoundary(i))
                 {
-                    if (isHEcut(currH)!=0)
-                        break;
-                    currH=nextH(twinH(currH));
-                } while (beginH!=currH);
-            }
-            else
-            {
-                do
+                    do
+                    {
+                        if (isHEcut(currH)!=0)
+                            break;
+                        currH=nextH(twinH(currH));
+                    } while (beginH!=currH);
+                }
+                else
                 {
-                    if (twinH(currH)==-1)
-                        break;
-                    currH=nextH(twinH(currH));
-                } while(twinH(currH)!=-1);
-            }
+                    do
+                    {
+                        if (twinH(currH)==-1)
+                            break;
+                        currH=nextH(twinH(currH));
+                    } while(twinH(currH)!=-1);
+                }
 
-            beginH = currH;
+                beginH = currH;
 
-            do
-            {
-                if ((isHEcut(currH) != 0) || (beginH == currH))
+                do
                 {
-                    cut2whole.push_back(i);
-                    cutVlist.push_back(meshWhole.V.row(i));
-                }
+                    if ((isHEcut(currH) != 0) || (beginH == currH))
+                    {
+                        cut2whole.push_back(i);
+                        cutVlist.push_back(meshWhole.V.row(i));
+                    }
 
-                for (int j = 0; j < 3; j++)
-                    if (meshWhole.F(HF(currH), j) == i)
-                        cutF(HF(currH), j) = cut2whole.size() - 1;
-                currH = twinH(prevH(currH));
-            } while((beginH != currH) && (currH != -1));
-        }
+                    for (int j = 0; j < 3; j++)
+                        if (meshWhole.F(HF(currH), j) == i)
+                            cutF(HF(currH), j) = cut2whole.size() - 1;
+                    currH = twinH(prevH(currH));
+                } while((beginH != currH) && (currH != -1));
+            }
 
-        cutV.resize(cutVlist.size(), 3);
-        for(int i = 0; i < cutVlist.size(); i++)
-            cutV.row(i) = cutVlist[i];
+            cutV.resize(cutVlist.size(), 3);
+            for(int i = 0; i < cutVlist.size(); i++)
+                cutV.row(i) = cutVlist[i];
 
-        //starting from each cut-graph node, we trace cut curves
-        for(int i = 0;  i < meshWhole.V.rows(); i++)
-        {
-            if (((cutValence(i) == 2) && (!isSingular(i))) || (cutValence(i) == 0))
-                continue;  //either mid-cut curve or non at all
+            //starting from each cut-graph node, we trace cut curves
+            for(int i = 0;  i < meshWhole.V.rows(); i++)
+            {
+                if (((cutValence(i) == 2) && (!isSingular(i))) || (cutValence(i) == 0))
+                    continue;  //either mid-cut curve or non at all
 
-            //tracing curves until next node, if not already filled
-            int beginH = VH(i);
+                //tracing curves until next node, if not already filled
+                int beginH = VH(i);
 
-            //reseting to first boundary
-            int currH = beginH;
+                //reseting to first boundary
+                int currH = beginH;
 
-            if (isBoundary(i))
-            {
-                do
+                if (isBoundary(i))
                 {
-                    if (twinH(currH) == -1)
-                        break;
-                    currH = nextH(twinH(currH));
-                } while(twinH(currH) != -1);
-            }
+                    do
+                    {
+                        if (twinH(currH) == -1)
+                            break;
+                        currH = nextH(twinH(currH));
+                    } while(twinH(currH) != -1);
+                }
 
-            beginH = currH;
+                beginH = currH;
 
-            int nextHalfedgeInCut = -1;
-            do
-            {
-                //unclaimed inner halfedge
-                if ((isHEcut(currH) != 0) && (isHEClaimed(currH) == 0) && (twinH(currH) != -1))
+                int nextHalfedgeInCut = -1;
+                do
                 {
-                    nextHalfedgeInCut = currH;
-                    Halfedge2TransitionIndices(nextHalfedgeInCut) = currTransition;
-                    Halfedge2TransitionIndices(twinH(nextHalfedgeInCut)) = -currTransition;
-                    isHEClaimed(nextHalfedgeInCut) = 1;
-                    isHEClaimed(twinH(nextHalfedgeInCut)) = 1;
-                    int nextCutVertex=HV(nextH(nextHalfedgeInCut));
-                    //advancing on the cut until next node
-                    while ((cutValence(nextCutVertex) == 2) && (!isSingular(nextCutVertex)) && (!isBoundary(nextCutVertex)))
+                    //unclaimed inner halfedge
+                    if ((isHEcut(currH) != 0) && (isHEClaimed(currH) == 0) && (twinH(currH) != -1))
                     {
-                        int beginH = VH(nextCutVertex);
-                        int currH = beginH;
-                        int nextHalfedgeInCut = -1;
-                        do
-                        {
-                            //unclaimed cut halfedge
-                            if ((isHEcut(currH) != 0) && (isHEClaimed(currH) == 0))
-                            {
-                                nextHalfedgeInCut = currH;
-                                break;
-                            }
-                            currH=twinH(prevH(currH));
-                        } while (beginH != currH);
+                        nextHalfedgeInCut = currH;
                         Halfedge2TransitionIndices(nextHalfedgeInCut) = currTransition;
                         Halfedge2TransitionIndices(twinH(nextHalfedgeInCut)) = -currTransition;
                         isHEClaimed(nextHalfedgeInCut) = 1;
                         isHEClaimed(twinH(nextHalfedgeInCut)) = 1;
-                        nextCutVertex = HV(nextH(nextHalfedgeInCut));
+                        int nextCutVertex=HV(nextH(nextHalfedgeInCut));
+                        //advancing on the cut until next node
+                        while ((cutValence(nextCutVertex) == 2) && (!isSingular(nextCutVertex)) && (!isBoundary(nextCutVertex)))
+                        {
+                            int beginH = VH(nextCutVertex);
+                            int currH = beginH;
+                            int nextHalfedgeInCut = -1;
+                            do
+                            {
+                                //unclaimed cut halfedge
+                                if ((isHEcut(currH) != 0) && (isHEClaimed(currH) == 0))
+                                {
+                                    nextHalfedgeInCut = currH;
+                                    break;
+                                }
+                                currH=twinH(prevH(currH));
+                            } while (beginH != currH);
+                            Halfedge2TransitionIndices(nextHalfedgeInCut) = currTransition;
+                            Halfedge2TransitionIndices(twinH(nextHalfedgeInCut)) = -currTransition;
+                            isHEClaimed(nextHalfedgeInCut) = 1;
+                            isHEClaimed(twinH(nextHalfedgeInCut)) = 1;
+                            nextCutVertex = HV(nextH(nextHalfedgeInCut));
+                        }
+                        currTransition++;
                     }
-                    currTransition++;
-                }
-                currH = twinH(prevH(currH));
-            } while((beginH != currH) && (currH != -1));
+                    currH = twinH(prevH(currH));
+                } while((beginH != currH) && (currH != -1));
+            }
+            // end of cutting
+
+            cache.numTransitions = currTransition - 1;
+            cache.meshCut.set_mesh(cutV, cutF);
         }
-        // end of cutting
-
-        int numTransitions = currTransition - 1;
-        //cout<<"numtransitions: "<<numTransitions<<endl;
-        vector<Triplet<double> > vertexTrans2CutTriplets, constTriplets;
-        vector<Triplet<int> > vertexTrans2CutTripletsInteger, constTripletsInteger;
-        //forming the constraints and the singularity positions
-        int currConst = 0;
-        // this loop set up the transtions (vector field matching) across the cuts
-        for (int i = 0; i < VH.rows(); i++)
-        {
-            std::vector<MatrixXi> permMatrices;
-            std::vector<int> permIndices;  //in the space #V + #transitions
-            //The initial corner gets the identity without any transition
-            permMatrices.push_back(MatrixXi::Identity(intData.N, intData.N));
-            permIndices.push_back(i);
 
-            int beginH = VH(i);
-            int currH = beginH;
+        if (fieldChanged){
+            directional::ScopedTimer layerTimer(report, "setup_integration.combing");
+            if (report)
+                report->add_counter("setup_integration.combing_rebuilds");
+            //combing field; the combed matching only changes the seam layer if it differs from the previous one
+            VectorXi prevCombedMatching = cache.combedField.matching;
+            combing(field, cache.combedField, cache.face2cut, report);
+            cache.matching = field.matching;
+            cache.intField = field.intField;
+            if ((prevCombedMatching.size()!=cache.combedField.matching.size()) || (prevCombedMatching!=cache.combedField.matching))
+                seamsChanged = true;
+        }
+
+        int numTransitions = cache.numTransitions;
+        const MatrixXi& cutF = cache.meshCut.F;
+
+        if (seamsChanged){
+            directional::ScopedTimer layerTimer(report, "setup_integration.seams");
+            if (report)
+                report->add_counter("setup_integration.seam_rebuilds");
+            cache.constrainedVertices = VectorXi::Zero(meshWhole.V.rows());
+
+            // here we compute a permutation matrix
+            vector<MatrixXi> constParmMatrices(intData.N);
+            MatrixXi unitPermMatrix = MatrixXi::Zero(intData.N, intData.N);
+            for (int i = 0; i < intData.N; i++)
+                unitPermMatrix((i + 1) % intData.N, i) = 1;
 
-            //reseting to first cut or boundary, if exists
-            if (!isBoundary(i))
+            // generate all the members of the permutation group
+            constParmMatrices[0] = MatrixXi::Identity(intData.N, intData.N);
+            for (int i = 1; i < intData.N; i++)
+                constParmMatrices[i] = unitPermMatrix * constParmMatrices[i - 1];
+
+            VectorXi Halfedge2Matching(HE.rows());
+
+            // here we convert the matching that was calculated for the vector field over edges to half-edges
+            for (int i = 0; i < HE.rows(); i++)
             {
-                // travel throu the start of the vertex and stop once the edge on the cut is found
-                do
-                {
-                    if (isHEcut(currH) != 0)
-                        break;
-                    currH = nextH(twinH(currH));
-                } while(beginH != currH);
+                // HE is a map between half-edges to edges, but it does not carry the direction
+                // EH edge to half-edge mapping
+                Halfedge2Matching(i) = (EH(HE(i), 0) == i ? -cache.combedField.matching(HE(i)) : cache.combedField.matching(HE(i)));
+                if(Halfedge2Matching(i) < 0)
+                    Halfedge2Matching(i) = (intData.N + (Halfedge2Matching(i) % intData.N)) % intData.N;
             }
-            else
+
+            vector<Triplet<double> > vertexTrans2CutTriplets, constTriplets;
+            vector<Triplet<int> > vertexTrans2CutTripletsInteger, constTripletsInteger;
+            //forming the constraints and the singularity positions
+            int currConst = 0;
+            // this loop set up the transtions (vector field matching) across the cuts
+            for (int i = 0; i < VH.rows(); i++)
             {
-                do
-                {
-                    // travel until an edge without a twin is found, i.e., boundary
-                    if (twinH(currH) == -1)
-                        break;
-                    currH = nextH(twinH(currH));
-                } while(twinH(currH) != -1);
-            }
+                std::vector<MatrixXi> permMatrices;
+                std::vector<int> permIndices;  //in the space #V + #transitions
+                //The initial corner gets the identity without any transition
+                permMatrices.push_back(MatrixXi::Identity(intData.N, intData.N));
+                permIndices.push_back(i);
 
-            // set the beginning to the edge on the cut or on the boundary
-            beginH = currH;
+                int beginH = VH(i);
+                int currH = beginH;
 
-            int currCutVertex = -1;
-            do
-            {
-                int currFace = HF(currH); // face containing the half-edge
-                int newCutVertex = -1;
-                //find position of the vertex i in the face of the initial mesh
-                for (int j = 0; j < 3; j++)
+                //reseting to first cut or boundary, if exists
+                if (!isBoundary(i))
                 {
-                    if (meshWhole.F(currFace, j) == i)
-                        newCutVertex = cutF(currFace, j);
+                    // travel throu the start of the vertex and stop once the edge on the cut is found
+                    do
+                    {
+                        if (isHEcut(currH) != 0)
+                            break;
+                        currH = nextH(twinH(currH));
+                    } while(beginH != currH);
                 }
-
-                //currCorner gets the permutations so far
-                if (newCutVertex != currCutVertex)
+                else
                 {
-                    currCutVertex = newCutVertex;
-                    for(int i = 0; i < permIndices.size(); i++)
+                    do
                     {
-                        // place the perumtation matrix in a bigger matrix, we need to know how things are connected along the cut, no?
-                        for(int j = 0; j < intData.N; j++)
-                            for(int k = 0; k < intData.N; k++){
-                                vertexTrans2CutTriplets.emplace_back(intData.N * currCutVertex + j, intData.N * permIndices[i] + k, (double) permMatrices[i](j, k));
-                                vertexTrans2CutTripletsInteger.emplace_back(intData.N * currCutVertex + j, intData.N * permIndices[i] + k, permMatrices[i](j, k));
-                            }
-                    }
+                        // travel until an edge without a twin is found, i.e., boundary
+                        if (twinH(currH) == -1)
+                            break;
+                        currH = nextH(twinH(currH));
+                    } while(twinH(currH) != -1);
                 }
 
-                //updating the matrices for the next corner
-                int nextHalfedge = twinH(prevH(currH));
-                //reached a boundary
-                if(nextHalfedge == -1)
-                {
-                    currH = nextHalfedge;
-                    continue;
-                }
+                // set the beginning to the edge on the cut or on the boundary
+                beginH = currH;
 
-                // constParmMatrices contains all the members of the permutation group
-                MatrixXi nextPermMatrix = constParmMatrices[Halfedge2Matching(nextHalfedge) % intData.N];
-                //no update needed
-                if(isHEcut(nextHalfedge) == 0)
+                int currCutVertex = -1;
+                do
                 {
-                    currH = nextHalfedge;
-                    continue;
-                }
+                    int currFace = HF(currH); // face containing the half-edge
+                    int newCutVertex = -1;
+                    //find position of the vertex i in the face of the initial mesh
+                    for (int j = 0; j < 3; j++)
+                    {
+                        if (meshWhole.F(currFace, j) == i)
+                            newCutVertex = cutF(currFace, j);
+                    }
 
-                //otherwise, updating matrices with transition
-                int nextTransition = Halfedge2TransitionIndices(nextHalfedge);
-                //Pe*f + Je
-                if(nextTransition > 0)
-                {
-                    for(int j = 0; j < permMatrices.size(); j++)
-                        permMatrices[j] = nextPermMatrix * permMatrices[j];
+                    //currCorner gets the permutations so far
+                    if (newCutVertex != currCutVertex)
+                    {
+                        currCutVertex = newCutVertex;
+                        for(int i = 0; i < permIndices.size(); i++)
+                        {
+                            // place the perumtation matrix in a bigger matrix, we need to know how things are connected along the cut, no?
+                            for(int j = 0; j < intData.N; j++)
+                                for(int k = 0; k < intData.N; k++){
+                                    vertexTrans2CutTriplets.emplace_back(intData.N * currCutVertex + j, intData.N * permIndices[i] + k, (double) permMatrices[i](j, k));
+                                    vertexTrans2CutTripletsInteger.emplace_back(intData.N * currCutVertex + j, intData.N * permIndices[i] + k, permMatrices[i](j, k));
+                                }
+                        }
+                    }
 
-                    //and identity on the fresh transition
-                    permMatrices.push_back(MatrixXi::Identity(intData.N, intData.N));
-                    permIndices.push_back(meshWhole.V.rows() + nextTransition - 1);
-                }
-                    // (Pe*(f-Je))  matrix is already inverse since halfedge matching is minused
-                else
-                {
-                    //reverse order
-                    permMatrices.push_back(-MatrixXi::Identity(intData.N, intData.N));
-                    permIndices.push_back(meshWhole.V.rows() - nextTransition - 1);
+                    //updating the matrices for the next corner
+                    int nextHalfedge = twinH(prevH(currH));
+                    //reached a boundary
+                    if(nextHalfedge == -1)
+                    {
+                        currH = nextHalfedge;
+                        continue;
+                    }
 
-                    for(int j = 0; j < permMatrices.size(); j++)
-                        permMatrices[j] = nextPermMatrix * permMatrices[j];
-                }
-                currH = nextHalfedge;
-            } while((currH != beginH) && (currH != -1));
+                    // constParmMatrices contains all the members of the permutation group
+                    MatrixXi nextPermMatrix = constParmMatrices[Halfedge2Matching(nextHalfedge) % intData.N];
+                    //no update needed
+                    if(isHEcut(nextHalfedge) == 0)
+                    {
+                        currH = nextHalfedge;
+                        continue;
+                    }
 
-            //cleaning parmMatrices and permIndices to see if there is a constraint or reveal singularity-from-transition
-            std::set<int> cleanPermIndicesSet(permIndices.begin(), permIndices.end());
-            std::vector<int> cleanPermIndices(cleanPermIndicesSet.begin(), cleanPermIndicesSet.end());
-            std::vector<MatrixXi> cleanPermMatrices(cleanPermIndices.size());
+                    //otherwise, updating matrices with transition
+                    int nextTransition = Halfedge2TransitionIndices(nextHalfedge);
+                    //Pe*f + Je
+                    if(nextTransition > 0)
+                    {
+                        for(int j = 0; j < permMatrices.size(); j++)
+                            permMatrices[j] = nextPermMatrix * permMatrices[j];
 
-            for (int j = 0; j < cleanPermIndices.size(); j++)
-            {
-                cleanPermMatrices[j] = MatrixXi::Zero(intData.N, intData.N);
-                for(int k = 0;k < permIndices.size(); k++)
-                    if(cleanPermIndices[j] == permIndices[k])
-                        cleanPermMatrices[j] += permMatrices[k];
-                if(cleanPermIndices[j] == i)
-                    cleanPermMatrices[j] -= MatrixXi::Identity(intData.N, intData.N);
-            }
+                        //and identity on the fresh transition
+                        permMatrices.push_back(MatrixXi::Identity(intData.N, intData.N));
+                        permIndices.push_back(meshWhole.V.rows() + nextTransition - 1);
+                    }
+                        // (Pe*(f-Je))  matrix is already inverse since halfedge matching is minused
+                    else
+                    {
+                        //reverse order
+                        permMatrices.push_back(-MatrixXi::Identity(intData.N, intData.N));
+                        permIndices.push_back(meshWhole.V.rows() - nextTransition - 1);
 
-            //if not all matrices are zero, there is a constraint
-            bool isConstraint = false;
-            for(int j = 0; j < cleanPermMatrices.size(); j++)
-                if (cleanPermMatrices[j].cwiseAbs().maxCoeff() != 0)
-                    isConstraint = true;
+                        for(int j = 0; j < permMatrices.size(); j++)
+                            permMatrices[j] = nextPermMatrix * permMatrices[j];
+                    }
+                    currH = nextHalfedge;
+                } while((currH != beginH) && (currH != -1));
 
-            if((isConstraint) && (!isBoundary(i)))
-            {
+                //cleaning parmMatrices and permIndices to see if there is a constraint or reveal singularity-from-transition
+                std::set<int> cleanPermIndicesSet(permIndices.begin(), permIndices.end());
+                std::vector<int> cleanPermIndices(cleanPermIndicesSet.begin(), cleanPermIndicesSet.end());
+                std::vector<MatrixXi> cleanPermMatrices(cleanPermIndices.size());
+
+                for (int j = 0; j < cleanPermIndices.size(); j++)
+                {
+                    cleanPermMatrices[j] = MatrixXi::Zero(intData.N, intData.N);
+                    for(int k = 0;k < permIndices.size(); k++)
+                        if(cleanPermIndices[j] == permIndices[k])
+                            cleanPermMatrices[j] += permMatrices[k];
+                    if(cleanPermIndices[j] == i)
+                        cleanPermMatrices[j] -= MatrixXi::Identity(intData.N, intData.N);
+                }
+
+                //if not all matrices are zero, there is a constraint
+                bool isConstraint = false;
                 for(int j = 0; j < cleanPermMatrices.size(); j++)
+                    if (cleanPermMatrices[j].cwiseAbs().maxCoeff() != 0)
+                        isConstraint = true;
+
+                if((isConstraint) && (!isBoundary(i)))
                 {
-                    for(int k = 0; k < intData.N; k++)
-                        for(int l = 0; l < intData.N; l++){
-                            constTriplets.emplace_back(intData.N * currConst + k, intData.N * cleanPermIndices[j] + l, (double) cleanPermMatrices[j](k, l));
-                            constTripletsInteger.emplace_back(intData.N * currConst + k, intData.N * cleanPermIndices[j] + l, cleanPermMatrices[j](k, l));
-                        }
+                    for(int j = 0; j < cleanPermMatrices.size(); j++)
+                    {
+                        for(int k = 0; k < intData.N; k++)
+                            for(int l = 0; l < intData.N; l++){
+                                constTriplets.emplace_back(intData.N * currConst + k, intData.N * cleanPermIndices[j] + l, (double) cleanPermMatrices[j](k, l));
+                                constTripletsInteger.emplace_back(intData.N * currConst + k, intData.N * cleanPermIndices[j] + l, cleanPermMatrices[j](k, l));
+                            }
+                    }
+                    currConst++;
+                    cache.constrainedVertices(i) = 1;
                 }
-                currConst++;
-                intData.constrainedVertices(i) = 1;
             }
-        }
 
-        vector< Triplet< double > > cleanTriplets;
-        vector< Triplet< int > > cleanTripletsInteger;
-
-        intData.vertexTrans2CutMat.resize(intData.N * cutV.rows(), intData.N * (meshWhole.V.rows() + numTransitions));
-        intData.vertexTrans2CutMatInteger.resize(intData.N * cutV.rows(), intData.N * (meshWhole.V.rows() + numTransitions));
-        cleanTriplets.clear();
-        cleanTripletsInteger.clear();
-        for(int i = 0; i < vertexTrans2CutTriplets.size(); i++){
-            if(vertexTrans2CutTripletsInteger[i].value() != 0){
-                cleanTripletsInteger.push_back(vertexTrans2CutTripletsInteger[i]);
-                cleanTriplets.push_back(vertexTrans2CutTriplets[i]);
+            vector< Triplet< double > > cleanTriplets;
+            vector< Triplet< int > > cleanTripletsInteger;
+
+            cache.vertexTrans2CutMat.resize(intData.N * cache.meshCut.V.rows(), intData.N * (meshWhole.V.rows() + numTransitions));
+            cache.vertexTrans2CutMatInteger.resize(intData.N * cache.meshCut.V.rows(), intData.N * (meshWhole.V.rows() + numTransitions));
+            cleanTriplets.clear();
+            cleanTripletsInteger.clear();
+            for(int i = 0; i < vertexTrans2CutTriplets.size(); i++){
+                if(vertexTrans2CutTripletsInteger[i].value() != 0){
+                    cleanTripletsInteger.push_back(vertexTrans2CutTripletsInteger[i]);
+                    cleanTriplets.push_back(vertexTrans2CutTriplets[i]);
+                }
+                // if(std::abs((float)vertexTrans2CutTriplets[i].value())>10e-7)
             }
-            // if(std::abs((float)vertexTrans2CutTriplets[i].value())>10e-7)
-        }
-        intData.vertexTrans2CutMat.setFromTriplets(cleanTriplets.begin(), cleanTriplets.end());
-        intData.vertexTrans2CutMatInteger.setFromTriplets(cleanTripletsInteger.begin(), cleanTripletsInteger.end());
-
-        //
-
-        intData.constraintMat.resize(intData.N * currConst, intData.N * (meshWhole.V.rows() + numTransitions));
-        intData.constraintMatInteger.resize(intData.N * currConst, intData.N * (meshWhole.V.rows() + numTransitions));
-        cleanTriplets.clear();
-        cleanTripletsInteger.clear();
-        for(int i = 0; i < constTriplets.size(); i++){
-            if(constTripletsInteger[i].value() != 0){
-                cleanTripletsInteger.push_back(constTripletsInteger[i]);
-                cleanTriplets.push_back(constTriplets[i]);
+            cache.vertexTrans2CutMat.setFromTriplets(cleanTriplets.begin(), cleanTriplets.end());
+            cache.vertexTrans2CutMatInteger.setFromTriplets(cleanTripletsInteger.begin(), cleanTripletsInteger.end());
+
+            //
+
+            cache.constraintMat.resize(intData.N * currConst, intData.N * (meshWhole.V.rows() + numTransitions));
+            cache.constraintMatInteger.resize(intData.N * currConst, intData.N * (meshWhole.V.rows() + numTransitions));
+            cleanTriplets.clear();
+            cleanTripletsInteger.clear();
+            for(int i = 0; i < constTriplets.size(); i++){
+                if(constTripletsInteger[i].value() != 0){
+                    cleanTripletsInteger.push_back(constTripletsInteger[i]);
+                    cleanTriplets.push_back(constTriplets[i]);
+                }
             }
+            cache.constraintMat.setFromTriplets(cleanTriplets.begin(), cleanTriplets.end());
+            cache.constraintMatInteger.setFromTriplets(cleanTripletsInteger.begin(), cleanTripletsInteger.end());
+
+            cache.N = intData.N;
+        }
+
+        cache.mesh = &meshWhole;
+        if (meshChanged){
+            cache.V = meshWhole.V;
+            cache.F = meshWhole.F;
+            cache.EV = meshWhole.EV;
         }
-        intData.constraintMat.setFromTriplets(cleanTriplets.begin(), cleanTriplets.end());
-        intData.constraintMatInteger.setFromTriplets(cleanTripletsInteger.begin(), cleanTripletsInteger.end());
+        cache.singLocalCycles = field.singLocalCycles;
+
+        intData.face2cut = cache.face2cut;
+        intData.constrainedVertices = cache.constrainedVertices;
+        //Reduction layer: always rebuilt, as it depends on linRed and periodMat. The layers are local, and only their composition with the seam layer is kept.
+        SparseMatrix<double> intSpanMat, linRedMat, singIntSpanMat;
+        SparseMatrix<int> intSpanMatInteger, linRedMatInteger, singIntSpanMatInteger;
 
         //doing the integer spanning matrix
-        intData.intSpanMat.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
-        intData.intSpanMatInteger.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        intSpanMat.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        intSpanMatInteger.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
         vector<Triplet<double> > intSpanMatTriplets;
         vector<Triplet<int> > intSpanMatTripletsInteger;
         for (int i=0;i<intData.n*numTransitions;i+=intData.n){
@@ -534,13 +658,13 @@ namespace directional
             intSpanMatTripletsInteger.emplace_back(i,i,1);
         }
 
-        intData.intSpanMat.setFromTriplets(intSpanMatTriplets.begin(), intSpanMatTriplets.end());
-        intData.intSpanMatInteger.setFromTriplets(intSpanMatTripletsInteger.begin(), intSpanMatTripletsInteger.end());
+        intSpanMat.setFromTriplets(intSpanMatTriplets.begin(), intSpanMatTriplets.end());
+        intSpanMatInteger.setFromTriplets(intSpanMatTripletsInteger.begin(), intSpanMatTripletsInteger.end());
 
         //filtering out barycentric symmetry, including sign symmetry. The parameterization should always only include n dof for the surface
         //TODO: this assumes n divides N!
-        intData.linRedMat.resize(intData.N * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
-        intData.linRedMatInteger.resize(intData.N * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        linRedMat.resize(intData.N * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        linRedMatInteger.resize(intData.N * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
         vector<Triplet<double> > linRedMatTriplets;
         vector<Triplet<int> > linRedMatTripletsInteger;
         for(int i = 0; i < intData.N*(meshWhole.V.rows() + numTransitions); i +=intData.N)
@@ -552,8 +676,8 @@ namespace directional
                     }
                 }
 
-        intData.linRedMat.setFromTriplets(linRedMatTriplets.begin(), linRedMatTriplets.end());
-        intData.linRedMatInteger.setFromTriplets(linRedMatTripletsInteger.begin(), linRedMatTripletsInteger.end());
+        linRedMat.setFromTriplets(linRedMatTriplets.begin(), linRedMatTriplets.end());
+        linRedMatInteger.setFromTriplets(linRedMatTripletsInteger.begin(), linRedMatTripletsInteger.end());
 
         //integer variables are per single "d" packet, and the rounding is done for the N functions with projection over linRed
         intData.integerVars.resize(numTransitions);
@@ -586,8 +710,8 @@ namespace directional
         }
 
         //doing the integer spanning matrix
-        intData.singIntSpanMat.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
-        intData.singIntSpanMatInteger.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        singIntSpanMat.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
+        singIntSpanMatInteger.resize(intData.n * (meshWhole.V.rows() + numTransitions), intData.n * (meshWhole.V.rows() + numTransitions));
         vector<Triplet<double> > singIntSpanMatTriplets;
         vector<Triplet<int> > singIntSpanMatTripletsInteger;
         for (int i=0;i<isSingular.size();i++){
@@ -612,15 +736,33 @@ namespace directional
             singIntSpanMatTripletsInteger.emplace_back(i,i,1);
         }
 
-        intData.singIntSpanMat.setFromTriplets(singIntSpanMatTriplets.begin(), singIntSpanMatTriplets.end());
-        intData.singIntSpanMatInteger.setFromTriplets(singIntSpanMatTripletsInteger.begin(), singIntSpanMatTripletsInteger.end());
+        singIntSpanMat.setFromTriplets(singIntSpanMatTriplets.begin(), singIntSpanMatTriplets.end());
+        singIntSpanMatInteger.setFromTriplets(singIntSpanMatTripletsInteger.begin(), singIntSpanMatTripletsInteger.end());
 
         intData.singularIndices=singularIndices;
         intData.fixedValues.resize(intData.n);
         intData.fixedValues.setConstant(0);
 
-        meshCut.set_mesh(cutV, cutF);
+        {
+            directional::ScopedTimer composeTimer(report, "setup_integration.compose_operators");
+            IntegrationData::compose_operators(cache.vertexTrans2CutMat, cache.constraintMat, linRedMat, singIntSpanMat, intSpanMat, intData.x2CutMat, intData.x2ConstraintMat);
+            IntegrationData::compose_operators(cache.vertexTrans2CutMatInteger, cache.constraintMatInteger, linRedMatInteger, singIntSpanMatInteger, intSpanMatInteger, intData.x2CutMatInteger, intData.x2ConstraintMatInteger);
+        }
+
+        meshCut = cache.meshCut;
+        combedField = cache.combedField;
+    }
+
 
+    // Setting up the seamless integration algorithm without reusing any previous computation. See above.
+    IGL_INLINE void setup_integration(const directional::CartesianField& field,
+                                      IntegrationData& intData,
+                                      directional::TriMesh& meshCut,
+                                      directional::CartesianField& combedField,
+                                      directional::ProfileReport* report=NULL)
+    {
+        IntegrationSetupCache cache;
+        setup_integration(field, intData, meshCut, combedField, cache, report);
     }
 }
 
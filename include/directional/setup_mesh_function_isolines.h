@@ -55,8 +55,8 @@ namespace directional{
         mfiData.cutF=meshCut.F;
         mfiData.vertexNFunction = intData.nVertexFunction;
         bool signSymmetry=(intData.N%2==0);
-        Eigen::SparseMatrix<double> orig2CutMatFull=intData.vertexTrans2CutMat*intData.linRedMat*intData.singIntSpanMat*intData.intSpanMat;
-        Eigen::SparseMatrix<int> exactOrig2CutMatFull=intData.vertexTrans2CutMatInteger*intData.linRedMatInteger*intData.singIntSpanMatInteger*intData.intSpanMatInteger;
+        const Eigen::SparseMatrix<double>& orig2CutMatFull=intData.x2CutMat;
+        const Eigen::SparseMatrix<int>& exactOrig2CutMatFull=intData.x2CutMatInteger;
 
         //cuttting the matrices from sign symmetrry
         if (signSymmetry){
@@ -16,6 +16,36 @@
 namespace directional
 {
 
+    // The centers, normals and colors of the singularity spheres (see singularity_spheres())
+    void IGL_INLINE singularity_sphere_points(const Eigen::MatrixXd& sources,
+                                              const Eigen::MatrixXd& normals,
+                                              const Eigen::VectorXi& singElements,
+                                              const Eigen::VectorXi& singIndices,
+                                              const Eigen::MatrixXd& singularityColors,
+                                              Eigen::MatrixXd& points,
+                                              Eigen::MatrixXd& pointNormals,
+                                              Eigen::MatrixXd& colors)
+    {
+        points.resize(singElements.size(), 3);
+        pointNormals.resize(singElements.size(), 3);
+        colors.resize(singElements.size(), 3);
+        Eigen::MatrixXd positiveColors=singularityColors.block(singularityColors.rows()/2,0,singularityColors.rows()/2,3);
+        Eigen::MatrixXd negativeColors=singularityColors.block(0,0,singularityColors.rows()/2,3);
+
+        for (int i = 0; i < singIndices.rows(); i++)
+        {
+            points.row(i) = sources.row(singElements(i));
+            pointNormals.row(i) =normals.row(singElements(i));
+            if (singIndices(i) > 0)
+                colors.row(i) = positiveColors.row((singIndices(i)-1 > positiveColors.rows()-1 ? positiveColors.rows()-1  : singIndices(i)-1) );
+            else if (singIndices(i)<0)
+                colors.row(i) = negativeColors.row((negativeColors.rows()+singIndices(i) > 0 ? negativeColors.rows()+singIndices(i) : 0));
+            else
+                colors.row(i).setZero(); //this shouldn't have been input
+
+        }
+    }
+
     // Returns a list of faces, vertices and color values that can be used to draw singularities for non-zero index values.
     // Input:
     //    sources:        #s X 3 point coordinates of the location of the elements
@@ -43,28 +73,30 @@ namespace directional
 
     {
 
-        Eigen::MatrixXd points(singElements.size(), 3);
-        Eigen::MatrixXd pointNormals(singElements.size(), 3);
-        Eigen::MatrixXd colors(singElements.size(), 3);
-        Eigen::MatrixXd positiveColors=singularityColors.block(singularityColors.rows()/2,0,singularityColors.rows()/2,3);
-        Eigen::MatrixXd negativeColors=singularityColors.block(0,0,singularityColors.rows()/2,3);
-
-        for (int i = 0; i < singIndices.rows(); i++)
-        {
-            points.row(i) = sources.row(singElements(i));
-            pointNormals.row(i) =normals.row(singElements(i));
-            if (singIndices(i) > 0)
-                colors.row(i) = positiveColors.row((singIndices(i)-1 > positiveColors.rows()-1 ? positiveColors.rows()-1  : singIndices(i)-1) );
-            else if (singIndices(i)<0)
-                colors.row(i) = negativeColors.row((negativeColors.rows()+singIndices(i) > 0 ? negativeColors.rows()+singIndices(i) : 0));
-            else
-                colors.row(i).setZero(); //this shouldn't have been input
-
-        }
+        Eigen::MatrixXd points, pointNormals, colors;
+        singularity_sphere_points(sources, normals, singElements, singIndices, singularityColors, points, pointNormals, colors);
         double radius = radiusRatio*avgScale/5.0;
         directional::point_spheres(points, pointNormals, radius, colors, 8, singV, singF, singC);
 
     }
+
+    // The same singularity spheres as an instanced representation (see point_spheres_instances()).
+    void IGL_INLINE singularity_spheres_instances(const Eigen::MatrixXd& sources,
+                                                  const Eigen::MatrixXd& normals,
+                                                  const int N,
+                                                  const double avgScale,
+                                                  const Eigen::VectorXi& singElements,
+                                                  const Eigen::VectorXi& singIndices,
+                                                  const Eigen::MatrixXd singularityColors,
+                                                  directional::MeshInstances& instances,
+                                                  const double radiusRatio)
+
+    {
+        Eigen::MatrixXd points, pointNormals, colors;
+        singularity_sphere_points(sources, normals, singElements, singIndices, singularityColors, points, pointNormals, colors);
+        double radius = radiusRatio*avgScale/5.0;
+        directional::point_spheres_instances(points, pointNormals, radius, colors, 8, instances);
+    }
 }
 
 #endif
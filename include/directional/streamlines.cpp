@@ -10,6 +10,7 @@
 #include <iomanip>
 #include <map>
 #include <random>
+#include <algorithm>
 #include <Eigen/Geometry>
 #include <igl/edge_topology.h>
 #include <igl/sort_vectors_ccw.h>
@@ -19,6 +20,7 @@
 #include <igl/slice.h>
 #include <igl/speye.h>
 #include <igl/avg_edge_length.h>
+#include <igl/parallel_for.h>
 #include <directional/TriMesh.h>
 #include <directional/principal_matching.h>
 #include <directional/streamlines.h>
@@ -175,11 +177,108 @@ namespace Directional {
 }
 
 
+namespace Directional {
+    //Finds where the streamline that starts at p inside face f0 with direction m0 exits the face: after time t, into face f1 (-1 across the boundary), with matched direction m1.
+    //Uses the exit tables if they are precomputed, and otherwise intersects the ray with the edges of the face.
+    IGL_INLINE bool streamline_exit(const directional::StreamlineData& data,
+                                    const int f0,
+                                    const int m0,
+                                    const Eigen::RowVector3d& p,
+                                    double& t,
+                                    int& f1,
+                                    int& m1)
+    {
+        if (data.exitInvSpeeds.rows()!=0){
+            //the exit edge is the first one that the ray crosses outwards
+            int exitEdge=-1;
+            for (int k=0;k<3;k++){
+                double invSpeed=data.exitInvSpeeds(f0,3*m0+k);
+                if (invSpeed==0.0)
+                    continue;
+                double currT=(data.edgeOffsets(f0,k)-data.edgeNormals.block<1,3>(f0,3*k).dot(p))*invSpeed;
+                if ((exitEdge==-1)||(currT<t)){
+                    t=currT;
+                    exitEdge=k;
+                }
+            }
+            //as with the intersection below, the exit must be within a single step along the vector
+            if ((exitEdge==-1)||(t>1.0))
+                return false;
+            t=std::max(t,0.0);
+            f1=data.slMesh->TT(f0,exitEdge);
+            m1=data.exitDirections(f0,3*m0+exitEdge);
+            return true;
+        }
+
+        Eigen::RowVector3d vec = data.slField.block(f0, 3*m0, 1,3);
+        for (int k = 0; k < 3; ++k) {
+            // edge vertices
+            const Eigen::RowVector3d &q = data.slMesh->V.row(data.slMesh->F(f0, k));
+            const Eigen::RowVector3d &qs = data.slMesh->V.row(data.slMesh->F(f0, (k + 1) % 3));
+            // edge direction
+            Eigen::RowVector3d s = qs - q;
+
+            double u;
+            if (igl::segment_segment_intersect(p, vec, q, s, t, u, -1e-6)) {
+                f1 = data.slMesh->TT(f0, k);
+
+                // matching direction on next face
+                int e1 = data.slMesh->FE(f0, k);
+                if (data.slMesh->EF(e1, 0) == f0)
+                    m1 = (data.field.matching(e1) + m0) % data.field.N;
+                else
+                    m1 = (-data.field.matching(e1) + m0 + data.field.N) % data.field.N;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Marks the slot of a segment as changed, listing every slot at most once
+    IGL_INLINE void mark_streamline_segment(directional::StreamlineState& state, const int slot)
+    {
+        if (state.isSegmentChanged(slot))
+            return;
+        state.isSegmentChanged(slot)=true;
+        state.changedSegments.push_back(slot);
+    }
+
+    //Adds a new (empty) segment to the ring buffer of traced segments, retiring the oldest segment if the buffer is full. Returns the slot of the segment.
+    IGL_INLINE int add_streamline_segment(directional::StreamlineState& state,
+                                          const Eigen::RowVector3d& start,
+                                          const Eigen::RowVector3d& normal,
+                                          const int origFace,
+                                          const int origVector,
+                                          const double timeSignature,
+                                          const int streamline)
+    {
+        int slot=state.segHead;
+        if (state.segCount==state.segCapacity){
+            //the retired segment might still be extended by its streamline
+            if (state.currSegmentIndex(state.segStreamline[slot])==slot)
+                state.currSegmentIndex(state.segStreamline[slot])=-1;
+        } else state.segCount++;
+
+        state.segStart[slot]=start;
+        state.segEnd[slot]=start;
+        state.segNormal[slot]=normal;
+        state.segOrigFace[slot]=origFace;
+        state.segOrigVector[slot]=origVector;
+        state.segTimeSignatures[slot]=timeSignature;
+        state.segStreamline[slot]=streamline;
+        state.segHead=(slot+1)%state.segCapacity;
+        mark_streamline_segment(state, slot);
+        return slot;
+    }
+}
+
+
 IGL_INLINE void directional::streamlines_init(const directional::CartesianField& field,
                                               const Eigen::VectorXi& seedFaces,
                                               const double distRatio,
                                               StreamlineData &data,
-                                              StreamlineState &state){
+                                              StreamlineState &state,
+                                              const int maxSegments){
     using namespace Eigen;
     using namespace std;
 
@@ -219,6 +318,12 @@ IGL_INLINE void directional::streamlines_init(const directional::CartesianField&
 
     directional::principal_matching(data.field);
 
+    //the exit tables of a previous field are invalid
+    data.edgeNormals.resize(0,0);
+    data.edgeOffsets.resize(0,0);
+    data.exitInvSpeeds.resize(0,0);
+    data.exitDirections.resize(0,0);
+
     // create seeds for tracing
     // --------------------------
 
@@ -251,7 +356,23 @@ IGL_INLINE void directional::streamlines_init(const directional::CartesianField&
         }
     }
     state.currTimes.setZero(field.N*data.sampleFaces.size());
-    state.currSegmentIndex.setZero(field.N*data.sampleFaces.size());
+    state.currSegmentIndex.setConstant(field.N*data.sampleFaces.size(),-1);
+
+    state.currTime = 0.0;
+
+    //allocating the ring buffer of traced segments
+    state.segCapacity = (maxSegments>0 ? maxSegments : 100*field.N*data.sampleFaces.size());
+    state.segCapacity = std::max(state.segCapacity, 1);
+    state.segHead = state.segCount = 0;
+    state.segStart.resize(state.segCapacity);
+    state.segEnd.resize(state.segCapacity);
+    state.segNormal.resize(state.segCapacity);
+    state.segOrigFace.resize(state.segCapacity);
+    state.segOrigVector.resize(state.segCapacity);
+    state.segTimeSignatures.resize(state.segCapacity);
+    state.segStreamline.resize(state.segCapacity);
+    state.changedSegments.clear();
+    state.isSegmentChanged.setConstant(state.segCapacity, false);
 
     //initializing "next" values
     state.nextElements.setConstant(state.currElements.size(),-1);
@@ -267,53 +388,18 @@ IGL_INLINE void directional::streamlines_init(const directional::CartesianField&
             RowVector3d p=state.currStartPoints.row(currIndex);
             RowVector3d vec = data.slField.block(f0, 3*m0, 1,3);
             int f1, m1;
-            bool foundIntersection = false;
-            //cout<<"currIndex: "<<currIndex<<endl;
-            for (int k = 0; k < 3; ++k) {
-                f1 = data.slMesh->TT(state.currElements(currIndex), k);
-                //cout<<"f1: "<<f1<<endl;
-                /*if (f1==-1)
-                    continue;  //boundary*/
-
-                // edge vertices
-                const Eigen::RowVector3d &q = data.slMesh->V.row(data.slMesh->F(f0, k));
-                const Eigen::RowVector3d &qs = data.slMesh->V.row(data.slMesh->F(f0, (k + 1) % 3));
-                // edge direction
-                Eigen::RowVector3d s = qs - q;
-
-                double u;
-                double t;
-                if (igl::segment_segment_intersect(p, vec, q, s, t, u, -1e-6)) {
-                    foundIntersection = true;
-                    //cout<<"Found intersection "<<endl;
-                    state.nextElements(currIndex) = f1;
-                    state.nextTimes(currIndex) = state.currTime + t;
-                    state.nextStartPoints.row(currIndex) = p + t * vec;
-
-                    // matching direction on next face
-                    int e1 = data.slMesh->FE(f0, k);
-                    if (data.slMesh->EF(e1, 0) == f0)
-                        m1 = (data.field.matching(e1) + m0) % data.field.N;
-                    else
-                        m1 = (-data.field.matching(e1) + m0 + data.field.N) % data.field.N;
-
-                    state.nextDirectionIndex(currIndex) = m1;
-                    break;
-                }
-            }
-            if (!foundIntersection) {  //something went bad
+            double t;
+            if (!Directional::streamline_exit(data, f0, m0, p, t, f1, m1)) {  //something went bad
                 state.segmentAlive(currIndex) = false;
                 continue;
             }
+            state.nextElements(currIndex) = f1;
+            state.nextTimes(currIndex) = state.currTime + t;
+            state.nextStartPoints.row(currIndex) = p + t * vec;
+            state.nextDirectionIndex(currIndex) = m1;
 
             //creating new traced segment for the new face
-            state.segStart.push_back(state.currStartPoints.row(currIndex));
-            state.segEnd.push_back(state.currStartPoints.row(currIndex));
-            state.segNormal.push_back(data.slMesh->faceNormals.row(state.currElements(currIndex)));
-            state.segOrigFace.push_back(state.currElements(currIndex));
-            state.segOrigVector.push_back(j);
-            state.segTimeSignatures.push_back(0.0);
-            state.currSegmentIndex(currIndex)=state.segStart.size()-1;
+            state.currSegmentIndex(currIndex)=Directional::add_streamline_segment(state, state.currStartPoints.row(currIndex), data.slMesh->faceNormals.row(state.currElements(currIndex)), state.currElements(currIndex), j, 0.0, currIndex);
 
         }
 
@@ -331,6 +417,18 @@ IGL_INLINE void directional::streamlines_init(const directional::CartesianField&
 
 }
 
+IGL_INLINE void directional::streamlines_init(const directional::FloatCartesianField& field,
+                                              const Eigen::VectorXi& seedFaces,
+                                              const double distRatio,
+                                              StreamlineData &data,
+                                              StreamlineState &state,
+                                              const int maxSegments){
+    directional::CartesianField doubleField;
+    field.get_field(doubleField);
+    streamlines_init(doubleField, seedFaces, distRatio, data, state, maxSegments);
+}
+
+
 IGL_INLINE void directional::streamlines_next(const StreamlineData & data,
                                               StreamlineState & state,
                                               const double dTime){
@@ -343,6 +441,11 @@ IGL_INLINE void directional::streamlines_next(const StreamlineData & data,
 
     //IntrinsicFaceTangentBundle* ftb = (IntrinsicFaceTangentBundle*)data.field.tb;  //maye not efficient since virtual lookup, or negligible?
 
+    //only the segments changed by this step are listed
+    for (int i=0;i<state.changedSegments.size();i++)
+        state.isSegmentChanged(state.changedSegments[i])=false;
+    state.changedSegments.clear();
+
 
     //Going through all ongoing streamlines. Those where the currTime+dTime < nextTime only extend their segment. Otherwise tracing forward through triangles until this happens
     for (int i = 0; i < data.field.N; ++i) {
@@ -378,14 +481,20 @@ IGL_INLINE void directional::streamlines_next(const StreamlineData & data,
                     double timeDiffFromStart =
                             state.currTime + dTime - state.currTimes(currIndex);
 
-                    state.segEnd[state.currSegmentIndex(currIndex)]=state.segStart[state.currSegmentIndex(currIndex)]+timeDiffFromStart*vec;
+                    if (state.currSegmentIndex(currIndex)>=0){
+                        state.segEnd[state.currSegmentIndex(currIndex)]=state.segStart[state.currSegmentIndex(currIndex)]+timeDiffFromStart*vec;
+                        Directional::mark_streamline_segment(state, state.currSegmentIndex(currIndex));
+                    }
                     //cout<<"Stopping mid-face"<<endl;
                     //cout<<"Segment "<<state.currSegmentIndex(currIndex)<<" is ("<<state.segStart[state.currSegmentIndex(currIndex)]<<")->("<<state.segEnd[state.currSegmentIndex(currIndex)]<<")"<<endl;
                     break;
                 } else {//trace forward
                     //finishing previous segment
                     //cout << "Tracing forward" << endl;
-                    state.segEnd[state.currSegmentIndex(currIndex)] = state.nextStartPoints.row(currIndex);
+                    if (state.currSegmentIndex(currIndex)>=0){
+                        state.segEnd[state.currSegmentIndex(currIndex)] = state.nextStartPoints.row(currIndex);
+                        Directional::mark_streamline_segment(state, state.currSegmentIndex(currIndex));
+                    }
                     //cout << "Fully traced segment " << state.currSegmentIndex(currIndex) << " is ("<< state.segStart[state.currSegmentIndex(currIndex)] << ")->("<< state.segEnd[state.currSegmentIndex(currIndex)] << ")" << endl;
 
                     //advancing to next face
@@ -404,51 +513,19 @@ IGL_INLINE void directional::streamlines_next(const StreamlineData & data,
                     p = state.currStartPoints.row(currIndex);
                     //Updating the next element
                     int f1, m1;
-                    bool foundIntersection = false;
-                    for (int k = 0; k < 3; ++k) {
-                        f1 = data.slMesh->TT(state.currElements(currIndex), k);
-                        /*if (f1==-1)
-                            continue;*/
-
-                        // edge vertices
-                        const Eigen::RowVector3d &q = data.slMesh->V.row(data.slMesh->F(f0, k));
-                        const Eigen::RowVector3d &qs = data.slMesh->V.row(data.slMesh->F(f0, (k + 1) % 3));
-                        // edge direction
-                        Eigen::RowVector3d s = qs - q;
-
-                        double u;
-                        double t;
-                        if (igl::segment_segment_intersect(p, vec, q, s, t, u, -1e-6)) {
-                            foundIntersection = true;
-                            state.nextElements(currIndex) = f1;
-                            //cout<<"Found intersection after: "<<t<<endl;
-                            state.nextTimes(currIndex) = state.currTimes(currIndex) + t;
-                            state.nextStartPoints.row(currIndex) = p + t * vec;
-
-                            // matching direction on next face
-                            int e1 = data.slMesh->FE(f0, k);
-                            if (data.slMesh->EF(e1, 0) == f0)
-                                m1 = (data.field.matching(e1) + m0) % data.field.N;
-                            else
-                                m1 = (-data.field.matching(e1) + m0 + data.field.N) % data.field.N;
-
-                            state.nextDirectionIndex(currIndex) = m1;
-                            break;
-                        }
-                    }
-                    if (!foundIntersection) {  //something went bad, we couldn't find the next face
+                    double t;
+                    if (!Directional::streamline_exit(data, f0, m0, p, t, f1, m1)) {  //something went bad, we couldn't find the next face
                          state.segmentAlive(currIndex) = false;
                          break;
                     }
+                    state.nextElements(currIndex) = f1;
+                    //cout<<"Found intersection after: "<<t<<endl;
+                    state.nextTimes(currIndex) = state.currTimes(currIndex) + t;
+                    state.nextStartPoints.row(currIndex) = p + t * vec;
+                    state.nextDirectionIndex(currIndex) = m1;
 
                     //creating new traced segment for the new face
-                    state.segStart.push_back(state.currStartPoints.row(currIndex));
-                    state.segEnd.push_back(state.currStartPoints.row(currIndex));
-                    state.segNormal.push_back(data.slMesh->faceNormals.row(state.currElements(currIndex)));
-                    state.segOrigFace.push_back(state.currElements(currIndex));
-                    state.segOrigVector.push_back(i);
-                    state.segTimeSignatures.push_back(state.currTimes(currIndex));
-                    state.currSegmentIndex(currIndex)=state.segStart.size()-1;
+                    state.currSegmentIndex(currIndex)=Directional::add_streamline_segment(state, state.currStartPoints.row(currIndex), data.slMesh->faceNormals.row(state.currElements(currIndex)), state.currElements(currIndex), i, state.currTimes(currIndex), currIndex);
                 }
             }while(keepTracing);
         }
@@ -457,3 +534,101 @@ IGL_INLINE void directional::streamlines_next(const StreamlineData & data,
 
 }
 
+
+IGL_INLINE void directional::streamlines_precompute_exits(StreamlineData &data)
+{
+    using namespace Eigen;
+
+    const TriMesh& mesh=*(data.slMesh);
+    int N=data.field.N;
+    data.edgeNormals.resize(mesh.F.rows(),9);
+    data.edgeOffsets.resize(mesh.F.rows(),3);
+    data.exitInvSpeeds.resize(mesh.F.rows(),3*N);
+    data.exitDirections.resize(mesh.F.rows(),3*N);
+
+    igl::parallel_for(mesh.F.rows(), [&](const int f){
+        RowVector3d faceNormal=mesh.faceNormals.row(f);
+        for (int k=0;k<3;k++){
+            //outward in-plane normal of the edge (k,k+1)
+            RowVector3d q=mesh.V.row(mesh.F(f,k));
+            RowVector3d s=mesh.V.row(mesh.F(f,(k+1)%3))-q;
+            RowVector3d edgeNormal=s.cross(faceNormal);
+            data.edgeNormals.block(f,3*k,1,3)=edgeNormal;
+            data.edgeOffsets(f,k)=edgeNormal.dot(q);
+
+            int e=mesh.FE(f,k);
+            for (int m=0;m<N;m++){
+                RowVector3d vec=data.slField.block(f,3*m,1,3);
+                double speed=edgeNormal.dot(vec);
+                data.exitInvSpeeds(f,3*m+k)=(speed>10e-10*edgeNormal.norm()*vec.norm() ? 1.0/speed : 0.0);
+                if (mesh.TT(f,k)==-1)
+                    data.exitDirections(f,3*m+k)=-1;
+                else if (mesh.EF(e,0)==f)
+                    data.exitDirections(f,3*m+k)=(data.field.matching(e)+m)%N;
+                else
+                    data.exitDirections(f,3*m+k)=(-data.field.matching(e)+m+N)%N;
+            }
+        }
+    }, 1000);
+}
+
+
+IGL_INLINE void directional::streamlines_trace(const StreamlineData &data,
+                                               const double maxTime,
+                                               const int maxSegments,
+                                               Eigen::MatrixXd& P1,
+                                               Eigen::MatrixXd& P2,
+                                               Eigen::VectorXi& segStreamlines,
+                                               Eigen::VectorXi& segFaces)
+{
+    using namespace Eigen;
+
+    int numSeeds=data.sampleFaces.size();
+    int numStreamlines=data.field.N*numSeeds;
+    std::vector<std::vector<RowVector3d>> traceStarts(numStreamlines), traceEnds(numStreamlines);
+    std::vector<std::vector<int>> traceFaces(numStreamlines);
+
+    //streamlines are independent
+    igl::parallel_for(numStreamlines, [&](const int currIndex){
+        int f0=data.sampleFaces(currIndex%numSeeds);
+        int m0=currIndex/numSeeds;
+        RowVector3d p=data.samplePoints.row(currIndex%numSeeds);
+        double currTime=0.0;
+        while ((currTime<maxTime)&&((int)traceStarts[currIndex].size()<maxSegments)){
+            RowVector3d vec = data.slField.block(f0, 3*m0, 1,3);
+            if (vec.squaredNorm() < 10e-8)  //stuck in a local minimum
+                break;
+            double t;
+            int f1, m1;
+            if (!Directional::streamline_exit(data, f0, m0, p, t, f1, m1))
+                break;
+            t=std::min(t, maxTime-currTime);
+            traceStarts[currIndex].push_back(p);
+            traceEnds[currIndex].push_back(p+t*vec);
+            traceFaces[currIndex].push_back(f0);
+            currTime+=t;
+            if (f1<0)
+                break;
+            p+=t*vec;
+            f0=f1;
+            m0=m1;
+        }
+    }, 100);
+
+    int numSegments=0;
+    for (int i=0;i<numStreamlines;i++)
+        numSegments+=traceStarts[i].size();
+    P1.resize(numSegments,3);
+    P2.resize(numSegments,3);
+    segStreamlines.resize(numSegments);
+    segFaces.resize(numSegments);
+    int currSegment=0;
+    for (int i=0;i<numStreamlines;i++)
+        for (int j=0;j<(int)traceStarts[i].size();j++){
+            P1.row(currSegment)=traceStarts[i][j];
+            P2.row(currSegment)=traceEnds[i][j];
+            segStreamlines(currSegment)=i;
+            segFaces(currSegment)=traceFaces[i][j];
+            currSegment++;
+        }
+}
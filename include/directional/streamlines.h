@@ -36,6 +36,12 @@ namespace directional
     // Eigen::MatrixXi match_ba;   //  #E by N matrix, describing the inverse relation to match_ab
     Eigen::VectorXi sampleFaces;    //all original faces
     Eigen::MatrixXd samplePoints;  //3d point that must lie on the respective faces
+
+    //optional exit tables for fast tracing, filled by streamlines_precompute_exits() (empty otherwise)
+    Eigen::MatrixXd edgeNormals;     //#F by 9 outward in-plane (unnormalized) normals to edges (k,k+1) of each face
+    Eigen::MatrixXd edgeOffsets;     //#F by 3 the dot product of each edge normal with its source vertex
+    Eigen::MatrixXd exitInvSpeeds;   //#F by 3N: 1/(edgeNormal.dot(vector)) of vector m through edge k in column 3*m+k, or 0 if the vector does not exit through it
+    Eigen::MatrixXi exitDirections;  //#F by 3N: the matched direction of vector m in the face across edge k (-1 across the boundary)
   };
   
   struct StreamlineState
@@ -60,9 +66,17 @@ namespace directional
     //current time (live segments are such that beginTimes <= currTime < endTime
     double currTime;
 
+    //traced segments, kept in a ring buffer of fixed capacity: when it is full, every new segment retires the oldest one.
+    //the used slots are 0...segCount-1.
     std::vector<Eigen::RowVector3d> segStart, segEnd, segNormal;            //traced segments features
     std::vector<int> segOrigFace, segOrigVector;                   //original vectors and faces
     std::vector<double> segTimeSignatures;  //the time of the beginning of the segment
+    std::vector<int> segStreamline;         //the streamline (index into the curr/next arrays) that traced the segment
+    int segCapacity;                        //number of slots in the ring buffer
+    int segHead;                            //the slot of the next new segment
+    int segCount;                           //number of used slots
+    std::vector<int> changedSegments;       //slots that were created or extended by the last streamlines_next() (each slot once)
+    Eigen::Matrix<bool,Eigen::Dynamic, 1> isSegmentChanged;  //segCapacity flags of the slots in changedSegments
 
   };
   
@@ -73,6 +87,7 @@ namespace directional
   //   field            Cartesian field to be traced.
   //   seedLocations    indices into F of the seeds for streaming. Can be Eigen::VectorXi() for automatic generation.
   //   ringDistance     Samples are generated automatically in case seedLocations.size()=0 according to exclusion of two seeds < ringDistance faces apart.
+  //   maxSegments      capacity of the traced segments buffer, beyond which the oldest segments are retired. 0 sets 100 segments per streamline.
   // Output:
   //   data          struct containing topology information of the mesh and field
   //   state         struct containing the state of the tracing
@@ -80,15 +95,51 @@ namespace directional
                                    const Eigen::VectorXi& seedLocations,
                                    const double distRatio,
                                    StreamlineData &data,
-                                   StreamlineState &state);
+                                   StreamlineState &state,
+                                   const int maxSegments=0);
 
 
-  // The function computes the next state for each point in the sample
+  // The same for a float-storage field. The field is restored in double, as it is resampled onto the tracing bundle.
+  IGL_INLINE void streamlines_init(const directional::FloatCartesianField& field,
+                                   const Eigen::VectorXi& seedLocations,
+                                   const double distRatio,
+                                   StreamlineData &data,
+                                   StreamlineState &state,
+                                   const int maxSegments=0);
+
+
+  // The function computes the next state for each point in the sample. The slots of the segments it creates or extends are listed
+  // in state.changedSegments, which is reset at every call, so that it never holds more than segCapacity slots.
   //   data          struct containing topology information
   //   state         struct containing the state of the tracing
   IGL_INLINE void streamlines_next(const StreamlineData & data,
                                    StreamlineState & state,
                                    const double dTime);
+
+
+  // Precomputes, in parallel, per-face exit tables of the field: where a streamline along each vector exits the face, and with which direction
+  // it continues in the next face. Tracing then amounts to table lookups. Should be called after streamlines_init() (which clears the tables).
+  //   data          struct containing topology information, to which the tables are added
+  IGL_INLINE void streamlines_precompute_exits(StreamlineData &data);
+
+
+  // Traces all streamlines from the seeds in data to completion, without animation. A streamline stops when it leaves the mesh,
+  // stalls, or reaches maxTime or maxSegments. Streamlines are traced in parallel, and faster with precomputed exit tables.
+  // Input:
+  //   data          struct containing topology information
+  //   maxTime       the maximum tracing time (in the units of the field magnitudes)
+  //   maxSegments   the maximum number of segments (faces) per streamline
+  // Output:
+  //   P1, P2          #segments by 3 traced segment endpoints, ordered by streamline
+  //   segStreamlines  #segments the streamline of each segment, which is j*#seeds+i for vector j from seed i (as in StreamlineState)
+  //   segFaces        #segments the face of each segment
+  IGL_INLINE void streamlines_trace(const StreamlineData &data,
+                                    const double maxTime,
+                                    const int maxSegments,
+                                    Eigen::MatrixXd& P1,
+                                    Eigen::MatrixXd& P2,
+                                    Eigen::VectorXi& segStreamlines,
+                                    Eigen::VectorXi& segFaces);
 }
 
 #include "streamlines.cpp"
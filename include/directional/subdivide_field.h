@@ -6,11 +6,15 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 #ifndef DIRECTIONAL_SUBDIVIDE_FIELD_H
 #define DIRECTIONAL_SUBDIVIDE_FIELD_H
+#include <functional>
+#include <vector>
+#include <map>
 #include <Eigen/Eigen>
 #include <directional/TriMesh.h>
 #include <directional/IntrinsicFaceTangentBundle.h>
 #include <directional/CartesianField.h>
 #include <directional/SubdivisionInternal/build_directional_subdivision_operators.h>
+#include <directional/SubdivisionInternal/build_subdivision_topology.h>
 #include <directional/SubdivisionInternal/shm_edge_topology.h>
 #include <directional/SubdivisionInternal/shm_halfcurl_coefficients.h>
 #include <directional/SubdivisionInternal/shm_oneform_coefficients.h>
@@ -25,6 +29,295 @@
 
 namespace directional
 {
+    // Called by the matrix-free subdivision with every subdivided level (1 to the target level): the level index, its vertices,
+    // its connectivity, its raw field and its matching.
+    typedef std::function<void(int, const Eigen::MatrixXd&, const SubdivisionLevel&, const Eigen::MatrixXd&, const Eigen::VectorXi&)> SubdivisionLevelCallback;
+
+    // The same for the matrix-free subdivision of several fields, called with every subdivided level for every field. The second argument
+    // is the index of the field.
+    typedef std::function<void(int, int, const Eigen::MatrixXd&, const SubdivisionLevel&, const Eigen::MatrixXd&, const Eigen::VectorXi&)> SubdivisionFieldsLevelCallback;
+
+    /**
+     * Reprojects per-directional Gamma2 elements to a raw field with the (single-directional) reprojector of the level. The
+     * reprojection is the same for all directionals: it is applied per block instead of forming the block diagonal.
+     */
+    inline void subdivision_gamma2_to_rawfield(const Eigen::SparseMatrix<double>& Gamma2_To_PCVF,
+                                               int N,
+                                               const Eigen::VectorXd& gamma2,
+                                               Eigen::MatrixXd& rawField)
+    {
+        Eigen::VectorXd columnDirectional(N * Gamma2_To_PCVF.rows());
+        for (int n = 0; n < N; n++)
+            columnDirectional.segment(n * Gamma2_To_PCVF.rows(), Gamma2_To_PCVF.rows()) = Gamma2_To_PCVF * gamma2.segment(n * Gamma2_To_PCVF.cols(), Gamma2_To_PCVF.cols());
+        columndirectional_to_rawfield(columnDirectional, N, rawField);
+    }
+
+    /**
+     * Reconstructs the raw fields of a group of fields with the same N and matching on a subdivision level, from their decompositions
+     * into (per-directional) one-form and half-curl parts, given as columns. The field of column c is written to rawFields[group[c]].
+     */
+    inline void subdivision_decomposition_to_rawfields(const SubdivisionLevel& level,
+                                                       const Eigen::SparseMatrix<double>& Gamma2_To_PCVF,
+                                                       const Eigen::VectorXi& matching,
+                                                       int N,
+                                                       const Eigen::MatrixXd& oneForm,
+                                                       const Eigen::MatrixXd& halfCurl,
+                                                       const std::vector<int>& group,
+                                                       std::vector<Eigen::MatrixXd>& rawFields)
+    {
+        Eigen::SparseMatrix<double> Decomp_To_G2;
+        directional::Matched_AC_To_Gamma2(level.EF, level.SFE, level.EI, matching, N, Decomp_To_G2);
+        Eigen::MatrixXd decomposition(oneForm.rows() + halfCurl.rows(), group.size());
+        decomposition << oneForm, halfCurl;
+        Eigen::MatrixXd gamma2 = Decomp_To_G2 * decomposition;
+        for (int c = 0; c < group.size(); c++)
+            subdivision_gamma2_to_rawfield(Gamma2_To_PCVF, N, gamma2.col(c), rawFields[group[c]]);
+    }
+
+    /**
+     * Subdivides several raw fields on the same coarse mesh in one pass, walking the subdivision levels (see SubdivisionLevelWalker).
+     * The operators of every level are built, applied (or composed), and discarded before moving to the next level. The vertex subdivision
+     * and all the geometric operators are built once for all fields, and fields that share their degree and matching are subdivided
+     * together as the columns of a single application of their operators. The directional operators are only built once per distinct
+     * (N, matching). This is the pipeline behind all versions of subdivide_field().
+     * Input:
+     * - V |V| x 3 matrix of vertex coordinates
+     * - levels The levels of the subdivision, at the coarse level. They are walked to the target level, whose connectivity is
+     * levels.current() on return.
+     * - rawFields the coarse fields, each an |F| x (3 * N_i) raw field
+     * - matchings the coarse matching of each field (see subdivide_field())
+     * Output:
+     * - V_fine |V_fine| x 3 matrix of fine mesh vertex coordinates.
+     * - rawFields_fine the fine level raw field of each field
+     * - matchings_fine the fine matching of each field
+     * - matrixFree if to apply the level operators one after the other instead of forming their products (see subdivide_field_matrix_free())
+     * - levelCallback in the matrix-free version, optionally called with every subdivided level of every field (see subdivide_field_matrix_free())
+     */
+    inline void subdivide_fields(const Eigen::MatrixXd& V,
+                                 SubdivisionLevelWalker& levels,
+                                 const std::vector<Eigen::MatrixXd>& rawFields,
+                                 const std::vector<Eigen::VectorXi>& matchings,
+                                 Eigen::MatrixXd& V_fine,
+                                 std::vector<Eigen::MatrixXd>& rawFields_fine,
+                                 std::vector<Eigen::VectorXi>& matchings_fine,
+                                 const bool matrixFree = false,
+                                 const SubdivisionFieldsLevelCallback& levelCallback = SubdivisionFieldsLevelCallback())
+    {
+        assert(rawFields.size() == matchings.size() && "subdivide_fields(): every field needs a matching");
+        assert(levels.index() == 0 && "subdivide_fields(): the levels should start at the coarse level");
+        const SubdivisionLevel& coarse = levels.current();
+        for (int i = 0; i < rawFields.size(); i++)
+            assert(rawFields[i].rows() == coarse.F.rows() && matchings[i].size() == coarse.E.rows() && "subdivide_fields(): all fields should be on the coarse mesh of the topology");
+        using coeffProv = coefficient_provider_t;
+
+        auto Sv_provider = triplet_provider_wrapper<coeffProv>(subdivision::loop_coefficients, subdivision::Sv_triplet_provider<coeffProv>);
+        auto Sc_directional_provider = directional_triplet_provider_wrapper<coeffProv>(subdivision::shm_halfcurl_coefficients, subdivision::Sc_directional_triplet_provider<coeffProv>);
+        auto Se_directional_provider = directional_triplet_provider_wrapper<coeffProv>(subdivision::shm_oneform_coefficients, subdivision::Se_directional_triplet_provider<coeffProv>);
+
+        // The (single-directional) coarse projector only depends on the geometry
+        Eigen::SparseMatrix<double> Gamma2_projector_0;
+        directional::Gamma2_projector(V, coarse.F, coarse.E, coarse.SFE, coarse.EF, Gamma2_projector_0);
+
+        // Grouping the fields by (N, matching)
+        std::vector<std::vector<int>> groups;
+        for (int i = 0; i < rawFields.size(); i++)
+        {
+            int g = 0;
+            for (; g < groups.size(); g++)
+            {
+                const int first = groups[g][0];
+                if ((rawFields[first].cols() == rawFields[i].cols()) && (matchings[first].size() == matchings[i].size()) && (matchings[first] == matchings[i]))
+                    break;
+            }
+            if (g == groups.size())
+                groups.push_back(std::vector<int>());
+            groups[g].push_back(i);
+        }
+
+        // Decompose all fields of every group as columns
+        std::vector<int> groupN(groups.size());
+        std::vector<Eigen::MatrixXd> oneForms(groups.size()), halfCurls(groups.size());
+        std::vector<Eigen::VectorXi> groupMatchings(groups.size());              // the matching of every group at the current level
+        std::vector<std::vector<int>> groupSizes(groups.size());                 // the sizes of the one-form and half-curl parts at the current level
+        std::vector<std::vector<Eigen::SparseMatrix<double>>> groupOperators(groups.size());  // the products of the level operators, if not matrix-free
+        for (int g = 0; g < groups.size(); g++)
+        {
+            const std::vector<int>& group = groups[g];
+            const int N = groupN[g] = rawFields[group[0]].cols() / 3;
+            groupMatchings[g] = matchings[group[0]];
+            groupSizes[g] = std::vector<int>({ (int)(N * coarse.E.rows()), (int)(N * coarse.E.rows()) });
+
+            Eigen::SparseMatrix<double> G2_To_Decomp_0;
+            directional::Matched_Gamma2_To_AC(coarse.EI, coarse.EF, coarse.SFE, groupMatchings[g], N, G2_To_Decomp_0);
+            Eigen::MatrixXd gamma2(N * Gamma2_projector_0.rows(), group.size());
+            for (int c = 0; c < group.size(); c++)
+            {
+                Eigen::VectorXd columnDirectional;
+                rawfield_to_columndirectional(rawFields[group[c]], N, columnDirectional);
+                for (int n = 0; n < N; n++)
+                    gamma2.col(c).segment(n * Gamma2_projector_0.rows(), Gamma2_projector_0.rows()) = Gamma2_projector_0 * columnDirectional.segment(n * Gamma2_projector_0.cols(), Gamma2_projector_0.cols());
+            }
+            Eigen::MatrixXd decomposition = G2_To_Decomp_0 * gamma2;
+            oneForms[g] = decomposition.topRows(groupSizes[g][0]);
+            halfCurls[g] = decomposition.bottomRows(groupSizes[g][1]);
+
+            if (!matrixFree)
+            {
+                // Initialize the products to identity matrices (see compose_level_operators())
+                for (int j = 0; j < 2; j++)
+                {
+                    groupOperators[g].emplace_back(groupSizes[g][j], groupSizes[g][j]);
+                    groupOperators[g].back().setIdentity();
+                }
+            }
+        }
+
+        // Subdivide level by level: the operators of a level are built and used before moving on
+        rawFields_fine.resize(rawFields.size());
+        matchings_fine.resize(rawFields.size());
+        V_fine = V;
+        std::vector<int> vertexSizes({ (int)V.rows() });
+        while (!levels.done())
+        {
+            const SubdivisionLevel& level = levels.current();
+            {
+                std::vector<Eigen::SparseMatrix<double>> svOut;
+                build_subdivision_level_operator(level, vertexSizes, svOut, Sv_provider);
+                V_fine = svOut[0] * V_fine;
+            }
+            for (int g = 0; g < groups.size(); g++)
+            {
+                std::vector<Eigen::SparseMatrix<double>> out;
+                Eigen::VectorXi nextMatching;
+                build_directional_subdivision_level_operator(level, levels.next().E.rows(), groupMatchings[g], groupSizes[g], groupN[g], nextMatching, out, Se_directional_provider, Sc_directional_provider);
+                groupMatchings[g] = nextMatching;
+                if (matrixFree)
+                {
+                    oneForms[g] = out[0] * oneForms[g];
+                    halfCurls[g] = out[1] * halfCurls[g];
+                }
+                else
+                {
+                    groupOperators[g][0] = out[0] * groupOperators[g][0];
+                    groupOperators[g][1] = out[1] * groupOperators[g][1];
+                }
+            }
+            levels.advance();
+
+            if ((matrixFree) && (levelCallback) && (!levels.done()))
+            {
+                const SubdivisionLevel& nextLevel = levels.current();
+                Eigen::SparseMatrix<double> Gamma2_To_PCVF;
+                directional::Gamma2_reprojector(V_fine, nextLevel.F, nextLevel.E, nextLevel.SFE, nextLevel.EF, Gamma2_To_PCVF);
+                for (int g = 0; g < groups.size(); g++)
+                {
+                    subdivision_decomposition_to_rawfields(nextLevel, Gamma2_To_PCVF, groupMatchings[g], groupN[g], oneForms[g], halfCurls[g], groups[g], rawFields_fine);
+                    for (int c = 0; c < groups[g].size(); c++)
+                        levelCallback(levels.index(), groups[g][c], V_fine, nextLevel, rawFields_fine[groups[g][c]], groupMatchings[g]);
+                }
+            }
+        }
+
+        // Reconstruct every field on the fine level
+        const SubdivisionLevel& fine = levels.current();
+        Eigen::SparseMatrix<double> Gamma2_To_PCVF_K;
+        directional::Gamma2_reprojector(V_fine, fine.F, fine.E, fine.SFE, fine.EF, Gamma2_To_PCVF_K);
+        for (int g = 0; g < groups.size(); g++)
+        {
+            if (!matrixFree)
+            {
+                oneForms[g] = groupOperators[g][0] * oneForms[g];
+                halfCurls[g] = groupOperators[g][1] * halfCurls[g];
+            }
+            subdivision_decomposition_to_rawfields(fine, Gamma2_To_PCVF_K, groupMatchings[g], groupN[g], oneForms[g], halfCurls[g], groups[g], rawFields_fine);
+            for (int c = 0; c < groups[g].size(); c++)
+                matchings_fine[groups[g][c]] = groupMatchings[g];
+        }
+        if ((matrixFree) && (levelCallback) && (levels.target() > 0))
+            for (int i = 0; i < rawFields.size(); i++)
+                levelCallback(levels.target(), i, V_fine, fine, rawFields_fine[i], matchings_fine[i]);
+    }
+
+    /**
+     * The same on a precomputed topology (see build_subdivision_topology()), which only depends on the coarse mesh, and can be shared
+     * by any number of fields on it. The fine connectivity is topology.fine().
+     */
+    inline void subdivide_fields(const Eigen::MatrixXd& V,
+                                 const SubdivisionTopology& topology,
+                                 const std::vector<Eigen::MatrixXd>& rawFields,
+                                 const std::vector<Eigen::VectorXi>& matchings,
+                                 Eigen::MatrixXd& V_fine,
+                                 std::vector<Eigen::MatrixXd>& rawFields_fine,
+                                 std::vector<Eigen::VectorXi>& matchings_fine,
+                                 const bool matrixFree = false,
+                                 const SubdivisionFieldsLevelCallback& levelCallback = SubdivisionFieldsLevelCallback())
+    {
+        SubdivisionLevelWalker levels(topology);
+        subdivide_fields(V, levels, rawFields, matchings, V_fine, rawFields_fine, matchings_fine, matrixFree, levelCallback);
+    }
+
+    /**
+     * The matrix-free version of subdivide_field() on a precomputed topology: the operators of every level are built, applied to the
+     * data, and discarded one after the other, and the coarse-to-fine products are never formed. Their memory grows with the level much
+     * faster than that of the data, so this is the version to use for deep subdivision. For the deepest levels, the topology itself
+     * need not be precomputed either (see the subdivide_field() overload on the coarse connectivity, which only keeps two levels alive).
+     * Optionally, every intermediate level is reconstructed and passed to levelCallback (e.g., to stream it to disk), which costs
+     * one reprojection per level.
+     */
+    inline void subdivide_field_matrix_free(const Eigen::MatrixXd& V,
+                                            const SubdivisionTopology& topology,
+                                            const Eigen::MatrixXd& rawField,
+                                            const Eigen::VectorXi& matching,
+                                            Eigen::MatrixXd& V_fine,
+                                            Eigen::MatrixXd& rawField_fine,
+                                            Eigen::VectorXi& matching_fine,
+                                            const SubdivisionLevelCallback& levelCallback = SubdivisionLevelCallback())
+    {
+        SubdivisionFieldsLevelCallback fieldsCallback;
+        if (levelCallback)
+            fieldsCallback = [&levelCallback](int level, int, const Eigen::MatrixXd& VLevel, const SubdivisionLevel& connectivity, const Eigen::MatrixXd& levelRawField, const Eigen::VectorXi& levelMatching)
+            {
+                levelCallback(level, VLevel, connectivity, levelRawField, levelMatching);
+            };
+        std::vector<Eigen::MatrixXd> rawFields_fine;
+        std::vector<Eigen::VectorXi> matchings_fine;
+        subdivide_fields(V, topology, std::vector<Eigen::MatrixXd>(1, rawField), std::vector<Eigen::VectorXi>(1, matching), V_fine, rawFields_fine, matchings_fine, true, fieldsCallback);
+        rawField_fine = rawFields_fine[0];
+        matching_fine = matchings_fine[0];
+    }
+
+    /**
+     * Subdivides a raw field directional on a coarse mesh to a raw field directional in the target level of a precomputed subdivision
+     * topology (see build_subdivision_topology()). The topology only depends on the coarse mesh, and can be reused to subdivide
+     * any number of fields on it. Assumes a matching is given, this matching will be fixed during subdivision.
+     * Input:
+     * - V |V| x 3 matrix of vertex coordinates
+     * - topology The subdivision topology of the coarse mesh, whose target level is the output level
+     * - rawField |F| x (3 * N) matrix containing the N-directional raw field representation
+     * - matching |E| x 1 vector describing the directional matching over edge e such that directional k in face EF(e,0) matches to
+     * directional (matching(e)+k)% N in face EF(e,1).
+     * Output:
+     * - V_fine |V_fine| x 3 matrix of fine mesh vertex coordinates. The fine connectivity is topology.fine().
+     * - rawField_fine |F_fine| x (3 * N) matrix containing the fine level N-directional raw field
+     * - matching_fine |E_fine| x 1 vector containing the fine matching.
+     * - matrixFree if to apply the level operators one after the other instead of forming their products (see subdivide_field_matrix_free())
+     */
+    inline void subdivide_field(const Eigen::MatrixXd& V,
+                                const SubdivisionTopology& topology,
+                                const Eigen::MatrixXd& rawField,
+                                const Eigen::VectorXi& matching,
+                                Eigen::MatrixXd& V_fine,
+                                Eigen::MatrixXd& rawField_fine,
+                                Eigen::VectorXi& matching_fine,
+                                const bool matrixFree = false)
+    {
+        std::vector<Eigen::MatrixXd> rawFields_fine;
+        std::vector<Eigen::VectorXi> matchings_fine;
+        subdivide_fields(V, topology, std::vector<Eigen::MatrixXd>(1, rawField), std::vector<Eigen::VectorXi>(1, matching), V_fine, rawFields_fine, matchings_fine, matrixFree);
+        rawField_fine = rawFields_fine[0];
+        matching_fine = matchings_fine[0];
+    }
+
     /**
      * Subdivides a raw field directional on a coarse mesh defined by V,F to a raw field directional in subdivision level 'targetLevel',
      * on the mesh as given by output V_fine, F_fine. Assumes a matching is given, this matching will be fixed during subdivision.
@@ -44,6 +337,7 @@ namespace directional
      * - EF_fine |E| x  2 matrix of edge to face connectivity fine mesh.
      * - rawField_fine |F_fine| x (3 * N) matrix containing the fine level N-directional raw field
      * - matching_fine |E_fine| x 1 vector containing the fine matching.
+     * - matrixFree if to apply the level operators one after the other instead of forming their products (see subdivide_field_matrix_free())
      */
     inline void subdivide_field(const Eigen::MatrixXd& V,
                                 const Eigen::MatrixXi& F,
@@ -57,57 +351,81 @@ namespace directional
                                 Eigen::MatrixXi& EV_fine,
                                 Eigen::MatrixXi& EF_fine,
                                 Eigen::MatrixXd& rawField_fine,
-                                Eigen::VectorXi& matching_fine)
+                                Eigen::VectorXi& matching_fine,
+                                const bool matrixFree = false)
     {
-        Eigen::MatrixXi EI, SFE, EI_fine, SFE_fine;
+        Eigen::MatrixXi EI, SFE;
         shm_edge_topology(F, EV, EF, EI,SFE);
-        const int N = rawField.cols() / 3;
-        std::vector<int> initialSizes = std::vector<int>({ (int)(N * EV.rows()), (int)(N * EV.rows()) });
-        std::vector<Eigen::SparseMatrix<double>> out, svOut;
-        using coeffProv = coefficient_provider_t;
+        SubdivisionLevelWalker levels(V.rows(), F, EV, EF, EI, SFE, targetLevel);
+        std::vector<Eigen::MatrixXd> rawFields_fine;
+        std::vector<Eigen::VectorXi> matchings_fine;
+        subdivide_fields(V, levels, std::vector<Eigen::MatrixXd>(1, rawField), std::vector<Eigen::VectorXi>(1, matching), V_fine, rawFields_fine, matchings_fine, matrixFree);
+        rawField_fine = rawFields_fine[0];
+        matching_fine = matchings_fine[0];
+        F_fine = levels.current().F;
+        EV_fine = levels.current().E;
+        EF_fine = levels.current().EF;
+    }
 
-        auto Sv_provider = triplet_provider_wrapper<coeffProv>(subdivision::loop_coefficients, subdivision::Sv_triplet_provider<coeffProv>);
-        auto Sc_directional_provider = directional_triplet_provider_wrapper<coeffProv>(subdivision::shm_halfcurl_coefficients, subdivision::Sc_directional_triplet_provider<coeffProv>);
-        auto Se_directional_provider = directional_triplet_provider_wrapper<coeffProv>(subdivision::shm_oneform_coefficients, subdivision::Se_directional_triplet_provider<coeffProv>);
-        build_directional_subdivision_operators(V, F, EV, EF, EI, SFE, matching, initialSizes, targetLevel, N,
-                                                F_fine, EV_fine, EF_fine, EI_fine, SFE_fine, matching_fine, out, Se_directional_provider, Sc_directional_provider);
-
-        // Construct regular vertex subdivision
-        build_subdivision_operators(V, F, EV, EF, EI, SFE, std::vector<int>({(int)V.rows()}), targetLevel,
-                                    F_fine, EV_fine, EF_fine, EI_fine, SFE_fine, svOut, Sv_provider);
-
-        // Get fine level vertices
-        V_fine = svOut[0] * V;
-
-        Eigen::SparseMatrix<double> G2_To_Decomp_0, Gamma2_To_PCVF_K, Matched_Gamma2_To_PCVF_K, S_Gamma_directional, S_Decomp, Decomp_To_G2K, columnDirectional_To_G2;
-        // Construct fine gamma operator
-        directional::Matched_Gamma2_To_AC(EI, EF, SFE, matching, N, G2_To_Decomp_0);
-        directional::Matched_AC_To_Gamma2(EF_fine, SFE_fine, EI_fine, matching_fine, N, Decomp_To_G2K);
-        directional::Gamma2_reprojector(V_fine, F_fine, EV_fine, SFE_fine, EF_fine, Gamma2_To_PCVF_K);
-        // Construct the full reprojection for all directionals. Since gammas are face local,
-        // the matching is not needed
+    /**
+     * Subdivides several raw fields on the same coarse mesh to the fine fields in subdivision level 'targetLevel', with curl precision,
+     * as in "Subdivision Directional Fields" by [Custers and Vaxman 2020]. The subdivision topology and operators that do not depend
+     * on the fields are built once for all of them (see subdivide_fields() above).
+     * Input:
+     * - rawFieldsCoarse:   the coarse fields as cartesian RAW_FIELD field objects, all on the same mesh (and possibly of different N)
+     * - targetLevel The target subdivision level (0 is the coarse level)
+     * Output:
+     * - meshFine: the subdivided mesh
+     * - ftbFine: the face tangent bundle of meshFine
+     * - rawFieldsFine: the subdivided fields, in the order of rawFieldsCoarse
+     */
+    inline void subdivide_fields(const std::vector<const directional::CartesianField*>& rawFieldsCoarse,
+                                 int targetLevel,
+                                 directional::TriMesh& meshFine,
+                                 directional::IntrinsicFaceTangentBundle& ftbFine,
+                                 std::vector<directional::CartesianField>& rawFieldsFine)
+    {
+        assert(!rawFieldsCoarse.empty() && "subdivide_fields(): no fields to subdivide");
+        // Compute internal edge topology
+        Eigen::MatrixXi EVCoarse, EFCoarse, EI, SFE, EI_et, FE_et;
+        const directional::IntrinsicFaceTangentBundle* ftbCoarse = (IntrinsicFaceTangentBundle*)(rawFieldsCoarse[0]->tb);
+        for (int i = 1; i < rawFieldsCoarse.size(); i++)
+            assert(rawFieldsCoarse[i]->tb == ftbCoarse && ((IntrinsicFaceTangentBundle*)(rawFieldsCoarse[i]->tb))->mesh == ftbCoarse->mesh && "subdivide_fields(): all fields should share one mesh and tangent bundle");
+        shm_edge_topology(ftbCoarse->mesh->F, ftbCoarse->mesh->V.rows(), EVCoarse, EFCoarse, EI, SFE);
+        shm_edge_topology_to_igledgetopology(ftbCoarse->mesh->F, EVCoarse, EFCoarse, SFE, EI_et, FE_et);
+        directional::TriMesh coarseMesh(*(ftbCoarse->mesh));
+        coarseMesh.set_mesh(coarseMesh.V,coarseMesh.F,  EVCoarse, FE_et, EFCoarse);
+        directional::IntrinsicFaceTangentBundle ftbCoarseAltered;
+        ftbCoarseAltered.init(coarseMesh);
+
+        // Compute the curl matching of every field on the altered edge topology
+        std::vector<Eigen::MatrixXd> extFields(rawFieldsCoarse.size());
+        std::vector<Eigen::VectorXi> matchings(rawFieldsCoarse.size());
+        for (int i = 0; i < rawFieldsCoarse.size(); i++)
         {
-            std::vector<Eigen::SparseMatrix<double>*> base(N, &Gamma2_To_PCVF_K);
-            directional::block_diag(base, Matched_Gamma2_To_PCVF_K);
+            directional::CartesianField coarseFieldAltered;
+            coarseFieldAltered.init(ftbCoarseAltered, directional::fieldTypeEnum::RAW_FIELD, rawFieldsCoarse[i]->N);
+            coarseFieldAltered.set_extrinsic_field(rawFieldsCoarse[i]->extField);
+            Eigen::VectorXd curlNorm;
+            directional::curl_matching(coarseFieldAltered, curlNorm);
+            extFields[i] = coarseFieldAltered.extField;
+            matchings[i] = coarseFieldAltered.matching;
         }
 
-        directional::block_diag({ &out[0],&out[1] }, S_Decomp);
+        SubdivisionLevelWalker levels(coarseMesh.V.rows(), coarseMesh.F, EVCoarse, EFCoarse, EI, SFE, targetLevel);
+        Eigen::MatrixXd VFine;
+        std::vector<Eigen::MatrixXd> extFieldsFine;
+        std::vector<Eigen::VectorXi> matchingsFine;
+        subdivide_fields(coarseMesh.V, levels, extFields, matchings, VFine, extFieldsFine, matchingsFine);
 
-        Eigen::VectorXd columnDirectional, fineDirectional;
-
-        // Convert rawfield to column directional for applying subdivision
-        rawfield_to_columndirectional(rawField, N, columnDirectional);
-        // Get matrix to convert column directional to gamma2 elements
-        directional::columndirectional_to_gamma2_matrix(V, F, EV, SFE, EF, N, columnDirectional_To_G2);
-
-        // The directional gamma subdivision operator
-        S_Gamma_directional = Decomp_To_G2K * S_Decomp*G2_To_Decomp_0;
-
-        // Compute the fine directional
-        fineDirectional = Matched_Gamma2_To_PCVF_K * S_Gamma_directional * columnDirectional_To_G2 * columnDirectional;
-
-        // Convert resulting column directional in fine level back to rawfield format
-        columndirectional_to_rawfield(fineDirectional, N, rawField_fine);
+        meshFine.set_mesh(VFine, levels.current().F);
+        ftbFine.init(meshFine);
+        rawFieldsFine.resize(rawFieldsCoarse.size());
+        for (int i = 0; i < rawFieldsCoarse.size(); i++)
+        {
+            rawFieldsFine[i].init(ftbFine, directional::fieldTypeEnum::RAW_FIELD, rawFieldsCoarse[i]->N);
+            rawFieldsFine[i].set_extrinsic_field(extFieldsFine[i]);
+        }
     }
 
     /**
@@ -127,36 +445,10 @@ namespace directional
                                 directional::IntrinsicFaceTangentBundle& ftbFine,
                                 directional::CartesianField& rawFieldFine)
     {
-        // Compute internal edge topology
-        Eigen::MatrixXi EVCoarse, EFCoarse, EI, SFE, EI_et, FE_et, EI_fine, SFEFine, EVFine, EFFine;
-        const directional::IntrinsicFaceTangentBundle* ftbCoarse = (IntrinsicFaceTangentBundle*)(rawFieldCoarse.tb);
-        shm_edge_topology(ftbCoarse->mesh->F, ftbCoarse->mesh->V.rows(), EVCoarse, EFCoarse, EI, SFE);
-        shm_edge_topology_to_igledgetopology(ftbCoarse->mesh->F, EVCoarse, EFCoarse, SFE, EI_et, FE_et);
-        directional::TriMesh coarseMesh(*(ftbCoarse->mesh));
-        coarseMesh.set_mesh(coarseMesh.V,coarseMesh.F,  EVCoarse, FE_et, EFCoarse);
-        directional::CartesianField coarseFieldAltered;
-        directional::IntrinsicFaceTangentBundle ftbCoarseAltered;
-        ftbCoarseAltered.init(coarseMesh);
-        coarseFieldAltered.init(ftbCoarseAltered, directional::fieldTypeEnum::RAW_FIELD, rawFieldCoarse.N);
-        coarseFieldAltered.set_extrinsic_field(rawFieldCoarse.extField);
-        // Compute curl matching
-        //Eigen::VectorXi matchingCoarse, matchingFine, singVertices, singIndices;
-
-        Eigen::VectorXd curlNorm;
-        directional::curl_matching(coarseFieldAltered, curlNorm);
-
-
-        std::cout<<"coarseFieldAltered.matching: "<<coarseFieldAltered.matching<<std::endl;
-
-        Eigen::MatrixXd VFine, extFieldFine;
-        Eigen::MatrixXi FFine;
-        Eigen::VectorXi matchingFine;
-
-        subdivide_field(coarseMesh.V, coarseMesh.F, coarseMesh.EV, coarseMesh.EF, coarseFieldAltered.extField, coarseFieldAltered.matching, targetLevel, VFine, FFine, EVFine, EFFine, extFieldFine, matchingFine);
-        meshFine.set_mesh(VFine, FFine);
-        ftbFine.init(meshFine);
+        std::vector<directional::CartesianField> rawFieldsFine;
+        subdivide_fields(std::vector<const directional::CartesianField*>(1, &rawFieldCoarse), targetLevel, meshFine, ftbFine, rawFieldsFine);
         rawFieldFine.init(ftbFine, directional::fieldTypeEnum::RAW_FIELD, rawFieldCoarse.N);
-        rawFieldFine.set_extrinsic_field(extFieldFine);
+        rawFieldFine.set_extrinsic_field(rawFieldsFine[0].extField);
     }
 
 }
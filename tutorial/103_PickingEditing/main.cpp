@@ -78,7 +78,8 @@ bool mouse_down(igl::opengl::glfw::Viewer& iglViewer, int button, int modifiers)
                                   mesh.V.row(mesh.F(fid, 2)) * baryInFace(2) - mesh.barycenters.row(fid)).normalized();
       
       field.extField.block(currF, currVec*3, 1,3)=newVec;
-      directionalViewer->set_field(field);
+      Eigen::VectorXi changedFaces(1); changedFaces(0)=currF;
+      directionalViewer->update_field(changedFaces);
       directionalViewer->set_selected_vector(currF, currVec);
       return true;
       
@@ -77,8 +77,10 @@ int main()
   directional::principal_matching(rawField);
 
   directional::IntegrationData intData(N);
+  //The cut and seam topology only depend on the singularities and matching, and are reused by the second setup
+  directional::IntegrationSetupCache setupCache;
   std::cout<<"Setting up Integration"<<std::endl;
-  directional::setup_integration(rawField, intData,meshCut, combedField);
+  directional::setup_integration(rawField, intData,meshCut, combedField, setupCache);
   
   intData.verbose=false;
   intData.integralSeamless=true;
@@ -90,7 +92,7 @@ int main()
   
   std::cout<<"Solving triangular-constrained integration..."<<std::endl;
   intData.set_triangular_symmetry(N);
-  directional::setup_integration(rawField,intData, meshCut, combedField);
+  directional::setup_integration(rawField,intData, meshCut, combedField, setupCache);
   directional::integrate(combedField,  intData, meshCut, NFunctionTri, NCornerFunc);
   std::cout<<"Done!"<<std::endl;
   